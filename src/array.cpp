@@ -54,6 +54,9 @@ struct maphash {
 
 # define ABCHUNKSZ	32
 
+# define FTABCHUNKSZ	256	/* frozen array registry chunk */
+# define FT_NONE	((Uint) -1)
+
 struct arrbak {
     Array *arr;			/* array backed up */
     unsigned short size;	/* original size (of mapping) */
@@ -199,6 +202,10 @@ private:
 static unsigned long max_size;	/* max. size of array and mapping */
 static Uint tag;		/* current array tag */
 static arrh *aht[ARRMERGETABSZ];/* array merge table */
+static arrref **ftab;		/* frozen array registry */
+static Uint nfrozen;		/* # frozen array registry slots */
+static Uint ffree;		/* free registry slot list */
+static Dataplane fplane;	/* plane of frozen arrays */
 
 /*
  * NAME:	Array->init()
@@ -208,6 +215,7 @@ void arr_init(unsigned int size)
 {
     max_size = size;
     tag = 0;
+    ffree = FT_NONE;
 }
 
 /*
@@ -221,6 +229,7 @@ Array *arr_alloc(unsigned int size)
     a = achunk.alloc();
     a->size = size;
     a->hashmod = FALSE;
+    a->frozen = FALSE;
     a->elts = (Value *) NULL;
     a->ref = 0;
     a->odcount = 0;			/* if swapped in, check objects */
@@ -325,7 +334,18 @@ void arr_del(Array *a)
 	    }
 
 	    prev = a->prev;
-	    achunk.del(a);
+	    if (a->frozen) {
+		Uint id;
+
+		/* release registry slot */
+		id = a->primary->ref;
+		a->primary->arr = (Array *) NULL;
+		a->primary->ref = ffree;
+		ffree = id;
+		FREE(a);
+	    } else {
+		achunk.del(a);
+	    }
 	    a = prev;
 	} while (a != (Array *) NULL);
 
@@ -352,6 +372,8 @@ void arr_freelist(Array *alist)
 	    for (i = a->size; i > 0; --i) {
 		if (v->type == T_STRING) {
 		    str_del(v->u.string);
+		} else if (T_INDEXED(v->type) && v->u.array->frozen) {
+		    arr_del(v->u.array);
 		}
 		v++;
 	    }
@@ -367,9 +389,15 @@ void arr_freelist(Array *alist)
 		    if (e->add) {
 			if (e->idx.type == T_STRING) {
 			    str_del(e->idx.u.string);
+			} else if (T_INDEXED(e->idx.type) &&
+				   e->idx.u.array->frozen) {
+			    arr_del(e->idx.u.array);
 			}
 			if (e->val.type == T_STRING) {
 			    str_del(e->val.u.string);
+			} else if (T_INDEXED(e->val.type) &&
+				   e->val.u.array->frozen) {
+			    arr_del(e->val.u.array);
 			}
 		    }
 		    n = e->next;
@@ -440,6 +468,289 @@ void arr_clear()
     hchunk.clean();
 }
 
+/*
+ * NAME:	frozen->slot()
+ * DESCRIPTION:	return the registry slot of a frozen array
+ */
+static arrref *frz_slot(Uint id)
+{
+    return &ftab[id / FTABCHUNKSZ][id % FTABCHUNKSZ];
+}
+
+/*
+ * NAME:	frozen->extend()
+ * DESCRIPTION:	add a slot to the frozen array registry
+ */
+static Uint frz_extend()
+{
+    arrref *a;
+    Uint id;
+
+    if (nfrozen % FTABCHUNKSZ == 0) {
+	m_static();
+	ftab = REALLOC(ftab, arrref*, nfrozen / FTABCHUNKSZ,
+		       nfrozen / FTABCHUNKSZ + 1);
+	ftab[nfrozen / FTABCHUNKSZ] = ALLOC(arrref, FTABCHUNKSZ);
+	m_dynamic();
+    }
+    id = nfrozen++;
+    a = frz_slot(id);
+    a->arr = (Array *) NULL;
+    a->plane = &fplane;
+    a->data = (Dataspace *) NULL;
+    a->ref = FT_NONE;
+    return id;
+}
+
+/*
+ * NAME:	frozen->new()
+ * DESCRIPTION:	create a frozen array and enter it in the registry.  Frozen
+ *		arrays are in static memory, since they survive a full
+ *		swapout.
+ */
+static Array *frz_new(Uint id, int type, unsigned int size)
+{
+    Array *a;
+    arrref *slot;
+
+    m_static();
+    a = ALLOC(Array, 1);
+    a->elts = (size != 0) ? ALLOC(Value, size) : (Value *) NULL;
+    m_dynamic();
+    a->size = size;
+    a->hashmod = FALSE;
+    a->ref = 0;
+    a->odcount = odcount;
+    a->hashed = (maphash *) NULL;
+
+    slot = frz_slot(id);
+    slot->arr = a;
+    slot->state = type;
+    slot->ref = id;
+    a->frozen = TRUE;
+    a->primary = slot;
+    a->prev = a->next = a;	/* not in any dataspace */
+    return a;
+}
+
+/*
+ * NAME:	frozen->check()
+ * DESCRIPTION:	check whether the elements of an array can be frozen
+ */
+static bool frz_check(Array *a, int type, Uint *narr, char **state,
+		      Uint *size)
+{
+    Uint i;
+    unsigned short n;
+    Value *v;
+
+    i = arr_put(a, *narr);
+    if (i != *narr) {
+	return ((*state)[i] != 0);	/* cycle if still being checked */
+    }
+    if (i == *size) {
+	*state = REALLOC(*state, char, *size, *size * 2);
+	*size *= 2;
+    }
+    (*state)[(*narr)++] = 0;
+    if (a->frozen) {
+	(*state)[i] = 1;
+	return TRUE;
+    }
+
+    if (type == T_MAPPING && (a->hashmod || a->odcount != odcount)) {
+	map_compact(a->primary->data, a);
+    }
+    for (n = a->size, v = d_get_elts(a); n != 0; --n, v++) {
+	switch (v->type) {
+	case T_OBJECT:
+	    if (!DESTRUCTED(v)) {
+		return FALSE;
+	    }
+	    break;
+
+	case T_LWOBJECT:
+	    return FALSE;
+
+	case T_ARRAY:
+	case T_MAPPING:
+	    if (!frz_check(v->u.array, v->type, narr, state, size)) {
+		return FALSE;
+	    }
+	    break;
+	}
+    }
+    (*state)[i] = 1;
+    return TRUE;
+}
+
+/*
+ * NAME:	frozen->copy()
+ * DESCRIPTION:	make a frozen copy of an array or mapping
+ */
+static Array *frz_copy(Array *a, int type, Uint *narr, Array ***itab,
+		       Uint *size)
+{
+    Uint i, id;
+    unsigned short n;
+    Value *v, *w;
+    Array *copy;
+
+    if (a->frozen) {
+	return a;
+    }
+    i = arr_put(a, *narr);
+    if (i != *narr) {
+	return (*itab)[i];
+    }
+    if (i == *size) {
+	*itab = REALLOC(*itab, Array*, *size, *size * 2);
+	*size *= 2;
+    }
+    (*narr)++;
+
+    if (ffree != FT_NONE) {
+	id = ffree;
+	ffree = frz_slot(id)->ref;
+    } else {
+	id = frz_extend();
+    }
+    copy = frz_new(id, type, a->size);
+    copy->tag = tag++;
+    (*itab)[i] = copy;
+
+    for (n = a->size, v = a->elts, w = copy->elts; n != 0; --n, v++, w++) {
+	switch (v->type) {
+	case T_STRING:
+	    /* strings must be in static memory as well */
+	    m_static();
+	    PUT_STRVAL(w, str_new(v->u.string->text, v->u.string->len));
+	    m_dynamic();
+	    break;
+
+	case T_ARRAY:
+	case T_MAPPING:
+	    *w = *v;
+	    arr_ref(w->u.array = frz_copy(v->u.array, v->type, narr, itab,
+					  size));
+	    break;
+
+	default:
+	    i_copy(w, v, 1);	/* destructed objects become nil */
+	    break;
+	}
+    }
+    if (type == T_MAPPING) {
+	map_sort(copy);		/* new tags may change the order */
+    }
+    return copy;
+}
+
+/*
+ * NAME:	Array->freeze()
+ * DESCRIPTION:	return a frozen copy of an array or mapping, which can be
+ *		shared between objects
+ */
+Array *arr_freeze(Array *a, int type)
+{
+    Uint narr, size;
+    char *state;
+    Array **itab;
+
+    if (a->frozen) {
+	return a;
+    }
+
+    arr_merge();
+    narr = 0;
+    state = ALLOC(char, size = 16);
+    if (!frz_check(a, type, &narr, &state, &size)) {
+	FREE(state);
+	arr_clear();
+	error("Value cannot be frozen");
+    }
+    FREE(state);
+    arr_clear();
+
+    arr_merge();
+    narr = 0;
+    itab = ALLOC(Array*, size = 16);
+    a = frz_copy(a, type, &narr, &itab, &size);
+    FREE(itab);
+    arr_clear();
+
+    return a;
+}
+
+/*
+ * NAME:	Array->thaw()
+ * DESCRIPTION:	return a modifiable copy of a frozen array or mapping
+ */
+Array *arr_thaw(Dataspace *data, Array *a)
+{
+    Array *copy;
+
+    copy = arr_alloc(a->size);
+    if (a->size != 0) {
+	i_copy(copy->elts = ALLOC(Value, a->size), a->elts, a->size);
+    }
+    copy->tag = tag++;
+    copy->odcount = odcount;
+    copy->primary = &data->plane->alocal;
+    copy->prev = &data->alist;
+    copy->next = data->alist.next;
+    copy->next->prev = copy;
+    data->alist.next = copy;
+    return copy;
+}
+
+/*
+ * NAME:	Array->nfrozen()
+ * DESCRIPTION:	return the number of frozen array registry slots
+ */
+Uint arr_nfrozen()
+{
+    return nfrozen;
+}
+
+/*
+ * NAME:	Array->frozen()
+ * DESCRIPTION:	return the frozen array with the given id, if any
+ */
+Array *arr_frozen(Uint id, int *type)
+{
+    arrref *slot;
+
+    slot = frz_slot(id);
+    *type = slot->state;
+    return slot->arr;
+}
+
+/*
+ * NAME:	Array->frozen_id()
+ * DESCRIPTION:	return the registry id of a frozen array
+ */
+Uint arr_frozen_id(Array *a)
+{
+    return a->primary->ref;
+}
+
+/*
+ * NAME:	Array->frozen_restore()
+ * DESCRIPTION:	recreate a frozen array from a snapshot; ids are restored in
+ *		increasing order
+ */
+Array *arr_frozen_restore(Uint id, int type, unsigned int size)
+{
+    Uint i;
+
+    while ((i = frz_extend()) < id) {
+	frz_slot(i)->ref = ffree;
+	ffree = i;
+    }
+    return frz_new(id, type, size);
+}
+
 
 /*
  * NAME:	Array->backup()
@@ -1402,6 +1713,9 @@ void map_rmhash(Array *m)
  */
 void map_compact(Dataspace *data, Array *m)
 {
+    if (m->frozen) {
+	return;		/* always compact */
+    }
     if (m->hashmod || m->odcount != odcount) {
 	if (m->hashmod &&
 	    (!THISPLANE(m->primary) || !SAMEPLANE(data, m->primary->data))) {
@@ -1759,6 +2073,9 @@ Value *map_index(Dataspace *data, Array *m, Value *val, Value *elt,
     mapelt *e, **p;
     bool del, add, hash;
 
+    if (elt != (Value *) NULL && m->frozen) {
+	error("Frozen value cannot be modified");
+    }
     i = 0;
 
     if (elt != (Value *) NULL && VAL_NIL(elt)) {
@@ -1787,8 +2104,7 @@ Value *map_index(Dataspace *data, Array *m, Value *val, Value *elt,
 	break;
 
     case T_STRING:
-	i = Hashtab::hashstr(val->u.string->text, STRMAPHASHSZ) ^
-							    val->u.string->len;
+	i = str_hash(val->u.string);
 	break;
 
     case T_OBJECT:
@@ -1806,16 +2122,14 @@ Value *map_index(Dataspace *data, Array *m, Value *val, Value *elt,
     if (m->hashed != (maphash *) NULL) {
 	for (p = &m->hashed->table[i % m->hashed->tablesize];
 	     (e=*p) != (mapelt *) NULL; p = &e->next) {
-	    if (cmp(val, &e->idx) == 0 &&
+	    if (e->hashval == i && cmp(val, &e->idx) == 0 &&
 		(!T_INDEXED(val->type) || val->u.array == e->idx.u.array)) {
 		/*
 		 * found in the hashtable
 		 */
 		hash = TRUE;
 		if (elt != (Value *) NULL &&
-		    (verify == (Value *) NULL ||
-		     (e->val.type == T_STRING &&
-		      e->val.u.string == verify->u.string))) {
+		    (verify == (Value *) NULL || VAL_SAME(&e->val, verify))) {
 		    /*
 		     * change element
 		     */
@@ -1870,9 +2184,7 @@ Value *map_index(Dataspace *data, Array *m, Value *val, Value *elt,
 	     */
 	    v = &m->elts[n];
 	    if (elt != (Value *) NULL &&
-		(verify == (Value *) NULL ||
-		 (v[1].type == T_STRING && v[1].u.string == verify->u.string)))
-	    {
+		(verify == (Value *) NULL || VAL_SAME(v + 1, verify))) {
 		/*
 		 * change the element
 		 */
@@ -1902,6 +2214,9 @@ Value *map_index(Dataspace *data, Array *m, Value *val, Value *elt,
 		d_change_map(m);
 		return &nil_value;
 	    }
+	    if (m->frozen) {
+		return v + 1;	/* frozen mappings are never hashed */
+	    }
 	    val = v;
 	    elt = v + 1;
 	    add = FALSE;
@@ -1918,7 +2233,15 @@ Value *map_index(Dataspace *data, Array *m, Value *val, Value *elt,
 	 */
 	e = map_grow(data, m, i, add);
 	if (add) {
+	    Value key;
+
 	    e->add = TRUE;
+	    if (val->type == T_STRING) {
+		/* share identical short keys */
+		key = *val;
+		key.u.string = str_pooled(val->u.string);
+		val = &key;
+	    }
 	    d_assign_elt(data, m, &e->idx, val);
 	    d_assign_elt(data, m, &e->val, elt);
 	    m->hashed->sizemod++;
@@ -20,6 +20,7 @@
 struct Array {
     unsigned short size;		/* number of elements */
     bool hashmod;			/* hashed part contains new elements */
+    bool frozen;			/* immutable, shared between objects */
     Uint ref;				/* number of references */
     Uint tag;				/* used in sorting */
     Uint odcount;			/* last destructed object count */
@@ -71,5 +72,12 @@ extern Array	       *map_range	(Dataspace*, Array*, Value*, Value*);
 extern Array	       *map_indices	(Dataspace*, Array*);
 extern Array	       *map_values	(Dataspace*, Array*);
 
+extern Array	       *arr_freeze	(Array*, int);
+extern Array	       *arr_thaw	(Dataspace*, Array*);
+extern Uint		arr_nfrozen	();
+extern Array	       *arr_frozen	(Uint, int*);
+extern Uint		arr_frozen_id	(Array*);
+extern Array	       *arr_frozen_restore (Uint, int, unsigned int);
+
 extern Array	       *lwo_new		(Dataspace*, Object*);
 extern Array	       *lwo_copy	(Dataspace*, Array*);
@@ -26,6 +26,7 @@
 # include "interpret.h"
 # include "data.h"
 # include "call_out.h"
+# include "stats.h"
 
 # define CYCBUF_SIZE	128		/* cyclic buffer size, power of 2 */
 # define CYCBUF_MASK	(CYCBUF_SIZE - 1) /* cyclic buffer mask */
@@ -98,6 +99,66 @@ bool co_init(unsigned int max)
     return TRUE;
 }
 
+/*
+ * NAME:	relocate()
+ * DESCRIPTION:	patch references to callouts in the cyclic buffer, after
+ *		those have been moved offset slots up in the table
+ */
+static void relocate(uindex offset)
+{
+    uindex i, *cb;
+    call_out *co;
+
+    if (flist != 0) {
+	flist += offset;
+    }
+    if (running != 0) {
+	running += offset;
+    }
+    if (immediate != 0) {
+	immediate += offset;
+    }
+    for (i = CYCBUF_SIZE, cb = cycbuf; i > 0; --i, cb++) {
+	if (*cb != 0) {
+	    *cb += offset;
+	}
+    }
+    for (i = cotabsz - cycbrk, co = cotab + cycbrk; i > 0; --i, co++) {
+	if (co->prev != 0) {
+	    co->prev += offset;
+	}
+	if (co->next != 0) {
+	    co->next += offset;
+	}
+    }
+}
+
+/*
+ * NAME:	resize()
+ * DESCRIPTION:	enlarge the callout table to size.  The queue stays at the
+ *		bottom, and callouts in the cyclic buffer move to the top
+ */
+static void resize(uindex size)
+{
+    uindex offset;
+    call_out *tab;
+
+    m_static();
+    tab = ALLOC(call_out, size + 1);
+    m_dynamic();
+    *tab++ = cotab[-1];		/* sentinel for the heap */
+    memcpy(tab, cotab, queuebrk * sizeof(call_out));
+    offset = size - cotabsz;
+    memcpy(tab + cycbrk + offset, cotab + cycbrk,
+	   (cotabsz - cycbrk) * sizeof(call_out));
+    FREE(cotab - 1);
+    cotab = tab;
+
+    cycbrk += offset;
+    cotabsz = size;
+    relocate(offset);
+}
+
 /*
  * NAME:	enqueue()
  * DESCRIPTION:	put a callout in the queue
@@ -350,8 +411,12 @@ Uint co_check(unsigned int n, Int delay, unsigned int mdelay, Uint *tp,
 	return 0;
     }
 
-    if (queuebrk + (uindex) n == cycbrk || cycbrk - (uindex) n == 1) {
-	error("Too many callouts");
+    while (queuebrk + n >= cycbrk || cycbrk <= n + 1) {
+	if (cotabsz == UINDEX_MAX - 1) {
+	    error("Too many callouts");
+	}
+	/* enlarge callout table */
+	resize((cotabsz >= UINDEX_MAX / 2) ? UINDEX_MAX - 1 : cotabsz << 1);
     }
 
     if (delay == 0 && (mdelay == 0 || mdelay == 0xffff)) {
@@ -596,6 +661,7 @@ static void co_expire()
 	    while (queuebrk != 0 && cotab[0].time < timestamp) {
 		handle = cotab[0].handle;
 		oindex = cotab[0].oindex;
+		st_colag((t - cotab[0].time) * 1000 + m - cotab[0].mtime, 1);
 		dequeue(0);
 		co = newcallout(&immediate, 0);
 		co->handle = handle;
@@ -609,6 +675,7 @@ static void co_expire()
 	    i = *cyc;
 	    if (i != 0) {
 		*cyc = 0;
+		st_colag((t - timestamp) * 1000 + m, cotab[i].count);
 		if (immediate == 0) {
 		    immediate = i;
 		} else {
@@ -630,6 +697,7 @@ static void co_expire()
 		(cotab[0].time == t && cotab[0].mtime <= m))) {
 	    handle = cotab[0].handle;
 	    oindex = cotab[0].oindex;
+	    st_colag((t - cotab[0].time) * 1000 + m - cotab[0].mtime, 1);
 	    dequeue(0);
 	    co = newcallout(&immediate, 0);
 	    co->handle = handle;
@@ -687,6 +755,7 @@ void co_call(Frame *f)
 	/*
 	 * callouts to do
 	 */
+	st_start();
 #ifdef CO_THROTTLE
 	while ((i=running) != 0 && (quota-- > 0)) {
 #else
@@ -722,6 +791,15 @@ void co_info(uindex *n1, uindex *n2)
     *n2 = queuebrk;
 }
 
+/*
+ * NAME:	call_out->tabsize()
+ * DESCRIPTION:	return the current size of the callout table
+ */
+uindex co_tabsize()
+{
+    return cotabsz;
+}
+
 /*
  * NAME:	call_out->delay()
  * DESCRIPTION:	return the time until the next timeout
@@ -866,13 +944,15 @@ void co_restore(int fd, Uint t)
     dump_header dh;
     uindex n, i, offset;
     call_out *co;
-    uindex *cb;
     uindex buffer[CYCBUF_SIZE];
 
     /* read and check header */
     timediff = t;
 
     conf_dread(fd, (char *) &dh, dh_layout, (Uint) 1);
+    if (cotabsz != 0 && dh.cotabsz > cotabsz) {
+	resize(dh.cotabsz);
+    }
     queuebrk = dh.queuebrk;
     offset = cotabsz - dh.cotabsz;
     cycbrk = dh.cycbrk + offset;
@@ -908,36 +988,19 @@ void co_restore(int fd, Uint t)
 	   (unsigned int) (CYCBUF_SIZE - t) * sizeof(uindex));
     memcpy(cycbuf, buffer + CYCBUF_SIZE - t, (unsigned int) t * sizeof(uindex));
 
+    if (offset != 0) {
+	/* patch callout references */
+	relocate(offset);
+    }
+
     nzero = 0;
     if (running != 0) {
-	running += offset;
 	nzero += cotab[running].count;
     }
     if (immediate != 0) {
-	immediate += offset;
 	nzero += cotab[immediate].count;
     }
 
-    if (offset != 0) {
-	/* patch callout references */
-	if (flist != 0) {
-	    flist += offset;
-	}
-	for (i = CYCBUF_SIZE, cb = cycbuf; i > 0; --i, cb++) {
-	    if (*cb != 0) {
-		*cb += offset;
-	    }
-	}
-	for (i = cotabsz - cycbrk, co = cotab + cycbrk; i > 0; --i, co++) {
-	    if (co->prev != 0) {
-		co->prev += offset;
-	    }
-	    if (co->next != 0) {
-		co->next += offset;
-	    }
-	}
-    }
-
     /* restart callouts */
     if (nshort != nzero) {
 	for (t = timestamp; cycbuf[t & CYCBUF_MASK] == 0; t++) ;
@@ -28,6 +28,7 @@ extern void	co_del		(unsigned int, unsigned int, Uint,
 extern void	co_list		(Array*);
 extern void	co_call		(Frame*);
 extern void	co_info		(uindex*, uindex*);
+extern uindex	co_tabsize	();
 extern Uint	co_time		(unsigned short*);
 extern Uint	co_delay	(Uint, unsigned int, unsigned short*);
 extern void	co_swapcount	(unsigned int);
@@ -26,6 +26,7 @@
 # include "interpret.h"
 # include "data.h"
 # include "comm.h"
+# include "stats.h"
 # include "version.h"
 # include <errno.h>
 
@@ -48,8 +49,11 @@ struct user {
     connection *conn;		/* connection */
     char *inbuf;		/* input buffer */
     Array *extra;		/* object's extra value */
-    String *outbuf;		/* output buffer string */
-    ssizet inbufsz;		/* bytes in input buffer */
+    String *outbuf;		/* first output buffer chunk */
+    Array *outchunks;		/* output buffer chunk list */
+    Uint inbufsz;		/* bytes in input buffer */
+    Uint inbufmax;		/* size of binary input buffer */
+    Uint inbufscan;		/* bytes searched for a delimiter */
     ssizet osdone;		/* bytes of output string done */
 };
 
@@ -66,6 +70,15 @@ struct user {
 # define CF_OUTPUT	0x0040	/* pending output */
 # define CF_ODONE	0x0080	/* output done */
 # define CF_OPENDING	0x0100	/* waiting for connect() to complete */
+# define CF_FRAMING	0x0600	/* binary input framing: */
+# define  CF_FRAME2	0x0200	/* 2-byte length prefix */
+# define  CF_FRAME4	0x0400	/* 4-byte length prefix */
+# define  CF_FRAMED	0x0600	/* delimiter */
+
+# define CF_DELIM(n)	UCHAR((n) >> 16)	/* delimiter in flags */
+
+/* a framed message of MAX_STRLEN bytes, and its length prefix or delimiter */
+# define FRAMEBUF_SIZE	((Uint) MAX_STRLEN + 4)
 
 #ifdef NETWORK_EXTENSIONS
 # error network extensions are not currently supported
@@ -165,20 +178,66 @@ void comm_listen()
     conn_listen();
 }
 
+/*
+ * NAME:	chunks()
+ * DESCRIPTION:	return the output buffer as a list of string chunks
+ */
+static Value *chunks(Value *v, int *n)
+{
+    switch (v->type) {
+    case T_STRING:
+	*n = 1;
+	return v;
+
+    case T_ARRAY:
+	*n = v->u.array->size;
+	return d_get_elts(v->u.array);
+
+    default:
+	*n = 0;
+	return (Value *) NULL;
+    }
+}
+
 /*
  * NAME:	addtoflush()
  * DESCRIPTION:	add a user to the flush list
  */
 static void addtoflush(user *usr, Array *arr)
 {
+    Value *v;
+
     usr->flags |= CF_FLUSH;
     usr->flush = flush;
     flush = usr;
     arr_ref(usr->extra = arr);
 
     /* remember initial buffer */
-    if (d_get_elts(arr)[1].type == T_STRING) {
-	str_ref(usr->outbuf = arr->elts[1].u.string);
+    v = d_get_elts(arr) + 1;
+    if (v->type == T_STRING) {
+	str_ref(usr->outbuf = v->u.string);
+    } else if (v->type == T_ARRAY) {
+	arr_ref(usr->outchunks = v->u.array);
+	str_ref(usr->outbuf = d_get_elts(v->u.array)->u.string);
+    }
+}
+
+/*
+ * NAME:	newoutput()
+ * DESCRIPTION:	check whether output was added since the user was added to
+ *		the flush list
+ */
+static bool newoutput(user *usr, Value *v)
+{
+    switch (v->type) {
+    case T_STRING:
+	return (v->u.string != usr->outbuf || usr->outchunks != (Array *) NULL);
+
+    case T_ARRAY:
+	return (v->u.array != usr->outchunks);
+
+    default:
+	return FALSE;
     }
 }
 
@@ -214,6 +273,7 @@ static Array *comm_setup(user *usr, Frame *f, Object *obj)
     obj->etabi = usr - users;
     usr->conn = NULL;
     usr->outbuf = (String *) NULL;
+    usr->outchunks = (Array *) NULL;
     usr->osdone = 0;
     usr->flags = 0;
 
@@ -270,6 +330,11 @@ static user *comm_new(Frame *f, Object *obj, connection *conn, int flags)
 	arr->elts[0].u.number = CF_ECHO;
 	PUT_STRVAL_NOREF(&val, str_new(init, (long) sizeof(init)));
 	d_assign_elt(obj->data, arr, &arr->elts[1], &val);
+    } else {
+	usr->state = '\0';
+	usr->newlines = 0;
+	usr->inbuf = (char *) NULL;
+	usr->inbufsz = usr->inbufmax = usr->inbufscan = 0;
     }
     nusers++;
 
@@ -404,9 +469,13 @@ static int comm_write(user *usr, Object *obj, String *str, char *text,
 	unsigned int len)
 {
     Dataspace *data;
-    Array *arr;
-    Value *v;
-    ssizet osdone, olen;
+    Array *arr, *a;
+    Value *v, *c;
+    String *last, *tail;
+    ssizet osdone, done, size, clen;
+    Uint olen;
+    int i, j, n, maxchunks;
+    char *p;
     Value val;
 
     arr = d_get_extravar(data = o_dataspace(obj))->u.array;
@@ -415,10 +484,14 @@ static int comm_write(user *usr, Object *obj, String *str, char *text,
     }
 
     v = arr->elts + 1;
-    if (v->type == T_STRING) {
+    if (v->type == T_STRING || v->type == T_ARRAY) {
 	/* append to existing buffer */
-	osdone = (usr->outbuf == v->u.string) ? usr->osdone : 0;
-	olen = v->u.string->len - osdone;
+	c = chunks(v, &n);
+	osdone = (usr->outbuf == c->u.string) ? usr->osdone : 0;
+	for (olen = 0, i = 0; i < n; i++) {
+	    olen += c[i].u.string->len;
+	}
+	olen -= osdone;
 	if (olen + len > MAX_STRLEN) {
 	    len = MAX_STRLEN - olen;
 	    if (len == 0 ||
@@ -427,9 +500,73 @@ static int comm_write(user *usr, Object *obj, String *str, char *text,
 		return 0;
 	    }
 	}
-	str = str_new((char *) NULL, (long) olen + len);
-	memcpy(str->text, v->u.string->text + osdone, olen);
-	memcpy(str->text + olen, text, len);
+
+	last = c[n - 1].u.string;
+	maxchunks = (conf_array_size() < OUTCHUNKS) ?
+		     conf_array_size() : OUTCHUNKS;
+	if (len == 0 || last->len + len <= OUTCHUNK_SIZE || maxchunks == 1) {
+	    /*
+	     * add to the last chunk
+	     */
+	    done = (n == 1) ? osdone : 0;
+	    str = str_new((char *) NULL, (long) last->len - done + len);
+	    memcpy(str->text, last->text + done, last->len - done);
+	    memcpy(str->text + last->len - done, text, len);
+	    if (n == 1) {
+		PUT_STRVAL_NOREF(&val, str);
+		d_assign_elt(data, arr, v, &val);
+		return len;
+	    }
+	    tail = str;
+	    str = (String *) NULL;
+	    i = n - 1;
+	} else {
+	    /*
+	     * Close the last chunk, merging it with the chunks before it
+	     * while those are less than twice its size.  Chunk sizes then
+	     * double towards the head of the buffer, so the number of
+	     * chunks stays logarithmic and each byte is copied a logarithmic
+	     * number of times.
+	     */
+	    size = last->len - ((n == 1) ? osdone : 0);
+	    for (i = n - 1; i != 0; --i) {
+		done = (i == 1) ? osdone : 0;
+		clen = c[i - 1].u.string->len - done;
+		if (clen >= 2 * size && i < maxchunks - 1) {
+		    break;
+		}
+		size += clen;
+	    }
+	    if (i == n - 1) {
+		tail = last;
+	    } else {
+		tail = str_new((char *) NULL, (long) size);
+		for (p = tail->text, j = i; j < n; j++) {
+		    done = (j == 0) ? osdone : 0;
+		    clen = c[j].u.string->len - done;
+		    memcpy(p, c[j].u.string->text + done, clen);
+		    p += clen;
+		}
+	    }
+	    if (str == (String *) NULL) {
+		/* start a new chunk */
+		str = str_new(text, (long) len);
+	    }
+	}
+
+	/*
+	 * replace the chunk list, so the buffer can be compared with the
+	 * initial one
+	 */
+	a = arr_new(data, (long) i + ((str != (String *) NULL) ? 2 : 1));
+	for (j = 0; j < i; j++) {
+	    PUT_STRVAL(&a->elts[j], c[j].u.string);
+	}
+	PUT_STRVAL(&a->elts[i], tail);
+	if (str != (String *) NULL) {
+	    PUT_STRVAL(&a->elts[i + 1], str);
+	}
+	PUT_ARRVAL_NOREF(&val, a);
     } else {
 	/* create new buffer */
 	if (usr->flags & CF_ODONE) {
@@ -440,9 +577,9 @@ static int comm_write(user *usr, Object *obj, String *str, char *text,
 	if (str == (String *) NULL) {
 	    str = str_new(text, (long) len);
 	}
+	PUT_STRVAL_NOREF(&val, str);
     }
 
-    PUT_STRVAL_NOREF(&val, str);
     d_assign_elt(data, arr, v, &val);
     return len;
 }
@@ -616,32 +753,253 @@ void comm_block(Object *obj, int block)
     }
 }
 
+/*
+ * NAME:	comm->framing()
+ * DESCRIPTION:	set the input framing for a binary connection
+ */
+bool comm_framing(Object *obj, int type, int delim)
+{
+    user *usr;
+    Dataspace *data;
+    Array *arr;
+    Value *v;
+    Int num;
+    int framing;
+
+    usr = &users[EINDEX(obj->etabi)];
+    if (usr->flags & CF_TELNET) {
+	return FALSE;
+    }
+    switch (type) {
+    case FRAME_LEN2:
+	framing = CF_FRAME2;
+	break;
+
+    case FRAME_LEN4:
+	framing = CF_FRAME4;
+	break;
+
+    case FRAME_DELIM:
+	framing = CF_FRAMED;
+	break;
+
+    default:
+	framing = 0;
+	delim = '\0';
+	break;
+    }
+    arr = d_get_extravar(data = obj->data)->u.array;
+    v = d_get_elts(arr);
+    num = (v->u.number & ~(CF_FRAMING | 0xff0000L)) | framing |
+	  ((Int) UCHAR(delim) << 16);
+    if (num != v->u.number) {
+	Value val;
+
+	if (!(usr->flags & CF_FLUSH)) {
+	    addtoflush(usr, arr);
+	}
+	val = *v;
+	val.u.number = num;
+	d_assign_elt(data, arr, v, &val);
+    }
+    return TRUE;
+}
+
+/*
+ * NAME:	comm->frame()
+ * DESCRIPTION:	find the first complete message in a binary input buffer.
+ *		Return its length and set its start and end, or return -1
+ *		if it is incomplete and -2 if it is longer than MAX_STRLEN.
+ */
+static long comm_frame(user *usr, Uint *start, Uint *end)
+{
+    char *p;
+    Uint len;
+
+    p = usr->inbuf;
+    switch (usr->flags & CF_FRAMING) {
+    case CF_FRAME2:
+	if (usr->inbufsz < 2) {
+	    return -1;
+	}
+	len = (UCHAR(p[0]) << 8) | UCHAR(p[1]);
+	*start = 2;
+	*end = 2 + len;
+	break;
+
+    case CF_FRAME4:
+	if (usr->inbufsz < 4) {
+	    return -1;
+	}
+	len = ((Uint) UCHAR(p[0]) << 24) | ((Uint) UCHAR(p[1]) << 16) |
+	      (UCHAR(p[2]) << 8) | UCHAR(p[3]);
+	if (len > MAX_STRLEN) {
+	    return -2;
+	}
+	*start = 4;
+	*end = 4 + len;
+	break;
+
+    default:
+	/* continue where the previous search left off */
+	p = (char *) memchr(p + usr->inbufscan, usr->state,
+			    usr->inbufsz - usr->inbufscan);
+	if (p == (char *) NULL) {
+	    usr->inbufscan = usr->inbufsz;
+	    return (usr->inbufsz > MAX_STRLEN) ? -2 : -1;
+	}
+	len = p - usr->inbuf;
+	usr->inbufscan = len;
+	*start = 0;
+	*end = len + 1;
+	return len;
+    }
+
+    return (*end <= usr->inbufsz) ? (long) len : -1;
+}
+
+/*
+ * NAME:	comm->fpending()
+ * DESCRIPTION:	note whether a binary connection has buffered input that
+ *		can be delivered without reading
+ */
+static void comm_fpending(user *usr)
+{
+    Uint start, end;
+    int n;
+
+    n = (usr->inbufsz != 0 &&
+	 (!(usr->flags & CF_FRAMING) || comm_frame(usr, &start, &end) != -1));
+    newlines += n - usr->newlines;
+    usr->newlines = n;
+}
+
+/*
+ * NAME:	comm->fread()
+ * DESCRIPTION:	read more input for a binary connection with framing,
+ *		enlarging the input buffer to hold a large message whole
+ */
+static int comm_fread(user *usr)
+{
+    Uint start, end, size;
+    char *buf;
+    int n;
+
+    size = usr->inbufsz + BINBUF_SIZE;
+    end = 0;
+    if (comm_frame(usr, &start, &end) == -1 && end > size &&
+	(usr->flags & CF_FRAMING) != CF_FRAMED) {
+	size = end;
+    }
+    if (size > usr->inbufmax) {
+	/* at least double the buffer, so that copying takes linear time */
+	if (size < usr->inbufmax * 2) {
+	    size = usr->inbufmax * 2;
+	}
+	if (size > FRAMEBUF_SIZE) {
+	    size = FRAMEBUF_SIZE;
+	}
+	if (size > usr->inbufmax) {
+	    /* kept across tasks */
+	    m_static();
+	    buf = ALLOC(char, size);
+	    if (usr->inbufsz != 0) {
+		memcpy(buf, usr->inbuf, usr->inbufsz);
+	    }
+	    if (usr->inbuf != (char *) NULL) {
+		FREE(usr->inbuf);
+	    }
+	    m_dynamic();
+	    usr->inbuf = buf;
+	    usr->inbufmax = size;
+	}
+    }
+
+    n = conn_read(usr->conn, usr->inbuf + usr->inbufsz,
+		  usr->inbufmax - usr->inbufsz);
+    if (n > 0) {
+	usr->inbufsz += n;
+    }
+    return n;
+}
+
+/*
+ * NAME:	comm->fpush()
+ * DESCRIPTION:	push the first complete message of a binary connection with
+ *		framing on the stack, and remove it from the input buffer
+ */
+static long comm_fpush(Frame *f, user *usr)
+{
+    Uint start, end;
+    long len;
+
+    len = comm_frame(usr, &start, &end);
+    if (len >= 0) {
+	PUSH_STRVAL(f, str_new(usr->inbuf + start, len));
+	usr->inbufsz -= end;
+	usr->inbufscan = 0;
+	memmove(usr->inbuf, usr->inbuf + end, usr->inbufsz);
+	comm_fpending(usr);
+    }
+    return len;
+}
+
 /*
  * NAME:	comm->uflush()
  * DESCRIPTION:	flush output buffers for a single user only
  */
 static void comm_uflush(user *usr, Object *obj, Dataspace *data, Array *arr)
 {
-    Value *v;
-    int n;
+    Value *v, *c;
+    Array *a;
+    char **bufs;
+    unsigned int *lens;
+    int i, j, n, nchunks;
+    Value val;
 
     UNREFERENCED_PARAMETER(obj);
 
     v = d_get_elts(arr);
 
-    if (v[1].type == T_STRING) {
+    if (v[1].type == T_STRING || v[1].type == T_ARRAY) {
 	if (conn_wrdone(usr->conn)) {
-	    n = conn_write(usr->conn, v[1].u.string->text + usr->osdone,
-			   v[1].u.string->len - usr->osdone);
+	    /* write all chunks at once */
+	    c = chunks(&v[1], &nchunks);
+	    bufs = ALLOCA(char*, nchunks);
+	    lens = ALLOCA(unsigned int, nchunks);
+	    for (i = 0; i < nchunks; i++) {
+		bufs[i] = c[i].u.string->text;
+		lens[i] = c[i].u.string->len;
+	    }
+	    bufs[0] += usr->osdone;
+	    lens[0] -= usr->osdone;
+	    n = conn_writev(usr->conn, bufs, lens, nchunks);
+	    AFREE(lens);
+	    AFREE(bufs);
 	    if (n >= 0) {
 		n += usr->osdone;
-		if (n == v[1].u.string->len) {
+		for (i = 0; i < nchunks && n >= c[i].u.string->len; i++) {
+		    n -= c[i].u.string->len;
+		}
+		if (i == nchunks) {
 		    /* buffer fully drained */
 		    n = 0;
 		    usr->flags &= ~CF_OUTPUT;
 		    usr->flags |= CF_ODONE;
 		    odone++;
 		    d_assign_elt(data, arr, &v[1], &nil_value);
+		} else if (i != 0) {
+		    /* remove the chunks that were written */
+		    if (i == nchunks - 1) {
+			PUT_STRVAL_NOREF(&val, c[i].u.string);
+		    } else {
+			a = arr_new(data, (long) nchunks - i);
+			for (j = 0; i < nchunks; i++, j++) {
+			    PUT_STRVAL(&a->elts[j], c[i].u.string);
+			}
+			PUT_ARRVAL_NOREF(&val, a);
+		    }
+		    d_assign_elt(data, arr, &v[1], &val);
 		}
 		usr->osdone = n;
 	    } else {
@@ -674,7 +1032,8 @@ void comm_flush()
     user *usr;
     Object *obj;
     Array *arr;
-    Value *v;
+    Value *v, *c;
+    int n;
 
     while (outbound != (user *) NULL) {
 	usr = outbound;
@@ -724,8 +1083,7 @@ void comm_flush()
 	    }
 	    if (usr->flags & CF_PROMPT) {
 		usr->flags &= ~CF_PROMPT;
-		if ((usr->flags & CF_GA) && v[1].type == T_STRING &&
-		    usr->outbuf != v[1].u.string) {
+		if ((usr->flags & CF_GA) && newoutput(usr, &v[1])) {
 		    static char ga[] = { (char) IAC, (char) GA };
 
 		    /* append go-ahead */
@@ -737,17 +1095,32 @@ void comm_flush()
 	    usr->flags ^= CF_BLOCKED;
 	    conn_block(usr->conn, ((usr->flags & CF_BLOCKED) != 0));
 	}
+	if (!(usr->flags & CF_TELNET) &&
+	    (((v->u.number ^ usr->flags) & CF_FRAMING) ||
+	     UCHAR(usr->state) != CF_DELIM(v->u.number))) {
+	    /* change input framing */
+	    usr->flags = (usr->flags & ~CF_FRAMING) |
+			 (v->u.number & CF_FRAMING);
+	    usr->state = (char) CF_DELIM(v->u.number);
+	    usr->inbufscan = 0;
+	    comm_fpending(usr);
+	}
 
 	/*
 	 * write
 	 */
 	if (usr->outbuf != (String *) NULL) {
-	    if (usr->outbuf != v[1].u.string) {
+	    c = chunks(&v[1], &n);
+	    if (n == 0 || usr->outbuf != c->u.string) {
 		usr->osdone = 0;	/* new mesg before buffer drained */
 	    }
 	    str_del(usr->outbuf);
 	    usr->outbuf = (String *) NULL;
 	}
+	if (usr->outchunks != (Array *) NULL) {
+	    arr_del(usr->outchunks);
+	    usr->outchunks = (Array *) NULL;
+	}
 	if (usr->flags & CF_OUTPUT) {
 	    comm_uflush(usr, obj, obj->data, arr);
 	}
@@ -759,9 +1132,13 @@ void comm_flush()
 	    if (usr->conn != (connection *) NULL) {
 		conn_del(usr->conn);
 	    }
+	    newlines -= usr->newlines;
 	    if (usr->flags & CF_TELNET) {
-		newlines -= usr->newlines;
 		FREE(usr->inbuf - 1);
+	    } else if (usr->inbuf != (char *) NULL) {
+		m_static();
+		FREE(usr->inbuf);
+		m_dynamic();
 	    }
 	    if (usr->flags & CF_ODONE) {
 		--odone;
@@ -789,6 +1166,9 @@ void comm_flush()
 	arr_del(arr);
 	usr->flags &= ~CF_FLUSH;
     }
+
+    /* send datagrams queued during this flush */
+    conn_udpflush();
 }
 
 /*
@@ -891,6 +1271,40 @@ static void comm_daccept(Frame *f, connection *conn, int port)
     this_user = OBJ_NONE;
 }
 
+# define ONES		(~(Uuint) 0 / 0xff)	/* 0x01 in every byte */
+# define HIGHS		(ONES << 7)		/* 0x80 in every byte */
+# define HASZERO(x)	((((x) - ONES) & ~(x)) & HIGHS)
+
+/*
+ * NAME:	comm->scan()
+ * DESCRIPTION:	return the length of the plain telnet data at the start of
+ *		a buffer, up to the first IAC, CR, LF, NUL, BS or DEL
+ */
+static int comm_scan(char *p, int n)
+{
+    Uuint w;
+    char *start;
+
+    start = p;
+    while (n >= (int) sizeof(Uuint)) {
+	/* test a word at a time */
+	memcpy(&w, p, sizeof(Uuint));
+	if (HASZERO(~(w | HIGHS)) ||		/* DEL, IAC */
+	    HASZERO(w & ~(ONES * BS)) ||	/* NUL, BS */
+	    HASZERO(w ^ (ONES * LF)) || HASZERO(w ^ (ONES * CR))) {
+	    break;
+	}
+	p += sizeof(Uuint);
+	n -= sizeof(Uuint);
+    }
+    while (n > 0 && UCHAR(*p) != IAC && *p != '\177' && *p != '\0' &&
+	   *p != BS && *p != LF && *p != CR) {
+	p++;
+	--n;
+    }
+    return p - start;
+}
+
 /*
  * NAME:	comm->receive()
  * DESCRIPTION:	receive a message from a user
@@ -908,7 +1322,7 @@ void comm_receive(Frame *f, Uint timeout, unsigned int mtime)
     char buffer[BINBUF_SIZE];
     Object *obj;
     user *usr;
-    int n, i, state, nls;
+    int n, i, state, nls, len;
     char *p, *q;
     connection *conn;
 
@@ -922,6 +1336,7 @@ void comm_receive(Frame *f, Uint timeout, unsigned int mtime)
 	 */
 	return;
     }
+    st_start();
 
     try {
 	ec_push(errhandler);
@@ -1109,6 +1524,24 @@ void comm_receive(Frame *f, Uint timeout, unsigned int mtime)
 		    nls = usr->newlines;
 		    q = p;
 		    while (n > 0) {
+			if (state == TS_DATA) {
+			    /*
+			     * copy plain data in bulk
+			     */
+			    len = comm_scan(p, n);
+			    if (len != 0) {
+				if (q != p) {
+				    memmove(q, p, len);
+				}
+				p += len;
+				q += len;
+				n -= len;
+				if (n == 0) {
+				    break;
+				}
+			    }
+			}
+
 			switch (state) {
 			case TS_DATA:
 			    switch (UCHAR(*p)) {
@@ -1287,9 +1720,7 @@ void comm_receive(Frame *f, Uint timeout, unsigned int mtime)
 		    usr->inbufsz -= n + 1;
 
 		    PUSH_STRVAL(f, str_new(usr->inbuf, (long) n));
-		    for (n = usr->inbufsz; n != 0; --n) {
-			*q++ = *p++;
-		    }
+		    memmove(q, p, usr->inbufsz);
 		} else {
 		    /*
 		     * input buffer full
@@ -1335,20 +1766,65 @@ void comm_receive(Frame *f, Uint timeout, unsigned int mtime)
 		    this_user = OBJ_NONE;
 		}
 
-		n = conn_read(usr->conn, p = buffer, BINBUF_SIZE);
-		if (n <= 0) {
-		    if (n < 0 && !(usr->flags & CF_OUTPUT)) {
+		if (usr->flags & CF_FRAMING) {
+		    long len;
+
+		    /*
+		     * framed input
+		     */
+		    len = comm_fpush(f, usr);
+		    if (len == -1) {
+			n = comm_fread(usr);
+			if (n <= 0) {
+			    if (n < 0 && !(usr->flags & CF_OUTPUT)) {
+				/*
+				 * no more input and no pending output
+				 */
+				comm_del(f, usr, obj, FALSE);
+				endtask();
+				break;
+			    }
+			    continue;
+			}
+			len = comm_fpush(f, usr);
+		    }
+		    if (len == -2) {
 			/*
-			 * no more input and no pending output
+			 * message too long
 			 */
 			comm_del(f, usr, obj, FALSE);
-			endtask();	/* this cannot be in comm_del() */
+			endtask();
 			break;
 		    }
-		    continue;
-		}
+		    if (len == -1) {
+			comm_fpending(usr);
+			continue;
+		    }
+		} else if (usr->inbufsz != 0) {
+		    /*
+		     * framing was turned off: deliver the remainder
+		     */
+		    n = (usr->inbufsz > MAX_STRLEN) ? MAX_STRLEN : usr->inbufsz;
+		    PUSH_STRVAL(f, str_new(usr->inbuf, (long) n));
+		    usr->inbufsz -= n;
+		    memmove(usr->inbuf, usr->inbuf + n, usr->inbufsz);
+		    comm_fpending(usr);
+		} else {
+		    n = conn_read(usr->conn, p = buffer, BINBUF_SIZE);
+		    if (n <= 0) {
+			if (n < 0 && !(usr->flags & CF_OUTPUT)) {
+			    /*
+			     * no more input and no pending output
+			     */
+			    comm_del(f, usr, obj, FALSE);
+			    endtask();	/* this cannot be in comm_del() */
+			    break;
+			}
+			continue;
+		    }
 
-		PUSH_STRVAL(f, str_new(buffer, (long) n));
+		    PUSH_STRVAL(f, str_new(buffer, (long) n));
+		}
 	    }
 
 	    this_user = obj->index;
@@ -1454,6 +1930,16 @@ Array *comm_users(Dataspace *data)
     return a;
 }
 
+/*
+ * NAME:	comm->info()
+ * DESCRIPTION:	return the number of connections and datagram connections
+ */
+void comm_info(int *n, int *ndg)
+{
+    *n = nusers;
+    *ndg = ndgram;
+}
+
 /*
  * NAME:	comm->is_connection()
  * DESCRIPTION: is this REALLY a user object?
@@ -1710,11 +2196,19 @@ bool comm_restore(int fd)
 		usr->inbuf = ALLOC(char, INBUF_SIZE + 1);
 		*usr->inbuf++ = LF;	/* sentinel */
 		m_dynamic();
+	    } else if (du->tbufsz != 0) {
+		/* partial message */
+		m_static();
+		usr->inbuf = ALLOC(char, usr->inbufmax = du->tbufsz);
+		m_dynamic();
 	    } else {
 		usr->inbuf = (char *) NULL;
+		usr->inbufmax = 0;
 	    }
+	    usr->inbufscan = 0;
 	    usr->extra = (Array *) NULL;
 	    usr->outbuf = (String *) NULL;
+	    usr->outchunks = (Array *) NULL;
 	    usr->inbufsz = du->tbufsz;
 	    if (usr->inbufsz != 0) {
 		memcpy(usr->inbuf, tbuf, usr->inbufsz);
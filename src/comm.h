@@ -21,6 +21,11 @@
 # define  P_UDP      17
 # define  P_TELNET   1
 
+# define FRAME_NONE	0	/* no input framing */
+# define FRAME_DELIM	1	/* messages end with a delimiter */
+# define FRAME_LEN2	2	/* 2-byte big-endian length prefix */
+# define FRAME_LEN4	4	/* 4-byte big-endian length prefix */
+
 struct connection;
 
 extern bool	   conn_init	 (int, char**, char**, char**, unsigned short*,
@@ -44,7 +49,10 @@ extern bool	   conn_udpcheck (connection*);
 extern int	   conn_read	 (connection*, char*, unsigned int);
 extern int	   conn_udpread	 (connection*, char*, unsigned int);
 extern int	   conn_write	 (connection*, char*, unsigned int);
+extern int	   conn_writev	 (connection*, char**, unsigned int*, int);
 extern int	   conn_udpwrite (connection*, char*, unsigned int);
+extern void	   conn_udpflush ();
+extern void	   conn_udpcount (int, Uint*, Uint*, Uint*, Uint*);
 extern bool	   conn_wrdone	 (connection*);
 extern void	   conn_ipnum	 (connection*, char*);
 extern void	   conn_ipname	 (connection*, char*);
@@ -69,6 +77,7 @@ extern bool	comm_echo	(Object*, int);
 extern void	comm_challenge	(Object*, String*);
 extern void	comm_flush	();
 extern void	comm_block	(Object*, int);
+extern bool	comm_framing	(Object*, int, int);
 extern void	comm_receive	(Frame*, Uint, unsigned int);
 extern String  *comm_ip_number	(Object*);
 extern String  *comm_ip_name	(Object*);
@@ -77,6 +86,7 @@ extern Object  *comm_user	();
 extern void	comm_connect	(Frame *f, Object *obj, char *addr,
 				   unsigned char protocol, unsigned short port);
 extern Array   *comm_users	(Dataspace*);
+extern void	comm_info	(int*, int*);
 extern bool     comm_is_connection (Object*);
 extern bool	comm_dump	(int);
 extern bool	comm_restore	(int);
@@ -1825,6 +1825,9 @@ struct case_label {
 
 static case_label *switch_table;	/* label table for current switch */
 
+# define SWITCH_HASHED	16		/* min string labels for hash table */
+# define SWITCH_HASHMAX	32768		/* max string labels for hash table */
+
 /*
  * NAME:	codegen->switch_start()
  * DESCRIPTION:	generate code for the start of a switch statement
@@ -2025,12 +2028,11 @@ static void cg_switch_range(node *n)
  */
 static void cg_switch_str(node *n)
 {
-    node *m;
-    int i, size;
+    node *m, *strs;
+    int i, size, nstr, bits;
     case_label *table;
 
     cg_switch_start(n);
-    code_byte(SWITCH_STRING);
     m = n->l.left;
     size = n->mod;
     if (m->l.left == (node *) NULL) {
@@ -2040,6 +2042,12 @@ static void cg_switch_str(node *n)
 	/* implicit default */
 	size++;
     }
+    nstr = size - 1;
+    if (m->l.left->type == nil_node) {
+	--nstr;
+    }
+    code_byte((nstr >= SWITCH_HASHED && nstr <= SWITCH_HASHMAX) ?
+	       SWITCH_STRHASH : SWITCH_STRING);
     code_word(size);
 
     table = switch_table;
@@ -2057,6 +2065,7 @@ static void cg_switch_str(node *n)
 	/* no 0 case */
 	code_byte(1);
     }
+    strs = m;
     while (i < size) {
 	Int l;
 
@@ -2067,6 +2076,32 @@ static void cg_switch_str(node *n)
 	m = m->r.right;
     }
 
+    if (nstr >= SWITCH_HASHED && nstr <= SWITCH_HASHMAX) {
+	unsigned short *slots, h, mask;
+	String *str;
+
+	/*
+	 * hash table of indices in the sorted table, open addressing
+	 */
+	for (bits = 1; (1 << bits) < 2 * nstr; bits++) ;
+	mask = (1 << bits) - 1;
+	slots = ALLOCA(unsigned short, 1 << bits);
+	memset(slots, '\0', sizeof(unsigned short) << bits);
+	for (m = strs, i = 1; i <= nstr; m = m->r.right, i++) {
+	    str = m->l.left->l.string;
+	    h = Hashtab::hashmem(str->text, str->len) & mask;
+	    while (slots[h] != 0) {
+		h = (h + 1) & mask;
+	    }
+	    slots[h] = i;
+	}
+	code_byte(bits);
+	for (i = 0; i < 1 << bits; i++) {
+	    code_word(slots[i]);
+	}
+	AFREE(slots);
+    }
+
     /*
      * generate code for body
      */
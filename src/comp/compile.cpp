@@ -57,6 +57,7 @@ struct var {
     const char *name;		/* variable name */
     short type;			/* variable type */
     short unset;		/* used before set? */
+    short nassign;		/* # times used as lvalue */
     String *cvstr;		/* class name */
 };
 
@@ -236,6 +237,7 @@ static void block_pdef(char *name, short type, String *cvstr)
 	variables[nparams].name = name;
 	variables[nparams].type = type;
 	variables[nparams].unset = 0;
+	variables[nparams].nassign = 0;
 	variables[nparams++].cvstr = cvstr;
 	vindex++;
 	nvars++;
@@ -258,6 +260,7 @@ static void block_vdef(char *name, short type, String *cvstr)
 	variables[vindex].name = name;
 	variables[vindex].type = type;
 	variables[vindex].unset = 0;
+	variables[vindex].nassign = 0;
 	variables[vindex++].cvstr = cvstr;
 	if (vindex > nvars) {
 	    nvars++;
@@ -387,6 +390,7 @@ static void c_clear()
     switch_list = (loop *) NULL;
     block_clear();
     cond_clear();
+    opt_clear();
     node_clear();
     seen_decls = FALSE;
     nesting = 0;
@@ -941,13 +945,17 @@ void c_function(unsigned int sclass, node *type, node *n)
  * NAME:	compile->funcbody()
  * DESCRIPTION:	create a function body
  */
-void c_funcbody(node *n)
+void c_funcbody(node *n, int typechecked)
 {
-    char *prog;
+    char *prog, *proto;
+    int index;
     Uint depth;
     unsigned short size;
     Float flt;
 
+    index = ctrl_fdef(&proto);
+    opt_function(n, index, proto, typechecked);
+
     flt.initZero();
     switch (ftype) {
     case T_INT:
@@ -1965,20 +1973,61 @@ short c_vtype(int i)
     return variables[i].type;
 }
 
+/*
+ * NAME:	compile->vassigned()
+ * DESCRIPTION:	return the number of times a variable is used as an lvalue
+ */
+int c_vassigned(int i)
+{
+    return variables[i].nassign;
+}
+
+/*
+ * NAME:	compile->tmpvar()
+ * DESCRIPTION:	create a temporary local variable, or return -1
+ */
+int c_tmpvar()
+{
+    if (nvars == MAX_LOCALS) {
+	return -1;
+    }
+    variables[nvars].name = "-";
+    variables[nvars].type = T_MIXED;
+    variables[nvars].unset = 0;
+    variables[nvars].nassign = 1;
+    variables[nvars].cvstr = (String *) NULL;
+    return nvars++;
+}
+
 /*
  * NAME:	lvalue()
- * DESCRIPTION:	check if a value can be an lvalue
+ * DESCRIPTION:	check if a value can be an lvalue, and count the assignments
+ *		to local variables
  */
 static bool lvalue(node *n)
 {
+    node *m;
+
     if (n->type == N_CAST && n->mod == n->l.left->mod) {
 	/* only an implicit cast is allowed */
 	n = n->l.left;
     }
     switch (n->type) {
+    case N_INDEX:
+	m = n->l.left;
+	if (m->type == N_CAST) {
+	    m = m->l.left;
+	}
+	if (m->type == N_LOCAL) {
+	    /* str[i] = c modifies the string */
+	    variables[m->r.number].nassign++;
+	}
+	return TRUE;
+
     case N_LOCAL:
+	variables[n->r.number].nassign++;
+	/* fall through */
     case N_GLOBAL:
-    case N_INDEX:
     case N_FAKE:
 	return TRUE;
 
@@ -28,7 +28,7 @@ extern bool	 c_inherit	(char*, node*, int);
 extern String	*c_objecttype	(node*);
 extern void	 c_global	(unsigned int, node*, node*);
 extern void	 c_function	(unsigned int, node*, node*);
-extern void	 c_funcbody	(node*);
+extern void	 c_funcbody	(node*, int);
 extern void	 c_local	(unsigned int, node*, node*);
 extern void	 c_startcond	();
 extern void	 c_startcond2	();
@@ -65,6 +65,8 @@ extern node	*c_aggregate	(node*, unsigned int);
 extern node	*c_local_var	(node*);
 extern node	*c_global_var	(node*);
 extern short	 c_vtype	(int);
+extern int	 c_vassigned	(int);
+extern int	 c_tmpvar	();
 extern node	*c_funcall	(node*, node*);
 extern node	*c_arrow	(node*, node*, node*);
 extern node	*c_address	(node*, node*, int);
@@ -1239,6 +1239,16 @@ void ctrl_dprogram(char *prog, unsigned int size)
     progsize += size;
 }
 
+/*
+ * NAME:	Control->fdef()
+ * DESCRIPTION:	return the index and prototype of the function being defined
+ */
+int ctrl_fdef(char **proto)
+{
+    *proto = functions[fdef].proto;
+    return fdef;
+}
+
 /*
  * NAME:	Control->dvar()
  * DESCRIPTION:	define a variable
@@ -1466,6 +1476,19 @@ char *ctrl_fcall(String *str, String **cfstr, long *call, int typechecking)
     return proto;
 }
 
+/*
+ * NAME:	Control->dfcall()
+ * DESCRIPTION:	return the index of a function in the new object that is
+ *		called directly, or -1
+ */
+int ctrl_dfcall(long call)
+{
+    if ((call >> 24) == DFCALL && ((call >> 8) & 0xff) == newohash->index) {
+	return call & 0xff;
+    }
+    return -1;
+}
+
 /*
  * NAME:	Control->gencall()
  * DESCRIPTION:	generate a function call
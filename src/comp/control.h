@@ -26,10 +26,12 @@ extern long		 ctrl_dstring	(String*);
 extern void		 ctrl_dproto	(String*, char*, String*);
 extern void		 ctrl_dfunc	(String*, char*, String*);
 extern void		 ctrl_dprogram	(char*, unsigned int);
+extern int		 ctrl_fdef	(char**);
 extern void		 ctrl_dvar	(String*, unsigned int,
 					   unsigned int, String*);
 extern char		*ctrl_ifcall	(String*, const char*, String**, long*);
 extern char		*ctrl_fcall	(String*, String**, long*, int);
+extern int		 ctrl_dfcall	(long);
 extern unsigned short	 ctrl_gencall	(long);
 extern unsigned short	 ctrl_var	(String*, long*, String**);
 extern int		 ctrl_ninherits	();
@@ -113,7 +113,7 @@ static Uint side_end(node **n, node *side, node **oldside, Uint olddepth)
 
 
 static Int kd_status, kd_call_trace, kd_allocate,	/* kfun descriptors */
-	   kd_allocate_int, kd_allocate_float;
+	   kd_allocate_int, kd_allocate_float, kd_previous_program;
 
 /*
  * NAME:	optimize->init()
@@ -127,6 +127,984 @@ void opt_init()
     kd_allocate = ((long) KFCALL << 24) | kf_func("allocate");
     kd_allocate_int = ((long) KFCALL << 24) | kf_func("allocate_int");
     kd_allocate_float = ((long) KFCALL << 24) | kf_func("allocate_float");
+    kd_previous_program = ((long) KFCALL << 24) | kf_func("previous_program");
+}
+
+# define INLINE_SIZE	32	/* max. # nodes in an inlined function */
+# define INLINE_GROWTH	512	/* max. # nodes inlined in a function */
+# define INLINE_ARGS	8	/* max. # arguments of an inlined function */
+
+# define IN_LEFT	0x01	/* left child is a node */
+# define IN_RIGHT	0x02	/* right child is a node */
+
+struct inlfunc {
+    node *body;			/* returned expression */
+    unsigned short size;	/* # nodes in body */
+    char nargs;			/* # arguments */
+    char args[INLINE_ARGS];	/* argument types */
+};
+
+static inlfunc inlines[256];	/* inlinable functions of the new object */
+static Uint growth;		/* # nodes inlined in the current function */
+static node *noinline;		/* function call which is an lvalue base */
+static node *cvinit[MAX_LOCALS];	/* constant assigned to local variable */
+static node *cvars[MAX_LOCALS];	/* constant value of local variable */
+
+/*
+ * NAME:	inline->kids()
+ * DESCRIPTION:	return the children of a node that can be inlined, or -1
+ */
+static int inl_kids(node *n)
+{
+    switch (n->type) {
+    case N_FLOAT:
+    case N_INT:
+    case N_NIL:
+	return 0;
+
+    case N_STR:
+	return IN_RIGHT;
+
+    case N_AGGR:
+    case N_CAST:
+    case N_FUNC:
+    case N_GLOBAL:
+    case N_LOCAL:
+    case N_NEG:
+    case N_NOT:
+    case N_TOFLOAT:
+    case N_TOINT:
+    case N_TOSTRING:
+    case N_TST:
+    case N_UMIN:
+	return IN_LEFT;
+
+    case N_ADD:
+    case N_ADD_INT:
+    case N_ADD_FLOAT:
+    case N_AND:
+    case N_AND_INT:
+    case N_COMMA:
+    case N_DIV:
+    case N_DIV_INT:
+    case N_DIV_FLOAT:
+    case N_EQ:
+    case N_EQ_INT:
+    case N_EQ_FLOAT:
+    case N_GE:
+    case N_GE_INT:
+    case N_GE_FLOAT:
+    case N_GT:
+    case N_GT_INT:
+    case N_GT_FLOAT:
+    case N_INDEX:
+    case N_LAND:
+    case N_LE:
+    case N_LE_INT:
+    case N_LE_FLOAT:
+    case N_LOR:
+    case N_LSHIFT:
+    case N_LSHIFT_INT:
+    case N_LT:
+    case N_LT_INT:
+    case N_LT_FLOAT:
+    case N_MOD:
+    case N_MOD_INT:
+    case N_MULT:
+    case N_MULT_INT:
+    case N_MULT_FLOAT:
+    case N_NE:
+    case N_NE_INT:
+    case N_NE_FLOAT:
+    case N_OR:
+    case N_OR_INT:
+    case N_PAIR:
+    case N_QUEST:
+    case N_RANGE:
+    case N_RSHIFT:
+    case N_RSHIFT_INT:
+    case N_SUB:
+    case N_SUB_INT:
+    case N_SUB_FLOAT:
+    case N_XOR:
+    case N_XOR_INT:
+	return IN_LEFT | IN_RIGHT;
+
+    default:
+	return -1;
+    }
+}
+
+/*
+ * NAME:	inline->size()
+ * DESCRIPTION:	return the size of an expression that can be inlined, or
+ *		a size that exceeds the limit if it cannot be
+ */
+static Uint inl_size(node *n, int nargs)
+{
+    int kids;
+    Uint size;
+
+    if (n == (node *) NULL) {
+	return 0;
+    }
+    kids = inl_kids(n);
+    if (kids < 0) {
+	return INLINE_SIZE + 1;
+    }
+    switch (n->type) {
+    case N_LOCAL:
+	if (n->r.number >= nargs) {
+	    return INLINE_SIZE + 1;
+	}
+	break;
+
+    case N_FUNC:
+	/*
+	 * only kfuns that do not depend on the call itself
+	 */
+	if ((n->r.number >> 24) != KFCALL || n->r.number == kd_status ||
+	    n->r.number == kd_call_trace ||
+	    n->r.number == kd_previous_program) {
+	    return INLINE_SIZE + 1;
+	}
+	break;
+    }
+
+    size = 1;
+    if (kids & IN_LEFT) {
+	size += inl_size(n->l.left, nargs);
+    }
+    if ((kids & IN_RIGHT) && size <= INLINE_SIZE) {
+	size += inl_size(n->r.right, nargs);
+    }
+    return size;
+}
+
+/*
+ * NAME:	inline->copy()
+ * DESCRIPTION:	copy an expression, replacing arguments
+ */
+static node *inl_copy(node *n, node **mem, node **args, unsigned short line)
+{
+    node *m;
+    int kids;
+
+    if (n == (node *) NULL) {
+	return (node *) NULL;
+    }
+    if (n->type == N_LOCAL && args != (node **) NULL) {
+	return inl_copy(args[n->r.number], mem, (node **) NULL, line);
+    }
+
+    if (mem != (node **) NULL) {
+	m = (*mem)++;
+	*m = *n;
+    } else {
+	m = node_new(line);
+	*m = *n;
+	m->line = line;
+    }
+    if (m->sclass != (String *) NULL) {
+	str_ref(m->sclass);
+    }
+    if (m->type == N_STR) {
+	str_ref(m->l.string);
+    }
+    kids = inl_kids(n);
+    if (kids & IN_LEFT) {
+	m->l.left = inl_copy(n->l.left, mem, args, line);
+    }
+    if (kids & IN_RIGHT) {
+	m->r.right = inl_copy(n->r.right, mem, args, line);
+    }
+    return m;
+}
+
+/*
+ * NAME:	inline->del()
+ * DESCRIPTION:	delete an inlinable function
+ */
+static void inl_del(inlfunc *f)
+{
+    node *n;
+    unsigned short i;
+
+    for (n = f->body, i = f->size; i != 0; n++, --i) {
+	if (n->sclass != (String *) NULL) {
+	    str_del(n->sclass);
+	}
+	if (n->type == N_STR) {
+	    str_del(n->l.string);
+	}
+    }
+    FREE(f->body);
+    f->body = (node *) NULL;
+}
+
+static unsigned short vtypes[MAX_LOCALS];	/* inferred types of locals */
+static bool infchanged;		/* inferred types changed */
+static bool infrewrite;		/* rewrite nodes with the inferred types */
+static bool inffail;		/* cannot infer types */
+static int infcond;		/* in a conditionally executed expression */
+
+/*
+ * NAME:	infer->join()
+ * DESCRIPTION:	combine two types, where T_VOID is "not yet known"
+ */
+static unsigned short inf_join(unsigned short t1, unsigned short t2)
+{
+    if (t1 == T_VOID || t1 == t2) {
+	return t2;
+    }
+    if (t2 == T_VOID) {
+	return t1;
+    }
+    return T_MIXED;
+}
+
+/*
+ * NAME:	infer->binop()
+ * DESCRIPTION:	return the int or float variant of an operator with operands
+ *		of the given types, or the operator itself
+ */
+static int inf_binop(int op, unsigned short t1, unsigned short t2)
+{
+    if (t1 != t2) {
+	return op;
+    }
+    if (t1 == T_INT) {
+	switch (op) {
+	case N_ADD:
+	case N_ADD_EQ:
+	case N_ADD_EQ_1:
+	case N_AND:
+	case N_AND_EQ:
+	case N_DIV:
+	case N_DIV_EQ:
+	case N_EQ:
+	case N_GE:
+	case N_GT:
+	case N_LE:
+	case N_LSHIFT:
+	case N_LSHIFT_EQ:
+	case N_LT:
+	case N_MIN_MIN:
+	case N_MOD:
+	case N_MOD_EQ:
+	case N_MULT:
+	case N_MULT_EQ:
+	case N_NE:
+	case N_OR:
+	case N_OR_EQ:
+	case N_PLUS_PLUS:
+	case N_RSHIFT:
+	case N_RSHIFT_EQ:
+	case N_SUB:
+	case N_SUB_EQ:
+	case N_SUB_EQ_1:
+	case N_XOR:
+	case N_XOR_EQ:
+	    return op + 1;
+	}
+    } else if (t1 == T_FLOAT) {
+	switch (op) {
+	case N_ADD:
+	case N_ADD_EQ:
+	case N_ADD_EQ_1:
+	case N_DIV:
+	case N_DIV_EQ:
+	case N_EQ:
+	case N_GE:
+	case N_GT:
+	case N_LE:
+	case N_LT:
+	case N_MIN_MIN:
+	case N_MULT:
+	case N_MULT_EQ:
+	case N_NE:
+	case N_PLUS_PLUS:
+	case N_SUB:
+	case N_SUB_EQ:
+	case N_SUB_EQ_1:
+	    return op + 2;
+	}
+    }
+    return op;
+}
+
+static unsigned short inf_expr (node**);
+
+/*
+ * NAME:	infer->store()
+ * DESCRIPTION:	account for a value of the given type stored in an lvalue
+ */
+static void inf_store(node *n, unsigned short type)
+{
+    node **m;
+    int i;
+
+    if (n->type == N_CAST) {
+	n = n->l.left;
+    }
+    switch (n->type) {
+    case N_LOCAL:
+	if (infcond != 0 || type == T_NIL || (type & T_TYPE) == T_CLASS) {
+	    /* may not happen, or not a type that can be inferred */
+	    type = T_MIXED;
+	}
+	i = n->r.number;
+	type = inf_join(vtypes[i], type);
+	if (type != vtypes[i]) {
+	    vtypes[i] = type;
+	    infchanged = TRUE;
+	}
+	break;
+
+    case N_INDEX:
+	m = &n->l.left;
+	if ((*m)->type == N_CAST) {
+	    m = &(*m)->l.left;
+	}
+	if ((*m)->type == N_INDEX) {
+	    /* strarray[x][y] = 'c'; */
+	    inf_expr(&(*m)->l.left);
+	    inf_expr(&(*m)->r.right);
+	} else {
+	    inf_expr(m);
+	}
+	inf_expr(&n->r.right);
+	break;
+
+    case N_AGGR:
+	for (n = n->l.left; n->type == N_PAIR; n = n->r.right) {
+	    inf_store(n->l.left, T_MIXED);
+	}
+	inf_store(n, T_MIXED);
+	break;
+    }
+}
+
+/*
+ * NAME:	infer->asgnop()
+ * DESCRIPTION:	infer the type of an assignment operator, and specialize it
+ *		for a local variable of known type
+ */
+static unsigned short inf_asgnop(node *n, unsigned short type, bool unary)
+{
+    unsigned short vtype;
+    int op;
+
+    if (n->l.left->type != N_LOCAL || n->l.left->mod != T_MIXED) {
+	inf_store(n->l.left, n->l.left->mod);
+	return n->mod;
+    }
+
+    vtype = vtypes[n->l.left->r.number];
+    if (unary) {
+	type = vtype;
+    }
+    if (vtype == T_VOID || type == T_VOID) {
+	return T_VOID;
+    }
+    op = inf_binop(n->type, vtype, type);
+    if (op != n->type) {
+	if (infrewrite) {
+	    n->type = op;
+	    n->mod = vtype;
+	}
+    } else if (n->type != N_ADD_EQ || vtype != T_STRING) {
+	vtype = T_MIXED;
+    }
+    inf_store(n->l.left, vtype);
+    return vtype;
+}
+
+/*
+ * NAME:	infer->expr()
+ * DESCRIPTION:	infer the type of an expression, and in the rewrite pass use
+ *		it to select specialized operators and remove redundant casts
+ */
+static unsigned short inf_expr(node **m)
+{
+    node *n, **l;
+    unsigned short t1, t2;
+    int op;
+
+    n = *m;
+    if (n == (node *) NULL) {
+	return T_MIXED;
+    }
+    switch (n->type) {
+    case N_LOCAL:
+	t1 = vtypes[n->r.number];
+	if (n->mod != T_MIXED || t1 == T_MIXED) {
+	    return n->mod;
+	}
+	if (infrewrite && (t1 == T_INT || t1 == T_FLOAT)) {
+	    n->mod = t1;
+	}
+	return t1;
+
+    case N_FLOAT:
+    case N_GLOBAL:
+    case N_INT:
+    case N_NIL:
+    case N_STR:
+	return n->mod;
+
+    case N_CAST:
+	/*
+	 * The parser only casts values of type mixed.  If the value is
+	 * now known to be of the cast type, the runtime check can go.
+	 */
+	t1 = n->l.left->mod;
+	t2 = inf_expr(&n->l.left);
+	if (infrewrite && t2 == n->mod && t1 != n->mod &&
+	    (n->mod & T_TYPE) != T_CLASS) {
+	    *m = n->l.left;
+	}
+	return n->mod;
+
+    case N_CATCH:
+    case N_INSTANCEOF:
+    case N_NEG:
+    case N_NOT:
+    case N_SPREAD:
+    case N_TOFLOAT:
+    case N_TOINT:
+    case N_TOSTRING:
+    case N_TST:
+    case N_UMIN:
+	inf_expr(&n->l.left);
+	return n->mod;
+
+    case N_LVALUE:
+	inf_store(n->l.left, T_MIXED);
+	return n->mod;
+
+    case N_ADD:
+    case N_AND:
+    case N_DIV:
+    case N_EQ:
+    case N_GE:
+    case N_GT:
+    case N_LE:
+    case N_LSHIFT:
+    case N_LT:
+    case N_MOD:
+    case N_MULT:
+    case N_NE:
+    case N_OR:
+    case N_RSHIFT:
+    case N_SUB:
+    case N_XOR:
+	t1 = inf_expr(&n->l.left);
+	t2 = inf_expr(&n->r.right);
+	if (t1 == T_VOID || t2 == T_VOID) {
+	    return T_VOID;
+	}
+	op = inf_binop(n->type, t1, t2);
+	if (op == n->type) {
+	    return n->mod;
+	}
+	switch (n->type) {
+	case N_EQ:
+	case N_GE:
+	case N_GT:
+	case N_LE:
+	case N_LT:
+	case N_NE:
+	    t1 = T_INT;
+	    break;
+	}
+	if (infrewrite) {
+	    n->type = op;
+	    n->mod = t1;
+	}
+	return t1;
+
+    case N_ADD_INT:
+    case N_ADD_FLOAT:
+    case N_AND_INT:
+    case N_DIV_INT:
+    case N_DIV_FLOAT:
+    case N_EQ_INT:
+    case N_EQ_FLOAT:
+    case N_GE_INT:
+    case N_GE_FLOAT:
+    case N_GT_INT:
+    case N_GT_FLOAT:
+    case N_LE_INT:
+    case N_LE_FLOAT:
+    case N_LSHIFT_INT:
+    case N_LT_INT:
+    case N_LT_FLOAT:
+    case N_MOD_INT:
+    case N_MULT_INT:
+    case N_MULT_FLOAT:
+    case N_NE_INT:
+    case N_NE_FLOAT:
+    case N_OR_INT:
+    case N_RSHIFT_INT:
+    case N_SUB_INT:
+    case N_SUB_FLOAT:
+    case N_SUM:
+    case N_XOR_INT:
+	inf_expr(&n->l.left);
+	inf_expr(&n->r.right);
+	return n->mod;
+
+    case N_INDEX:
+	t1 = inf_expr(&n->l.left);
+	t2 = inf_expr(&n->r.right);
+	if (t1 == T_STRING && t2 == T_INT) {
+	    return T_INT;
+	}
+	return n->mod;
+
+    case N_COMMA:
+	inf_expr(&n->l.left);
+	t1 = inf_expr(&n->r.right);
+	return (n->mod == T_MIXED) ? t1 : n->mod;
+
+    case N_LAND:
+    case N_LOR:
+	inf_expr(&n->l.left);
+	infcond++;
+	inf_expr(&n->r.right);
+	--infcond;
+	return n->mod;
+
+    case N_QUEST:
+	inf_expr(&n->l.left);
+	t1 = inf_expr(&n->r.right->l.left);
+	t2 = inf_expr(&n->r.right->r.right);
+	return (n->mod == T_MIXED && t1 == t2) ? t1 : n->mod;
+
+    case N_RANGE:
+	inf_expr(&n->l.left);
+	inf_expr(&n->r.right->l.left);
+	inf_expr(&n->r.right->r.right);
+	return n->mod;
+
+    case N_AGGR:
+	for (l = &n->l.left; *l != (node *) NULL; l = &(*l)->r.right) {
+	    if ((*l)->type != N_PAIR) {
+		break;
+	    }
+	    if (n->mod == T_MAPPING) {
+		inf_expr(&(*l)->l.left->l.left);
+		inf_expr(&(*l)->l.left->r.right);
+	    } else {
+		inf_expr(&(*l)->l.left);
+	    }
+	}
+	if (*l != (node *) NULL) {
+	    if (n->mod == T_MAPPING) {
+		inf_expr(&(*l)->l.left);
+		inf_expr(&(*l)->r.right);
+	    } else {
+		inf_expr(l);
+	    }
+	}
+	return n->mod;
+
+    case N_FUNC:
+	for (l = &n->l.left->r.right; *l != (node *) NULL;
+	     l = &(*l)->r.right) {
+	    if ((*l)->type != N_PAIR) {
+		inf_expr(l);
+		break;
+	    }
+	    inf_expr(&(*l)->l.left);
+	}
+	return n->mod;
+
+    case N_ASSIGN:
+	t1 = inf_expr(&n->r.right);
+	if (n->l.left->type == N_AGGR) {
+	    inf_store(n->l.left, T_MIXED);
+	    return n->mod;
+	}
+	inf_store(n->l.left, t1);
+	return (n->mod == T_MIXED) ? t1 : n->mod;
+
+    case N_ADD_EQ:
+    case N_ADD_EQ_INT:
+    case N_ADD_EQ_FLOAT:
+    case N_AND_EQ:
+    case N_AND_EQ_INT:
+    case N_DIV_EQ:
+    case N_DIV_EQ_INT:
+    case N_DIV_EQ_FLOAT:
+    case N_LSHIFT_EQ:
+    case N_LSHIFT_EQ_INT:
+    case N_MOD_EQ:
+    case N_MOD_EQ_INT:
+    case N_MULT_EQ:
+    case N_MULT_EQ_INT:
+    case N_MULT_EQ_FLOAT:
+    case N_OR_EQ:
+    case N_OR_EQ_INT:
+    case N_RSHIFT_EQ:
+    case N_RSHIFT_EQ_INT:
+    case N_SUB_EQ:
+    case N_SUB_EQ_INT:
+    case N_SUB_EQ_FLOAT:
+    case N_SUM_EQ:
+    case N_XOR_EQ:
+    case N_XOR_EQ_INT:
+	return inf_asgnop(n, inf_expr(&n->r.right), FALSE);
+
+    case N_ADD_EQ_1:
+    case N_ADD_EQ_1_INT:
+    case N_ADD_EQ_1_FLOAT:
+    case N_MIN_MIN:
+    case N_MIN_MIN_INT:
+    case N_MIN_MIN_FLOAT:
+    case N_PLUS_PLUS:
+    case N_PLUS_PLUS_INT:
+    case N_PLUS_PLUS_FLOAT:
+    case N_SUB_EQ_1:
+    case N_SUB_EQ_1_INT:
+    case N_SUB_EQ_1_FLOAT:
+	return inf_asgnop(n, T_MIXED, TRUE);
+    }
+
+    inffail = TRUE;
+    return T_MIXED;
+}
+
+/*
+ * NAME:	infer->stmt()
+ * DESCRIPTION:	infer types in a list of statements
+ */
+static void inf_stmt(node *n)
+{
+    node *m;
+
+    while (n != (node *) NULL) {
+	if (n->type == N_PAIR) {
+	    m = n->l.left;
+	    n = n->r.right;
+	} else {
+	    m = n;
+	    n = (node *) NULL;
+	}
+	switch (m->type) {
+	case N_BLOCK:
+	case N_CASE:
+	    inf_stmt(m->l.left);
+	    break;
+
+	case N_CATCH:
+	case N_COMPOUND:
+	    inf_stmt(m->l.left);
+	    inf_stmt(m->r.right);
+	    break;
+
+	case N_DO:
+	    /* break or continue can skip assignments in the body */
+	    infcond++;
+	    inf_stmt(m->r.right);
+	    --infcond;
+	    inf_expr(&m->l.left);
+	    break;
+
+	case N_FOR:
+	case N_FOREVER:
+	    inf_expr(&m->l.left);
+	    inf_stmt(m->r.right);
+	    break;
+
+	case N_RLIMITS:
+	    inf_expr(&m->l.left->l.left);
+	    inf_expr(&m->l.left->r.right);
+	    inf_stmt(m->r.right);
+	    break;
+
+	case N_IF:
+	    inf_expr(&m->l.left);
+	    inf_stmt(m->r.right->l.left);
+	    inf_stmt(m->r.right->r.right);
+	    break;
+
+	case N_PAIR:
+	    inf_stmt(m);
+	    break;
+
+	case N_POP:
+	case N_RETURN:
+	    inf_expr(&m->l.left);
+	    break;
+
+	case N_SWITCH_INT:
+	case N_SWITCH_RANGE:
+	case N_SWITCH_STR:
+	    inf_expr(&m->r.right->l.left);
+	    inf_stmt(m->r.right->r.right);
+	    break;
+	}
+    }
+}
+
+/*
+ * NAME:	infer->function()
+ * DESCRIPTION:	infer the types of mixed local variables in a typechecked
+ *		function, and rewrite the function body accordingly
+ */
+static void inf_function(node *n, int nargs)
+{
+    int i;
+
+    /*
+     * Only assignments can change the type of a local variable, and the
+     * compiler guarantees that each variable is assigned before use.
+     * Start optimistically, then settle with unassigned variables mixed.
+     */
+    for (i = 0; i < MAX_LOCALS; i++) {
+	vtypes[i] = (i < nargs) ? T_MIXED : T_VOID;
+    }
+    inffail = FALSE;
+    infcond = 0;
+    do {
+	infchanged = FALSE;
+	inf_stmt(n);
+    } while (infchanged && !inffail);
+    for (i = nargs; i < MAX_LOCALS; i++) {
+	if (vtypes[i] == T_VOID) {
+	    vtypes[i] = T_MIXED;
+	}
+    }
+    do {
+	infchanged = FALSE;
+	inf_stmt(n);
+    } while (infchanged && !inffail);
+
+    if (!inffail) {
+	infrewrite = TRUE;
+	inf_stmt(n);
+	infrewrite = FALSE;
+    }
+}
+
+/*
+ * NAME:	optimize->function()
+ * DESCRIPTION:	prepare for optimizing a function body, which is not yet
+ *		modified
+ */
+void opt_function(node *n, int index, char *proto, int typechecked)
+{
+    node *m, *s, *a;
+    int nargs, i;
+    char *args;
+    Uint size;
+    inlfunc *f;
+
+    growth = 0;
+    noinline = (node *) NULL;
+    for (i = 0; i < MAX_LOCALS; i++) {
+	cvinit[i] = cvars[i] = (node *) NULL;
+    }
+    if (n == (node *) NULL || n->type != N_COMPOUND) {
+	return;
+    }
+    nargs = PROTO_NARGS(proto) + PROTO_VARGS(proto);
+    if (typechecked) {
+	inf_function(n, nargs);
+    }
+
+    /*
+     * Find local variables which are assigned a constant only once, in a
+     * top-level statement that cannot be jumped over.
+     */
+    if (!(n->l.left->flags & F_LABEL)) {
+	for (m = n->l.left; m != (node *) NULL; ) {
+	    if (m->type == N_PAIR) {
+		s = m->l.left;
+		m = m->r.right;
+	    } else {
+		s = m;
+		m = (node *) NULL;
+	    }
+	    if (s->type != N_POP || s->l.left->type != N_ASSIGN) {
+		continue;
+	    }
+	    a = s->l.left;
+	    if (a->l.left->type != N_LOCAL) {
+		continue;
+	    }
+	    i = a->l.left->r.number;
+	    if (i < nargs || c_vassigned(i) != 1) {
+		continue;
+	    }
+	    switch (a->r.right->type) {
+	    case N_FLOAT:
+	    case N_INT:
+	    case N_STR:
+		if (a->r.right->mod == a->l.left->mod ||
+		    a->l.left->mod == T_MIXED) {
+		    cvinit[i] = a->r.right;
+		}
+		break;
+	    }
+	}
+    }
+
+    /*
+     * Keep a copy of functions that only return a simple expression.
+     */
+    f = &inlines[index];
+    if (f->body != (node *) NULL) {
+	inl_del(f);
+    }
+    if (n->r.right != (node *) NULL || n->l.left->type != N_RETURN ||
+	(PROTO_CLASS(proto) & (C_ATOMIC | C_ELLIPSIS)) ||
+	PROTO_VARGS(proto) != 0 || nargs > INLINE_ARGS) {
+	return;
+    }
+    i = PROTO_FTYPE(proto);
+    if ((i & T_TYPE) == T_CLASS || i == T_VOID) {
+	return;
+    }
+    args = PROTO_ARGS(proto);
+    for (i = 0; i < nargs; i++) {
+	if ((args[i] & T_TYPE) == T_CLASS) {
+	    return;
+	}
+	f->args[i] = args[i];
+    }
+    n = n->l.left->l.left;
+    size = inl_size(n, nargs);
+    if (size <= INLINE_SIZE) {
+	m = f->body = ALLOC(node, size);
+	inl_copy(n, &m, (node **) NULL, 0);
+	f->size = size;
+	f->nargs = nargs;
+    }
+}
+
+/*
+ * NAME:	optimize->inline()
+ * DESCRIPTION:	inline a call to a function in the new object, with the
+ *		arguments evaluated into temporary local variables
+ */
+static bool opt_inline(node **m)
+{
+    node *n, *a, *v, *side, *argv[INLINE_ARGS];
+    inlfunc *f;
+    int i, t;
+    bool simple;
+
+    n = *m;
+    if (n == noinline || (i=ctrl_dfcall(n->r.number)) < 0) {
+	return FALSE;
+    }
+    f = &inlines[i];
+    if (f->body == (node *) NULL || f->body->mod != n->mod ||
+	growth + f->size > INLINE_GROWTH) {
+	return FALSE;
+    }
+
+    /* match the arguments */
+    a = n->l.left->r.right;
+    simple = TRUE;
+    for (i = 0; i < f->nargs; i++) {
+	if (a == (node *) NULL) {
+	    return FALSE;
+	}
+	if (a->type == N_PAIR) {
+	    argv[i] = a->l.left;
+	    a = a->r.right;
+	} else {
+	    argv[i] = a;
+	    a = (node *) NULL;
+	}
+	if (argv[i]->type == N_SPREAD ||
+	    (f->args[i] != T_MIXED && argv[i]->mod != f->args[i])) {
+	    return FALSE;
+	}
+	switch (argv[i]->type) {
+	case N_FLOAT:
+	case N_INT:
+	case N_NIL:
+	case N_STR:
+	case N_LOCAL:
+	    break;
+
+	default:
+	    simple = FALSE;
+	    break;
+	}
+    }
+    if (a != (node *) NULL) {
+	return FALSE;
+    }
+
+    /*
+     * Constants are substituted.  Other arguments are evaluated in order,
+     * unless they are all local variables which the inlined expression
+     * cannot modify.
+     */
+    side = (node *) NULL;
+    for (i = 0; i < f->nargs; i++) {
+	a = argv[i];
+	switch (a->type) {
+	case N_LOCAL:
+	    if (simple) {
+		continue;
+	    }
+	    break;
+
+	case N_FLOAT:
+	case N_INT:
+	case N_NIL:
+	case N_STR:
+	    continue;
+	}
+
+	t = c_tmpvar();
+	if (t < 0) {
+	    return FALSE;
+	}
+	v = node_mon(N_LOCAL, f->args[i], (node *) NULL);
+	v->line = n->line;
+	v->r.number = t;
+	argv[i] = v;
+	a = node_bin(N_ASSIGN, v->mod, v, a);
+	a->line = n->line;
+	if (side != (node *) NULL) {
+	    a = node_bin(N_COMMA, a->mod, side, a);
+	    a->line = n->line;
+	}
+	side = a;
+    }
+
+    growth += f->size;
+    a = inl_copy(f->body, (node **) NULL, argv, n->line);
+    if (side != (node *) NULL) {
+	a = node_bin(N_COMMA, a->mod, side, a);
+	a->line = n->line;
+    }
+    *m = a;
+    return TRUE;
+}
+
+/*
+ * NAME:	optimize->clear()
+ * DESCRIPTION:	forget about inlinable functions
+ */
+void opt_clear()
+{
+    inlfunc *f;
+    int i;
+
+    for (f = inlines, i = 256; i != 0; f++, --i) {
+	if (f->body != (node *) NULL) {
+	    inl_del(f);
+	}
+    }
 }
 
 static Uint opt_expr (node**, bool);
@@ -156,6 +1134,8 @@ static Uint opt_lvalue(node *n)
 			opt_expr(&n->r.right, FALSE) + 3);
 
 	default:
+	    /* the indexed value must not become an lvalue itself */
+	    noinline = m;
 	    return max2(opt_expr(&n->l.left, FALSE),
 			opt_expr(&n->r.right, FALSE) + 1);
 	}
@@ -1406,10 +2386,16 @@ static Uint opt_expr(node **m, bool pop)
 
     n = *m;
     switch (n->type) {
+    case N_LOCAL:
+	if (cvars[n->r.number] != (node *) NULL) {
+	    /* local variable with a constant value */
+	    *m = inl_copy(cvars[n->r.number], (node **) NULL, (node **) NULL,
+			  n->line);
+	}
+	/* fall through */
     case N_FLOAT:
     case N_GLOBAL:
     case N_INT:
-    case N_LOCAL:
     case N_STR:
     case N_NIL:
 	return !pop;
@@ -1504,6 +2490,15 @@ static Uint opt_expr(node **m, bool pop)
 	return opt_lvalue(n->l.left) + 1;
 
     case N_FUNC:
+	if (opt_inline(m)) {
+	    /* keep argument evaluation in place */
+	    oldside = side_start(&side, &olddepth);
+	    d1 = opt_expr(m, pop);
+	    if (d1 == 0 && side != (node *) NULL) {
+		*m = (node *) NULL;
+	    }
+	    return max2(d1, side_end(m, side, oldside, olddepth));
+	}
 	m = &n->l.left->r.right;
 	n = *m;
 	if (n == (node *) NULL) {
@@ -1633,8 +2628,9 @@ static Uint opt_expr(node **m, bool pop)
 		n->r.right->l.number >= (long) n->l.left->l.string->len) {
 		return 2;
 	    }
-	    node_toint(n, (Int) str_index(n->l.left->l.string,
-					  (long) n->r.right->l.number));
+	    node_toint(n, (Int) UCHAR(n->l.left->l.string->text[
+			  str_index(n->l.left->l.string,
+				    (long) n->r.right->l.number)]));
 	    return !pop;
 	}
 	if (n->l.left->type == N_FUNC && n->r.right->mod == T_INT) {
@@ -2247,12 +3243,22 @@ node *opt_stmt(node *first, Uint *depth)
 	    break;
 
 	case N_POP:
+	    i = -1;
+	    if (n->l.left->type == N_ASSIGN &&
+		n->l.left->l.left->type == N_LOCAL &&
+		cvinit[n->l.left->l.left->r.number] == n->l.left->r.right) {
+		/* the constant value of the variable applies from here on */
+		i = n->l.left->l.left->r.number;
+	    }
 	    side_start(&side, depth);
 	    d1 = opt_expr(&n->l.left, TRUE);
 	    if (d1 == 0) {
 		n->l.left = (node *) NULL;
 	    }
 	    d = max3(d, d1, side_end(&n->l.left, side, (node **) NULL, 0));
+	    if (i >= 0) {
+		cvars[i] = cvinit[i];
+	    }
 	    if (n->l.left == (node *) NULL) {
 		n = (node *) NULL;
 	    }
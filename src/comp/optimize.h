@@ -18,4 +18,6 @@
  */
 
 extern void  opt_init	();
+extern void  opt_function(node*, int, char*, int);
 extern node *opt_stmt	(node*, Uint*);
+extern void  opt_clear	();
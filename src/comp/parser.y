@@ -213,7 +213,7 @@ function_declaration
 	  compound_stmt
 		{
 		  if (nerrors == 0) {
-		      c_funcbody($5);
+		      c_funcbody($5, typechecking);
 		  }
 		}
 	| class_specifier_list ident '(' formals_declaration ')'
@@ -226,7 +226,7 @@ function_declaration
 	  compound_stmt
 		{
 		  if (nerrors == 0) {
-		      c_funcbody($7);
+		      c_funcbody($7, typechecking);
 		  }
 		}
 	;
@@ -30,6 +30,7 @@
 # include "editor.h"
 # include "call_out.h"
 # include "comm.h"
+# include "stats.h"
 # include "version.h"
 # include "macro.h"
 # include "token.h"
@@ -65,70 +66,86 @@ static config conf[] = {
 # define CACHE_SIZE	3
 				{ "cache_size",		INT_CONST, FALSE, FALSE,
 							1, UINDEX_MAX },
-# define CALL_OUTS	4
+# define CALL_CACHE	4
+				{ "call_cache",		INT_CONST, FALSE, FALSE,
+							0, 65536 },
+# define CALL_OUTS	5
 				{ "call_outs",		INT_CONST, FALSE, FALSE,
 							0, UINDEX_MAX - 1 },
-# define CREATE		5
+# define CREATE		6
 				{ "create",		STRING_CONST },
-# define DATAGRAM_PORT	6
+# define DATAGRAM_PORT	7
 				{ "datagram_port",	'[', FALSE, FALSE,
 							1, USHRT_MAX },
-# define DATAGRAM_USERS	7
+# define DATAGRAM_USERS	8
 				{ "datagram_users",	INT_CONST, FALSE, FALSE,
 							0, EINDEX_MAX },
-# define DIRECTORY	8
+# define DIRECTORY	9
 				{ "directory",		STRING_CONST },
-# define DRIVER_OBJECT	9
+# define DRIVER_OBJECT	10
 				{ "driver_object",	STRING_CONST, TRUE },
-# define DUMP_FILE	10
+# define DUMP_FILE	11
 				{ "dump_file",		STRING_CONST },
-# define DUMP_INTERVAL	11
+# define DUMP_INTERVAL	12
 				{ "dump_interval",	INT_CONST },
-# define DYNAMIC_CHUNK	12
+# define DYNAMIC_CHUNK	13
 				{ "dynamic_chunk",	INT_CONST, FALSE, FALSE,
 							1024 },
-# define ED_TMPFILE	13
+# define ED_MEMORY	14
+				{ "ed_memory",		INT_CONST },
+# define ED_TMPFILE	15
 				{ "ed_tmpfile",		STRING_CONST },
-# define EDITORS	14
+# define EDITORS	16
 				{ "editors",		INT_CONST, FALSE, FALSE,
 							0, EINDEX_MAX },
-# define HOTBOOT	15
+# define HOTBOOT	17
 				{ "hotboot",		'(' },
-# define INCLUDE_DIRS	16
+# define INCLUDE_DIRS	18
 				{ "include_dirs",	'(' },
-# define INCLUDE_FILE	17
+# define INCLUDE_FILE	19
 				{ "include_file",	STRING_CONST, TRUE },
-# define MODULES	18
+# define MODULES	20
 				{ "modules",		']' },
-# define OBJECTS	19
+# define OBJECTS	21
 				{ "objects",		INT_CONST, FALSE, FALSE,
 							2, UINDEX_MAX },
-# define PORTS		20
+# define PORTS		22
 				{ "ports",		INT_CONST, FALSE, FALSE,
 							1, 32 },
-# define SECTOR_SIZE	21
+# define SECTOR_SIZE	23
 				{ "sector_size",	INT_CONST, FALSE, FALSE,
 							512, 65535 },
-# define STATIC_CHUNK	22
+# define STATIC_CHUNK	24
 				{ "static_chunk",	INT_CONST },
-# define SWAP_FILE	23
+# define STATISTICS_FILE	25
+				{ "statistics_file",	STRING_CONST },
+# define STATISTICS_INTERVAL 26
+				{ "statistics_interval", INT_CONST, FALSE, FALSE,
+							1, 86400 },
+# define STRING_POOL	27
+				{ "string_pool",	INT_CONST, FALSE, FALSE,
+							0, 65536 },
+# define SWAP_FILE	28
 				{ "swap_file",		STRING_CONST },
-# define SWAP_FRAGMENT	24
+# define SWAP_FRAGMENT	29
 				{ "swap_fragment",	INT_CONST, FALSE, FALSE,
 							0, SW_UNUSED },
-# define SWAP_SIZE	25
+# define SWAP_MEMORY	30
+				{ "swap_memory",	INT_CONST, FALSE, FALSE,
+							1 },
+# define SWAP_SIZE	31
 				{ "swap_size",		INT_CONST, FALSE, FALSE,
 							1024, SW_UNUSED },
-# define TELNET_PORT	26
+# define TELNET_PORT	32
 				{ "telnet_port",	'[', FALSE, FALSE,
 							1, USHRT_MAX },
-# define TYPECHECKING	27
+# define TYPECHECKING	33
 				{ "typechecking",	INT_CONST, FALSE, FALSE,
 							0, 2 },
-# define USERS		28
+# define USERS		34
 				{ "users",		INT_CONST, FALSE, FALSE,
 							0, EINDEX_MAX },
-# define NR_OPTIONS	29
+# define NR_OPTIONS	35
 };
 
 
@@ -138,7 +155,7 @@ struct aligni { char fill; Int i;	};
 struct alignp { char fill; char *p;	};
 struct alignz { char c;			};
 
-# define FORMAT_VERSION	15
+# define FORMAT_VERSION	16
 
 # define DUMP_VALID	0	/* valid dump flag */
 # define DUMP_VERSION	1	/* snapshot version number */
@@ -302,6 +319,9 @@ void conf_dump(bool incr, bool boot)
     if (!kf_dump(fd)) {
 	fatal("failed to dump kfun table");
     }
+    if (!d_dump_frozen(fd)) {
+	fatal("failed to dump frozen array table");
+    }
     if (!o_dump(fd, incr)) {
 	fatal("failed to dump object table");
     }
@@ -429,6 +449,9 @@ static bool conf_restore(int fd, int fd2)
 
     sw_restore(fd, secsize);
     kf_restore(fd);
+    if (rheader[DUMP_VERSION] >= 16) {
+	d_restore_frozen(fd);
+    }
     o_restore(fd, rdflags & FLAGS_PARTIAL);
     d_init_conv(conv_14);
     if (conv_14) {
@@ -438,6 +461,7 @@ static bool conf_restore(int fd, int fd2)
     co_restore(fd, boottime);
 
     if (fd2 >= 0) {
+	sw_restore2(-1);
 	P_close(fd2);
     }
 
@@ -1075,7 +1099,9 @@ static bool conf_config()
 
     for (l = 0; l < NR_OPTIONS; l++) {
 	if (!conf[l].set && l != HOTBOOT && l != MODULES && l != CACHE_SIZE &&
-	    l != DATAGRAM_PORT && l != DATAGRAM_USERS) {
+	    l != DATAGRAM_PORT && l != DATAGRAM_USERS && l != SWAP_MEMORY &&
+	    l != STATISTICS_FILE && l != STATISTICS_INTERVAL &&
+	    l != ED_MEMORY && l != CALL_CACHE && l != STRING_POOL) {
 	    char buffer[64];
 
 #ifndef NETWORK_EXTENSIONS
@@ -1218,6 +1244,7 @@ static bool conf_includes()
     cputs("# define ST_DATAGRAMPORTS\t24\t/* datagram ports */\012");
     cputs("# define ST_TELNETPORTS\t25\t/* telnet ports */\012");
     cputs("# define ST_BINARYPORTS\t26\t/* binary ports */\012");
+    cputs("# define ST_DATAGRAMSTATS\t27\t/* datagrams received, sent, dropped, failed */\012");
 
     cputs("\012# define O_COMPILETIME\t0\t/* time of compilation */\012");
     cputs("# define O_PROGSIZE\t1\t/* program size of object */\012");
@@ -1226,6 +1253,11 @@ static bool conf_includes()
     cputs("# define O_CALLOUTS\t4\t/* callouts in object */\012");
     cputs("# define O_INDEX\t5\t/* unique ID for master object */\012");
     cputs("# define O_UNDEFINED\t6\t/* undefined functions */\012");
+    cputs("# define O_SWAPINS\t7\t/* # times loaded from swap */\012");
+    cputs("# define O_SWAPOUTS\t8\t/* # times swapped out */\012");
+    cputs("# define O_DATAMEM\t9\t/* bytes of dataspace in memory */\012");
+    cputs("# define O_PROGMEM\t10\t/* bytes of program in memory */\012");
+    cputs("# define O_SWAPSIZE\t11\t/* bytes in swap */\012");
 
     cputs("\012# define CO_HANDLE\t0\t/* callout handle */\012");
     cputs("# define CO_FUNCTION\t1\t/* function name */\012");
@@ -1495,11 +1527,19 @@ bool conf_init(char *configfile, char *snapshot, char *snapshot2, char *module,
 	return FALSE;
     }
 
+    /* initialize strings */
+    if (conf[STRING_POOL].set) {
+	str_pool_init((unsigned int) conf[STRING_POOL].u.num);
+    }
+
     /* initialize arrays */
     arr_init((int) conf[ARRAY_SIZE].u.num);
 
     /* initialize objects */
     o_init((uindex) conf[OBJECTS].u.num, (Uint) conf[DUMP_INTERVAL].u.num);
+    if (conf[CALL_CACHE].set) {
+	o_pcache_init((unsigned int) conf[CALL_CACHE].u.num);
+    }
 
     /* initialize swap device */
     cache = (sector) ((conf[CACHE_SIZE].set) ? conf[CACHE_SIZE].u.num : 100);
@@ -1507,12 +1547,13 @@ bool conf_init(char *configfile, char *snapshot, char *snapshot2, char *module,
 	    (unsigned int) conf[SECTOR_SIZE].u.num);
 
     /* initialize swapped data handler */
-    d_init();
+    d_init((uindex) conf[OBJECTS].u.num, (Uint) conf[SWAP_MEMORY].u.num);
     *fragment = conf[SWAP_FRAGMENT].u.num;
 
     /* initalize editor */
     ed_init(conf[ED_TMPFILE].u.str,
-	    (int) conf[EDITORS].u.num);
+	    (int) conf[EDITORS].u.num,
+	    (conf[ED_MEMORY].set) ? (size_t) conf[ED_MEMORY].u.num : 0);
 
     /* initialize call_outs */
     if (!co_init((uindex) conf[CALL_OUTS].u.num)) {
@@ -1532,6 +1573,12 @@ bool conf_init(char *configfile, char *snapshot, char *snapshot2, char *module,
     /* initialize interpreter */
     i_init(conf[CREATE].u.str, conf[TYPECHECKING].u.num == 2);
 
+    /* initialize statistics */
+    st_init((conf[STATISTICS_FILE].set) ?
+	     conf[STATISTICS_FILE].u.str : (char *) NULL,
+	    (conf[STATISTICS_INTERVAL].set) ?
+	     (unsigned int) conf[STATISTICS_INTERVAL].u.num : 10);
+
     /* initialize compiler */
     c_init(conf[AUTO_OBJECT].u.str,
 	   conf[DRIVER_OBJECT].u.str,
@@ -1777,7 +1824,7 @@ bool conf_statusi(Frame *f, Int idx, Value *v)
 	break;
 
     case 13:	/* ST_OTABSIZE */
-	PUT_INTVAL(v, conf[OBJECTS].u.num);
+	PUT_INTVAL(v, o_tabsize());
 	break;
 
     case 14:	/* ST_NOBJECTS */
@@ -1785,7 +1832,7 @@ bool conf_statusi(Frame *f, Int idx, Value *v)
 	break;
 
     case 15:	/* ST_COTABSIZE */
-	PUT_INTVAL(v, conf[CALL_OUTS].u.num);
+	PUT_INTVAL(v, co_tabsize());
 	break;
 
     case 16:	/* ST_NCOSHORT */
@@ -1846,6 +1893,23 @@ bool conf_statusi(Frame *f, Int idx, Value *v)
 	}
 	break;
 
+    case 27:	/* ST_DATAGRAMSTATS */
+	a = arr_new(f->data, (long) ndports);
+	PUT_ARRVAL(v, a);
+	for (i = 0, v = a->elts; i < ndports; i++, v++) {
+	    Uint received, sent, dropped, failed;
+	    Array *s;
+
+	    conn_udpcount(i, &received, &sent, &dropped, &failed);
+	    s = arr_new(f->data, 4L);
+	    PUT_ARRVAL(v, s);
+	    PUT_INTVAL(&s->elts[0], received);
+	    PUT_INTVAL(&s->elts[1], sent);
+	    PUT_INTVAL(&s->elts[2], dropped);
+	    PUT_INTVAL(&s->elts[3], failed);
+	}
+	break;
+
     default:
 	return FALSE;
     }
@@ -1865,8 +1929,8 @@ Array *conf_status(Frame *f)
 
     try {
 	ec_push((ec_ftn) NULL);
-	a = arr_ext_new(f->data, 27L);
-	for (i = 0, v = a->elts; i < 27; i++, v++) {
+	a = arr_ext_new(f->data, 28L);
+	for (i = 0, v = a->elts; i < 28; i++, v++) {
 	    conf_statusi(f, i, v);
 	}
 	ec_pop();
@@ -1888,6 +1952,8 @@ bool conf_objecti(Dataspace *data, Object *obj, Int idx, Value *v)
     Control *ctrl;
     Object *prog;
     Array *a;
+    Uint swapins, swapouts;
+    Uint datamem, progmem, swapsize;
 
     prog = (obj->flags & O_MASTER) ? obj : OBJR(obj->u_master);
     ctrl = (O_UPGRADING(prog)) ? OBJR(prog->prev)->ctrl : o_control(prog);
@@ -1938,6 +2004,31 @@ bool conf_objecti(Dataspace *data, Object *obj, Int idx, Value *v)
 	}
 	break;
 
+    case 7:	/* O_SWAPINS */
+	d_swapstat(obj, &swapins, &swapouts);
+	PUT_INTVAL(v, swapins);
+	break;
+
+    case 8:	/* O_SWAPOUTS */
+	d_swapstat(obj, &swapins, &swapouts);
+	PUT_INTVAL(v, swapouts);
+	break;
+
+    case 9:	/* O_DATAMEM */
+	d_memstat(obj, &datamem, &progmem, &swapsize);
+	PUT_INTVAL(v, datamem);
+	break;
+
+    case 10:	/* O_PROGMEM */
+	d_memstat(obj, &datamem, &progmem, &swapsize);
+	PUT_INTVAL(v, progmem);
+	break;
+
+    case 11:	/* O_SWAPSIZE */
+	d_memstat(obj, &datamem, &progmem, &swapsize);
+	PUT_INTVAL(v, swapsize);
+	break;
+
     default:
 	return FALSE;
     }
@@ -1955,10 +2046,10 @@ Array *conf_object(Dataspace *data, Object *obj)
     Int i;
     Array *a;
 
-    a = arr_ext_new(data, 7L);
+    a = arr_ext_new(data, 12L);
     try {
 	ec_push((ec_ftn) NULL);
-	for (i = 0, v = a->elts; i < 7; i++, v++) {
+	for (i = 0, v = a->elts; i < 12; i++, v++) {
 	    conf_objecti(data, obj, i, v);
 	}
 	ec_pop();
@@ -1971,6 +2062,76 @@ Array *conf_object(Dataspace *data, Object *obj)
     return a;
 }
 
+struct memuse {
+    Uint size;			/* bytes in memory */
+    uindex index;		/* object index */
+};
+
+/*
+ * NAME:	cmpmem()
+ * DESCRIPTION:	compare memory usage, largest first
+ */
+static int cmpmem(const void *cv1, const void *cv2)
+{
+    const memuse *m1, *m2;
+
+    m1 = (const memuse *) cv1;
+    m2 = (const memuse *) cv2;
+    if (m1->size != m2->size) {
+	return (m1->size > m2->size) ? -1 : 1;
+    }
+    return (m1->index < m2->index) ? -1 : (m1->index > m2->index);
+}
+
+/*
+ * NAME:	config->memtop()
+ * DESCRIPTION:	return the n objects that use the most memory for their
+ *		dataspace and program, largest first
+ */
+Array *conf_memtop(Dataspace *data, Int n)
+{
+    memuse *list, *m;
+    uindex i, size, count;
+    Uint datamem, progmem, swapsize;
+    Object *obj;
+    Array *a;
+    Value *v;
+
+    size = o_tabsize();
+    list = ALLOC(memuse, (size != 0) ? size : 1);
+    for (i = count = 0, m = list; i < size; i++) {
+	obj = OBJR(i);
+	if (obj->count != 0) {
+	    d_memstat(obj, &datamem, &progmem, &swapsize);
+	    if (datamem + progmem != 0) {
+		m->size = datamem + progmem;
+		m->index = i;
+		m++;
+		count++;
+	    }
+	}
+    }
+    qsort(list, count, sizeof(memuse), cmpmem);
+
+    if (n > count) {
+	n = count;
+    }
+    try {
+	ec_push((ec_ftn) NULL);
+	a = arr_new(data, (long) n);
+	ec_pop();
+    } catch (...) {
+	FREE(list);
+	error((char *) NULL);
+    }
+    for (m = list, v = a->elts; n > 0; --n, m++, v++) {
+	PUT_OBJVAL(v, OBJR(m->index));
+    }
+    FREE(list);
+
+    return a;
+}
+
 
 /*
  * NAME:	strtoint()
@@ -46,11 +46,9 @@ typedef unsigned char kfindex;
 # define BUF_SIZE	FS_BLOCK_SIZE	/* I/O buffer size */
 # define MAX_LINE_SIZE	1024	/* max. line size in ed and lex (power of 2) */
 # define STRINGSZ	256	/* general (internal) string size */
-# define STRMAPHASHSZ	20	/* # characters to hash of map string indices */
 # define STRMERGETABSZ	1024	/* general string merge table size */
-# define STRMERGEHASHSZ	20	/* # characters in merge strings to hash */
 # define ARRMERGETABSZ	1024	/* general array merge table size */
-# define OBJHASHSZ	256	/* # characters in object names to hash */
+# define OBJHASHSZ	0	/* # characters in object names to hash, 0: all */
 # define COPATCHHTABSZ	64	/* callout patch hash table size */
 # define OBJPATCHHTABSZ	128	/* object patch hash table size */
 # define CMPLIMIT	2048	/* compress strings if >= CMPLIMIT */
@@ -60,10 +58,14 @@ typedef unsigned char kfindex;
 # define INBUF_SIZE	2048	/* telnet input buffer size */
 # define OUTBUF_SIZE	8192	/* telnet output buffer size */
 # define BINBUF_SIZE	8192	/* binary/UDP input buffer size */
+# define OUTCHUNK_SIZE	4096	/* output chunk size */
+# define OUTCHUNKS	32	/* max # output chunks per user */
 # define UDPHASHSZ	10	/* # characters in UDP challenge to hash */
 
 /* swap */
 # define SWAPCHUNK	(128 * 1024 * 1024)
+# define SWAPREUSE	64	/* reloaded within # swapouts: still in use */
+# define SWAPCREDIT	4	/* max # times to skip a reused object */
 
 /* interpreter */
 # define MIN_STACK	5	/* minimal stack, # arguments in driver calls */
@@ -114,6 +116,7 @@ extern bool   conf_statusi	(Frame*, Int, Value*);
 extern Array *conf_status	(Frame*);
 extern bool   conf_objecti	(Dataspace*, Object*, Int, Value*);
 extern Array *conf_object	(Dataspace*, Object*);
+extern Array *conf_memtop	(Dataspace*, Int);
 
 /* utility functions */
 extern Int strtoint		(char**);
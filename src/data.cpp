@@ -60,6 +60,141 @@ public:
     copatch *cop[COPATCHHTABSZ];	/* hash table of callout patches */
 };
 
+struct refbak {
+    arrref *aref;		/* array ref, or NULL */
+    strref *sref;		/* string ref, or NULL */
+    union {
+	arrref arr;		/* original array ref */
+	strref str;		/* original string ref */
+    } u;
+};
+
+# define RBCHUNKSZ	32
+
+class rbchunk : public Chunk<refbak, RBCHUNKSZ> {
+public:
+    /*
+     * NAME:		backup()
+     * DESCRIPTION:	add an array or string ref backup to the backup chunk
+     */
+    static void backup(rbchunk **rc, arrref *a, strref *s) {
+	refbak *rb;
+
+	if (*rc == (rbchunk *) NULL) {
+	    *rc = new rbchunk;
+	}
+
+	rb = (*rc)->alloc();
+	rb->aref = a;
+	rb->sref = s;
+	if (a != (arrref *) NULL) {
+	    rb->u.arr = *a;
+	    arr_ref(a->arr);
+	} else {
+	    rb->u.str = *s;
+	    str_ref(s->str);
+	}
+    }
+
+    /*
+     * NAME:		item()
+     * DESCRIPTION:	commit or discard when iterating over items
+     */
+    virtual bool item(refbak *rb) {
+	Dataplane *prev;
+
+	prev = plane->prev;
+	if (!restore) {
+	    /*
+	     * commit: keep only the oldest backup of each ref
+	     */
+	    if (rb->aref != (arrref *) NULL) {
+		Array *arr;
+
+		arr = rb->u.arr.arr;
+		if (arr->primary == &plane->alocal) {
+		    arr->primary = &prev->alocal;
+		}
+		rb->aref->level = prev->level;
+		if (rb->u.arr.level == prev->level) {
+		    arr_del(arr);
+		    return TRUE;
+		}
+	    } else {
+		rb->sref->level = prev->level;
+		if (rb->u.str.level == prev->level) {
+		    str_del(rb->u.str.str);
+		    return TRUE;
+		}
+	    }
+
+	    /* backup on previous plane */
+	    if (prev->rchunk == (rbchunk *) NULL) {
+		prev->rchunk = new rbchunk;
+	    }
+	    *prev->rchunk->alloc() = *rb;
+	} else if (rb->aref != (arrref *) NULL) {
+	    arrref *a;
+
+	    /*
+	     * discard: restore array ref
+	     */
+	    a = rb->aref;
+	    if (a->arr != (Array *) NULL) {
+		arr_del(a->arr);
+	    }
+	    *a = rb->u.arr;
+	    a->arr->primary = a;
+	} else {
+	    strref *s;
+
+	    /*
+	     * discard: restore string ref
+	     */
+	    s = rb->sref;
+	    if (s->str != (String *) NULL) {
+		str_del(s->str);
+	    }
+	    *s = rb->u.str;
+	    s->str->primary = s;
+	}
+
+	return TRUE;
+    }
+
+    /*
+     * NAME:		commit()
+     * DESCRIPTION:	commit ref backups to the previous plane
+     */
+    static void commit(Dataplane *p) {
+	if (p->rchunk != (rbchunk *) NULL) {
+	    p->rchunk->plane = p;
+	    p->rchunk->restore = FALSE;
+	    p->rchunk->items();
+	    delete p->rchunk;
+	    p->rchunk = (rbchunk *) NULL;
+	}
+    }
+
+    /*
+     * NAME:		discard()
+     * DESCRIPTION:	restore refs from backups
+     */
+    static void discard(Dataplane *p) {
+	if (p->rchunk != (rbchunk *) NULL) {
+	    p->rchunk->plane = p;
+	    p->rchunk->restore = TRUE;
+	    p->rchunk->items();
+	    delete p->rchunk;
+	    p->rchunk = (rbchunk *) NULL;
+	}
+    }
+
+private:
+    Dataplane *plane;		/* plane being committed or discarded */
+    bool restore;		/* discarding? */
+};
+
 struct arrimport {
     Array **itab;			/* imported array replacement table */
     Uint itabsz;			/* size of table */
@@ -71,6 +206,36 @@ static uindex ncallout;			/* # callouts added */
 static Dataspace *ifirst;		/* list of dataspaces with imports */
 
 
+/*
+ * NAME:	backup_arrref()
+ * DESCRIPTION:	back up an array ref before it is first changed on a plane
+ */
+static void backup_arrref(arrref *a)
+{
+    Dataplane *p;
+
+    p = a->data->plane;
+    if (a->level != p->level) {
+	rbchunk::backup(&p->rchunk, a, (strref *) NULL);
+	a->level = p->level;
+    }
+}
+
+/*
+ * NAME:	backup_strref()
+ * DESCRIPTION:	back up a string ref before it is first changed on a plane
+ */
+static void backup_strref(strref *s)
+{
+    Dataplane *p;
+
+    p = s->data->plane;
+    if (s->level != p->level) {
+	rbchunk::backup(&p->rchunk, (arrref *) NULL, s);
+	s->level = p->level;
+    }
+}
+
 /*
  * NAME:	ref_rhs()
  * DESCRIPTION:	reference the right-hand side in an assignment
@@ -85,6 +250,7 @@ static void ref_rhs(Dataspace *data, Value *rhs)
 	str = rhs->u.string;
 	if (str->primary != (strref *) NULL && str->primary->data == data) {
 	    /* in this object */
+	    backup_strref(str->primary);
 	    str->primary->ref++;
 	    data->plane->flags |= MOD_STRINGREF;
 	} else {
@@ -97,10 +263,14 @@ static void ref_rhs(Dataspace *data, Value *rhs)
     case T_MAPPING:
     case T_LWOBJECT:
 	arr = rhs->u.array;
-	if (arr->primary->data == data) {
+	if (arr->frozen) {
+	    /* ref frozen array */
+	    data->plane->achange++;
+	} else if (arr->primary->data == data) {
 	    /* in this object */
 	    if (arr->primary->arr != (Array *) NULL) {
 		/* swapped in */
+		backup_arrref(arr->primary);
 		arr->primary->ref++;
 		data->plane->flags |= MOD_ARRAYREF;
 	    } else {
@@ -139,7 +309,9 @@ static void del_lhs(Dataspace *data, Value *lhs)
 	str = lhs->u.string;
 	if (str->primary != (strref *) NULL && str->primary->data == data) {
 	    /* in this object */
+	    backup_strref(str->primary);
 	    if (--(str->primary->ref) == 0) {
+		data->memsize -= sizeof(String) + sizeof(strref) + str->len;
 		str->primary->str = (String *) NULL;
 		str->primary = (strref *) NULL;
 		str_del(str);
@@ -156,12 +328,17 @@ static void del_lhs(Dataspace *data, Value *lhs)
     case T_MAPPING:
     case T_LWOBJECT:
 	arr = lhs->u.array;
-	if (arr->primary->data == data) {
+	if (arr->frozen) {
+	    /* deref frozen array: the saved image must be rebuilt */
+	    data->plane->achange++;
+	} else if (arr->primary->data == data) {
 	    /* in this object */
 	    if (arr->primary->arr != (Array *) NULL) {
 		/* swapped in */
+		backup_arrref(arr->primary);
 		data->plane->flags |= MOD_ARRAYREF;
 		if ((--(arr->primary->ref) & ~ARR_MOD) == 0) {
+		    data->memsize -= d_arrmem(arr);
 		    d_get_elts(arr);
 		    arr->primary->arr = (Array *) NULL;
 		    arr->primary = &arr->primary->plane->alocal;
@@ -448,7 +625,6 @@ static void cop_discard(copatch *cop)
 void d_new_plane(Dataspace *data, Int level)
 {
     Dataplane *p;
-    Uint i;
 
     p = ALLOC(Dataplane, 1);
 
@@ -457,6 +633,7 @@ void d_new_plane(Dataspace *data, Int level)
     p->schange = data->plane->schange;
     p->achange = data->plane->achange;
     p->imports = data->plane->imports;
+    p->memsize = data->memsize;
 
     /* copy value information from previous plane */
     p->original = (Value *) NULL;
@@ -466,40 +643,8 @@ void d_new_plane(Dataspace *data, Int level)
     p->alocal.state = AR_CHANGED;
     p->coptab = data->plane->coptab;
 
-    if (data->plane->arrays != (arrref *) NULL) {
-	arrref *a, *b;
-
-	p->arrays = ALLOC(arrref, i = data->narrays);
-	for (a = p->arrays, b = data->plane->arrays; i != 0; a++, b++, --i) {
-	    if (b->arr != (Array *) NULL) {
-		*a = *b;
-		a->arr->primary = a;
-		arr_ref(a->arr);
-	    } else {
-		a->arr = (Array *) NULL;
-	    }
-	}
-    } else {
-	p->arrays = (arrref *) NULL;
-    }
     p->achunk = (abchunk *) NULL;
-
-    if (data->plane->strings != (strref *) NULL) {
-	strref *s, *t;
-
-	p->strings = ALLOC(strref, i = data->nstrings);
-	for (s = p->strings, t = data->plane->strings; i != 0; s++, t++, --i) {
-	    if (t->str != (String *) NULL) {
-		*s = *t;
-		s->str->primary = s;
-		str_ref(s->str);
-	    } else {
-		s->str = (String *) NULL;
-	    }
-	}
-    } else {
-	p->strings = (strref *) NULL;
-    }
+    p->rchunk = (rbchunk *) NULL;
 
     p->prev = data->plane;
     data->plane = p;
@@ -689,9 +834,8 @@ void d_commit_plane(Int level, Value *retval)
 	    commit->alocal.plane = commit;
 	    commit->alocal.data = p->alocal.data;
 	    commit->alocal.state = AR_CHANGED;
-	    commit->arrays = p->arrays;
 	    commit->achunk = p->achunk;
-	    commit->strings = p->strings;
+	    commit->rchunk = (rbchunk *) NULL;
 	    commit->coptab = p->coptab;
 	    commit->prev = p->prev;
 	    *cr = commit;
@@ -743,37 +887,7 @@ void d_commit_plane(Int level, Value *retval)
 	}
 
 	arr_commit(&p->achunk, p->prev, (p->flags & PLANE_MERGE) != 0);
-	if (p->flags & PLANE_MERGE) {
-	    if (p->arrays != (arrref *) NULL) {
-		arrref *a;
-
-		/* remove old array refs */
-		for (a = p->prev->arrays, i = data->narrays; i != 0; a++, --i) {
-		    if (a->arr != (Array *) NULL) {
-			if (a->arr->primary == &p->alocal) {
-			    a->arr->primary = &p->prev->alocal;
-			}
-			arr_del(a->arr);
-		    }
-		}
-		FREE(p->prev->arrays);
-		p->prev->arrays = p->arrays;
-	    }
-
-	    if (p->strings != (strref *) NULL) {
-		strref *s;
-
-		/* remove old string refs */
-		for (s = p->prev->strings, i = data->nstrings; i != 0; s++, --i)
-		{
-		    if (s->str != (String *) NULL) {
-			str_del(s->str);
-		    }
-		}
-		FREE(p->prev->strings);
-		p->prev->strings = p->strings;
-	    }
-	}
+	rbchunk::commit(p);
     }
     commit_values(retval, 1, level - 1);
 
@@ -873,41 +987,8 @@ void d_discard_plane(Int level)
 	}
 
 	arr_discard(&p->achunk);
-	if (p->arrays != (arrref *) NULL) {
-	    arrref *a;
-
-	    /* delete new array refs */
-	    for (a = p->arrays, i = data->narrays; i != 0; a++, --i) {
-		if (a->arr != (Array *) NULL) {
-		    arr_del(a->arr);
-		}
-	    }
-	    FREE(p->arrays);
-	    /* fix old ones */
-	    for (a = p->prev->arrays, i = data->narrays; i != 0; a++, --i) {
-		if (a->arr != (Array *) NULL) {
-		    a->arr->primary = a;
-		}
-	    }
-	}
-
-	if (p->strings != (strref *) NULL) {
-	    strref *s;
-
-	    /* delete new string refs */
-	    for (s = p->strings, i = data->nstrings; i != 0; s++, --i) {
-		if (s->str != (String *) NULL) {
-		    str_del(s->str);
-		}
-	    }
-	    FREE(p->strings);
-	    /* fix old ones */
-	    for (s = p->prev->strings, i = data->nstrings; i != 0; s++, --i) {
-		if (s->str != (String *) NULL) {
-		    s->str->primary = s;
-		}
-	    }
-	}
+	rbchunk::discard(p);
+	data->memsize = p->memsize;
 
 	data->plane = p->prev;
 	plist = p->plist;
@@ -961,7 +1042,8 @@ void d_ref_imports(Array *arr)
 
     data = arr->primary->data;
     for (n = arr->size, v = arr->elts; n > 0; --n, v++) {
-	if (T_INDEXED(v->type) && data != v->u.array->primary->data) {
+	if (T_INDEXED(v->type) && data != v->u.array->primary->data &&
+	    !v->u.array->frozen) {
 	    /* mark as imported */
 	    if (data->plane->imports++ == 0 && ifirst != data &&
 		data->iprev == (Dataspace *) NULL) {
@@ -1045,6 +1127,9 @@ void d_wipe_extravar(Dataspace *data)
  */
 void d_assign_elt(Dataspace *data, Array *arr, Value *elt, Value *val)
 {
+    if (arr->frozen) {
+	error("Frozen value cannot be modified");
+    }
     if (data->plane->level != arr->primary->data->plane->level) {
 	/*
 	 * bring dataspace of imported array up to the current plane level
@@ -1053,6 +1138,9 @@ void d_assign_elt(Dataspace *data, Array *arr, Value *elt, Value *val)
     }
 
     data = arr->primary->data;
+    if (arr->primary->arr != (Array *) NULL) {
+	backup_arrref(arr->primary);
+    }
     if (arr->primary->plane != data->plane) {
 	/*
 	 * backup array's current elements
@@ -1076,7 +1164,8 @@ void d_assign_elt(Dataspace *data, Array *arr, Value *elt, Value *val)
 	ref_rhs(data, val);
 	del_lhs(data, elt);
     } else {
-	if (T_INDEXED(val->type) && data != val->u.array->primary->data) {
+	if (T_INDEXED(val->type) && data != val->u.array->primary->data &&
+	    !val->u.array->frozen) {
 	    /* mark as imported */
 	    if (data->plane->imports++ == 0 && ifirst != data &&
 		data->iprev == (Dataspace *) NULL) {
@@ -1089,7 +1178,8 @@ void d_assign_elt(Dataspace *data, Array *arr, Value *elt, Value *val)
 		ifirst = data;
 	    }
 	}
-	if (T_INDEXED(elt->type) && data != elt->u.array->primary->data) {
+	if (T_INDEXED(elt->type) && data != elt->u.array->primary->data &&
+	    !elt->u.array->frozen) {
 	    /* mark as unimported */
 	    data->plane->imports--;
 	}
@@ -1112,6 +1202,7 @@ void d_change_map(Array *map)
 
     a = map->primary;
     if (a->state == AR_UNCHANGED) {
+	backup_arrref(a);
 	a->plane->achange++;
 	a->state = AR_CHANGED;
     }
@@ -1691,7 +1782,7 @@ static void d_import(arrimport *imp, Dataspace *data, Value *val,
     import = (Array *) NULL;
     for (;;) {
 	while (n > 0) {
-	    if (T_INDEXED(val->type)) {
+	    if (T_INDEXED(val->type) && !val->u.array->frozen) {
 		Uint i, j;
 
 		a = val->u.array;
@@ -1841,10 +1932,10 @@ void d_export()
 		if (data->variables != (Value *) NULL) {
 		    d_import(&imp, data, data->variables, data->nvariables);
 		}
-		if (data->base.arrays != (arrref *) NULL) {
+		if (data->arrays != (arrref *) NULL) {
 		    arrref *a;
 
-		    for (n = data->narrays, a = data->base.arrays; n > 0;
+		    for (n = data->narrays, a = data->arrays; n > 0;
 			 --n, a++) {
 			if (a->arr != (Array *) NULL) {
 			    if (a->arr->hashed != (struct maphash *) NULL) {
@@ -1930,6 +2021,9 @@ void d_del_dataspace(Dataspace *data)
 	    }
 	}
     }
+    if (data->flags & DATA_FROZEN) {
+	d_unref_frozen(data);
+    }
     if (data->sectors != (sector *) NULL) {
 	sw_wipev(data->sectors, data->nsectors);
 	sw_delv(data->sectors, data->nsectors);
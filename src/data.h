@@ -63,6 +63,7 @@ struct dsymbol {
 struct Control {
     Control *prev, *next;
     uindex ndata;		/* # of data blocks using this control block */
+    unsigned short credit;	/* # times to skip when swapping out */
 
     sector nsectors;		/* o # of sectors */
     sector *sectors;		/* o vector with sectors */
@@ -127,6 +128,7 @@ struct strref {
     String *str;		/* string value */
     Dataspace *data;		/* dataspace this string is in */
     Uint ref;			/* # of refs */
+    Int level;			/* plane level of last backup */
 };
 
 struct arrref {
@@ -135,6 +137,7 @@ struct arrref {
     Dataspace *data;		/* dataspace this array is in */
     short state;		/* state of mapping */
     Uint ref;			/* # of refs */
+    Int level;			/* plane level of last backup */
 };
 
 struct Value {
@@ -167,12 +170,12 @@ struct Dataplane {
     long schange;		/* # string changes */
     long achange;		/* # array changes */
     long imports;		/* # array imports */
+    long memsize;		/* memory size at start of plane */
 
     Value *original;		/* original variables */
     arrref alocal;		/* primary of new local arrays */
-    arrref *arrays;		/* i/o? arrays */
     abchunk *achunk;		/* chunk of array backup info */
-    strref *strings;		/* i/o? string constant table */
+    class rbchunk *rchunk;	/* chunk of array and string ref backup info */
     class coptable *coptab;	/* callout patch table */
 
     Dataplane *prev;		/* previous in per-dataspace linked list */
@@ -190,8 +193,10 @@ struct Dataspace {
     sector nsectors;		/* o # sectors */
 
     short flags;		/* various bitflags */
+    unsigned short credit;	/* # times to skip when swapping out */
     Control *ctrl;		/* control block */
     uindex oindex;		/* object this dataspace belongs to */
+    long memsize;		/* bytes of values in memory */
 
     unsigned short nvariables;	/* o # variables */
     Value *variables;		/* i/o variables */
@@ -199,6 +204,7 @@ struct Dataspace {
     Uint varoffset;		/* o offset of variables in data space */
 
     Uint narrays;		/* i/o # arrays */
+    arrref *arrays;		/* i/o? arrays */
     Uint eltsize;		/* o total size of array elements */
     struct sarray *sarrays;	/* o sarrays */
     Uint *saindex;		/* o sarrays index */
@@ -207,6 +213,7 @@ struct Dataspace {
     Uint arroffset;		/* o offset of array table in data space */
 
     Uint nstrings;		/* i/o # strings */
+    strref *strings;		/* i/o? string constant table */
     Uint strsize;		/* o total size of string text */
     struct sstring *sstrings;	/* o sstrings */
     Uint *ssindex;		/* o sstrings index */
@@ -230,7 +237,8 @@ struct Dataspace {
 
 /* sdata.c */
 
-extern void		d_init		 ();
+extern void		d_init		 (uindex, Uint);
+extern void		d_grow		 (uindex);
 extern void		d_init_conv	 (bool);
 
 extern Control	       *d_new_control	 ();
@@ -251,9 +259,12 @@ extern Uint		d_get_progsize	 (Control*);
 extern void		d_new_variables	 (Control*, Value*);
 extern Value	       *d_get_variable	 (Dataspace*, unsigned int);
 extern Value	       *d_get_elts	 (Array*);
+extern long		d_arrmem	 (Array*);
 extern void		d_get_callouts	 (Dataspace*);
 
 extern sector		d_swapout	 (unsigned int);
+extern void		d_swapstat	 (Object*, Uint*, Uint*);
+extern void		d_memstat	 (Object*, Uint*, Uint*, Uint*);
 extern void		d_upgrade_mem	 (Object*, Object*);
 extern Control	       *d_restore_ctrl	 (Object*,
 					  void(*)(char*, sector*, Uint, Uint));
@@ -261,6 +272,9 @@ extern Dataspace       *d_restore_data	 (Object*, Uint*,
 					  void(*)(char*, sector*, Uint, Uint));
 extern void		d_restore_obj	 (Object*, Uint*, bool, bool);
 extern void		d_converted	 ();
+extern void		d_unref_frozen	 (Dataspace*);
+extern bool		d_dump_frozen	 (int);
+extern void		d_restore_frozen (int);
 
 extern void		d_free_control	 (Control*);
 extern void		d_free_dataspace (Dataspace*);
@@ -308,6 +322,7 @@ extern void		d_del_dataspace	(Dataspace*);
 
 /* bit values for dataspace->flags */
 # define DATA_STRCMP		0x03	/* strings compressed */
+# define DATA_FROZEN		0x04	/* references frozen arrays */
 
 /* bit values for dataspace->plane->flags */
 # define MOD_ALL		0x3f
@@ -28,6 +28,7 @@
 # include "editor.h"
 # include "call_out.h"
 # include "comm.h"
+# include "stats.h"
 # include "node.h"
 # include "compile.h"
 # include <stdarg.h>
@@ -79,14 +80,17 @@ void interrupt()
  */
 void endtask()
 {
+    Uint ticks, depth, size;
+
     comm_flush();
     d_export();
     o_clean();
-    i_clear();
+    ticks = i_clear(&depth, &size);
     ed_clear();
     ec_clear();
 
     co_swapcount(d_swapout(fragment));
+    st_task(ticks, depth, size);
 
     if (stop) {
 	comm_clear();
@@ -102,6 +106,7 @@ void endtask()
 	 */
 	d_swapout(1);
 	arr_freeall();
+	str_pool_clear();
 	m_purge();
 	swap = FALSE;
     }
@@ -208,9 +213,13 @@ int dgd_main(int argc, char **argv)
 	    }
 	}
 
+	/* statistics */
+	st_write();
+
 	/* interrupts */
 	if (intr) {
 	    intr = FALSE;
+	    st_start();
 	    try {
 		ec_push((ec_ftn) errhandler);
 		call_driver_object(cframe, "interrupt", 0);
@@ -221,7 +230,7 @@ int dgd_main(int argc, char **argv)
 	}
 
 	/* handle user input */
-	timeout = co_delay(rtime, rmtime, &mtime);
+	timeout = st_delay(co_delay(rtime, rmtime, &mtime), &mtime);
 	comm_receive(cframe, timeout, mtime);
 
 	/* callouts */
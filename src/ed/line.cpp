@@ -34,6 +34,11 @@
  *   The switching between buffers ensures that it is always possible to have
  * two blocks from the tmpfile in memory. Loading a 3rd block might erase one of
  * the two previous blocks though.
+ *   As long as the memory budget shared by all line buffers allows it, a full
+ * write buffer is not written to the tmpfile, but kept in memory in a page
+ * table indexed by its offset. Pages are taken from arenas of growing size,
+ * and blocks in them are used in place, so splitting, concatenating and output
+ * need no I/O. The tmpfile is created only when the budget is exhausted.
  *
  *   There are 3 types of blocks: on the lowest level is the chain block, which
  * contains pointers to previous and next chain blocks (if they exist) and is
@@ -87,6 +92,48 @@ struct blk {
 # define EDDEPTH	0x7fff
 # define EDMAXDEPTH	10000
 
+# define ARENA_MIN	8	/* # pages in first arena */
+# define ARENA_MAX	256	/* max # pages in an arena */
+# define ARENA_HDR	ALGN(sizeof(lbarena), STRUCT_AL)
+# define ARENA_PAGE(a, n) ((char *) (a) + ARENA_HDR + (n) * BLOCK_SIZE)
+
+struct lbarena {
+    lbarena *prev;		/* previous arena */
+    Int size;			/* # pages in arena */
+    Int used;			/* # pages in use */
+};
+
+static size_t lbmem;		/* memory available for pages */
+
+/*
+ * NAME:	linebuf->init()
+ * DESCRIPTION:	initialize line buffers, which may keep up to size bytes in
+ *		memory rather than in their tmpfiles
+ */
+void lb_init(size_t size)
+{
+    lbmem = size;
+}
+
+/*
+ * NAME:	linebuf->free()
+ * DESCRIPTION:	release the pages of a line buffer
+ */
+static void lb_free(linebuf *lb)
+{
+    lbarena *a;
+
+    while (lb->arena != (lbarena *) NULL) {
+	a = lb->arena;
+	lb->arena = a->prev;
+	lbmem += a->size * BLOCK_SIZE;
+	FREE(a);
+    }
+    if (lb->page != (char **) NULL) {
+	memset(lb->page, '\0', lb->npages * sizeof(char*));
+    }
+}
+
 /*
  * NAME:	linebuf->new()
  * DESCRIPTION:	If the first argument is 0, create a new line buffer,
@@ -101,8 +148,13 @@ linebuf *lb_new(linebuf *lb, char *filename)
     btbuf *bt;
 
     if (lb != (linebuf *) NULL) {
-	/* refresh; close the old tmpfile */
+	/* refresh; remove the old tmpfile and pages */
 	lb_inact(lb);
+	if (lb->tmpfile) {
+	    P_unlink(path_native(buf, lb->file));
+	    lb->tmpfile = FALSE;
+	}
+	lb_free(lb);
     } else {
 	/* allocate new line buffer */
 	lb = ALLOC(linebuf, 1);
@@ -119,6 +171,12 @@ linebuf *lb_new(linebuf *lb, char *filename)
 	--bt;
 	lb->bt[0].prev = bt;
 	bt->next = lb->bt;
+
+	lb->fd = -1;
+	lb->tmpfile = FALSE;
+	lb->arena = (lbarena *) NULL;
+	lb->page = (char **) NULL;
+	lb->npages = 0;
     }
 
     /* initialize */
@@ -130,13 +188,6 @@ linebuf *lb_new(linebuf *lb, char *filename)
     lb->blksz = 0;
     lb->txtsz = 0;
 
-    /* create or truncate tmpfile */
-    lb->fd = P_open(path_native(buf, lb->file),
-		    O_CREAT | O_TRUNC | O_RDWR | O_BINARY, 0600);
-    if (lb->fd < 0) {
-	fatal("cannot create editor tmpfile \"%s\"", lb->file);
-    }
-
     return lb;
 }
 
@@ -154,7 +205,9 @@ void lb_del(linebuf *lb)
     lb_inact(lb);
 
     /* remove tmpfile */
-    P_unlink(path_native(buf, lb->file));
+    if (lb->tmpfile) {
+	P_unlink(path_native(buf, lb->file));
+    }
     FREE(lb->file);
 
     /* release memory */
@@ -163,6 +216,10 @@ void lb_del(linebuf *lb)
 	FREE(bt->buf);
 	bt++;
     }
+    lb_free(lb);
+    if (lb->page != (char **) NULL) {
+	FREE(lb->page);
+    }
     FREE(lb);
 }
 
@@ -191,16 +248,84 @@ static void lb_act(linebuf *lb)
     char buf[STRINGSZ];
 
     if (lb->fd < 0) {
-	lb->fd = P_open(path_native(buf, lb->file), O_RDWR | O_BINARY, 0);
-	if (lb->fd < 0) {
-	    fatal("cannot reopen editor tmpfile \"%s\"", lb->file);
+	if (!lb->tmpfile) {
+	    /* create tmpfile */
+	    lb->fd = P_open(path_native(buf, lb->file),
+			    O_CREAT | O_TRUNC | O_RDWR | O_BINARY, 0600);
+	    if (lb->fd < 0) {
+		fatal("cannot create editor tmpfile \"%s\"", lb->file);
+	    }
+	    lb->tmpfile = TRUE;
+	} else {
+	    lb->fd = P_open(path_native(buf, lb->file), O_RDWR | O_BINARY, 0);
+	    if (lb->fd < 0) {
+		fatal("cannot reopen editor tmpfile \"%s\"", lb->file);
+	    }
 	}
     }
 }
 
+/*
+ * NAME:	linebuf->keep()
+ * DESCRIPTION:	keep the write buffer in memory, if the budget allows it.
+ *		Return TRUE if successful.
+ */
+static bool lb_keep(linebuf *lb)
+{
+    Int n, size;
+    char **page;
+    lbarena *a;
+
+    a = lb->arena;
+    if (a == (lbarena *) NULL || a->used == a->size) {
+	/* new arena, twice as large as the previous one */
+	size = (a == (lbarena *) NULL) ? ARENA_MIN : a->size << 1;
+	if (size > ARENA_MAX) {
+	    size = ARENA_MAX;
+	}
+	if (lbmem < (size_t) size * BLOCK_SIZE) {
+	    size = lbmem / BLOCK_SIZE;
+	    if (size == 0) {
+		return FALSE;
+	    }
+	}
+	m_static();
+	a = (lbarena *) ALLOC(char, ARENA_HDR + size * BLOCK_SIZE);
+	m_dynamic();
+	a->prev = lb->arena;
+	a->size = size;
+	a->used = 0;
+	lb->arena = a;
+	lbmem -= size * BLOCK_SIZE;
+    }
+
+    n = lb->wb->offset / BLOCK_SIZE;
+    if (n >= lb->npages) {
+	/* enlarge page table */
+	size = (lb->npages == 0) ? 16 : lb->npages;
+	while (size <= n) {
+	    size <<= 1;
+	}
+	m_static();
+	page = ALLOC(char*, size);
+	m_dynamic();
+	if (lb->npages != 0) {
+	    memcpy(page, lb->page, lb->npages * sizeof(char*));
+	    FREE(lb->page);
+	}
+	memset(page + lb->npages, '\0', (size - lb->npages) * sizeof(char*));
+	lb->page = page;
+	lb->npages = size;
+    }
+    lb->page[n] = (char *) memcpy(ARENA_PAGE(a, a->used++), lb->wb->buf,
+				  BLOCK_SIZE);
+
+    return TRUE;
+}
+
 /*
  * NAME:	linebuf->write()
- * DESCRIPTION:	Write the output buffer to the tmpfile.
+ * DESCRIPTION:	Write the output buffer to memory or to the tmpfile.
  */
 static void lb_write(linebuf *lb)
 {
@@ -213,13 +338,16 @@ static void lb_write(linebuf *lb)
 	}
 # endif
 
-	/* make the line buffer active */
-	lb_act(lb);
+	offset = lb->wb->offset;
+	if (!lb_keep(lb)) {
+	    /* make the line buffer active */
+	    lb_act(lb);
 
-	/* write in tmpfile */
-	P_lseek(lb->fd, offset = lb->wb->offset, SEEK_SET);	/* EOF */
-	if (P_write(lb->fd, lb->wb->buf, BLOCK_SIZE) < 0) {
-	    error("Failed to write editor tmpfile");
+	    /* write in tmpfile */
+	    P_lseek(lb->fd, offset, SEEK_SET);
+	    if (P_write(lb->fd, lb->wb->buf, BLOCK_SIZE) < 0) {
+		error("Failed to write editor tmpfile");
+	    }
 	}
 	/* cycle buffers */
 	lb->wb = lb->wb->prev;
@@ -241,6 +369,14 @@ static blk *bk_load(linebuf *lb, block b)
     /* check the write buffer */
     bt = lb->wb;
     if (b < bt->offset || b >= bt->offset + lb->blksz) {
+	Int n;
+
+	/* check the pages in memory */
+	n = b / BLOCK_SIZE;
+	if (n < lb->npages && lb->page[n] != (char *) NULL) {
+	    return (blk *) ((lb->buf = lb->page[n]) + b % BLOCK_SIZE);
+	}
+
 	/*
 	 * walk through the read buffers to see if the block can be found
 	 */
@@ -20,7 +20,8 @@
 /*
  *   The basic data type is a line buffer, in which blocks of lines are
  * allocated. The line buffer can be made inactive, to make it use as little
- * system resources as possible.
+ * system resources as possible. Line buffers are kept in memory for as long
+ * as a shared memory budget permits, and in a tmpfile otherwise.
  *   Blocks can be created, deleted, queried for their size, split in two, or
  * concatenated. Blocks are never actually deleted in a line buffer, but a
  * fake delete operation is added for the sake of completeness.
@@ -37,6 +38,7 @@ struct btbuf {
 struct linebuf {
     char *file;				/* tmpfile name */
     int fd;				/* tmpfile fd */
+    bool tmpfile;			/* tmpfile created? */
     char *buf;				/* current low-level buffer */
     int blksz;				/* block size in write buffer */
     int txtsz;				/* text size in write buffer */
@@ -44,8 +46,12 @@ struct linebuf {
     bool reverse;			/* for bk_put() */
     btbuf *wb;				/* write buffer */
     btbuf bt[NR_EDBUFS];		/* read & write buffers */
+    struct lbarena *arena;		/* memory for buffers kept in memory */
+    char **page;			/* buffers kept in memory */
+    Int npages;				/* size of page table */
 };
 
+extern void	lb_init	  (size_t);
 extern linebuf *lb_new	  (linebuf*, char*);
 extern void	lb_del	  (linebuf*);
 extern void	lb_inact  (linebuf*);
@@ -22,10 +22,15 @@
 # include "regexp.h"
 
 /*
- *   Regular expression matching. This is all fairly standard. Character classes
- * are implemented as bitmaps for a fast lookup. A special case is LSTAR, which
- * is like STAR except that only the longest possible match can be a match
- * (quite a speedup in some cases).
+ *   Regular expression matching. Character classes are implemented as bitmaps
+ * for a fast lookup. A special case is LSTAR, which is like STAR except that
+ * only the longest possible match can be a match.
+ *   The compiled expression is not matched by backtracking, which can take
+ * exponential time, but by following all possible paths through it in
+ * parallel, in order of preference. Whether a line matches at all is decided
+ * by a deterministic automaton, the states of which are constructed on demand
+ * and cached; only a line that matches is scanned a second time, to find the
+ * position of the match and its subexpressions.
  */
 
 # define EOM		0x00	/*	end of match */
@@ -45,6 +50,48 @@
 # define CCL_BUF(rx, c)		((rx)->buffer + RXBUFSZ - CCLSIZE * UCHAR(c))
 # define CCL_CODE(rx, ccl)	(((rx)->buffer + RXBUFSZ - (ccl)) / CCLSIZE)
 
+# define ISWORD(c)		(isalnum(c) || (c) == '_')
+
+# define RXSTATES	128		/* max # cached states */
+# define RXPOOLSZ	4096		/* max # instructions in cached states */
+# define RXHASHSZ	256		/* size of state hash table */
+
+# define RX_UNKNOWN	-1		/* transition not yet computed */
+# define RX_MATCH	-2		/* transition to a match */
+# define RX_FAIL	-3		/* transition to certain failure */
+
+struct rxstate {
+    short next;			/* next in hash chain */
+    short nids;			/* # pending instructions */
+    short ids;			/* pending instructions in pool */
+    bool word;			/* previous character is part of a word */
+};
+
+struct rxlist {
+    int size;			/* # threads */
+    short *pc;			/* instruction per thread */
+    const char **caps;		/* match and subexpression positions */
+};
+
+struct rxmatch {
+    bool ic;			/* automaton ignores case */
+    short ncap;			/* # positions per thread */
+    short eom;			/* EOM instruction */
+    short nclass;		/* # character classes */
+    short nstates;		/* # cached states */
+    short poolsz;		/* size of instruction pool */
+    short init[2];		/* initial states */
+    int prefixlen;		/* length of literal prefix */
+    short *trans;		/* state transitions per character class */
+    short *sparse;		/* thread list index per instruction */
+    rxlist list[2];		/* thread lists */
+    unsigned char cls[256];	/* character class per character */
+    short hash[RXHASHSZ];	/* state hash table */
+    rxstate state[RXSTATES];	/* cached states */
+    short pool[RXPOOLSZ];	/* instruction pool */
+    char prefix[RXBUFSZ / 2];	/* literal prefix of every match */
+};
+
 /*
  * NAME:	rxbuf->new()
  * DESCRIPTION:	Create a new regular expression buffer.
@@ -55,15 +102,38 @@ rxbuf *rx_new()
 
     rx = ALLOC(rxbuf, 1);
     rx->valid = 0;
+    rx->matcher = (rxmatch *) NULL;
     return rx;
 }
 
+/*
+ * NAME:	rxbuf->clear()
+ * DESCRIPTION:	Remove the matching automata.
+ */
+static void rx_clear(rxbuf *rx)
+{
+    rxmatch *mt;
+
+    mt = rx->matcher;
+    if (mt != (rxmatch *) NULL) {
+	if (mt->trans != (short *) NULL) {
+	    FREE(mt->trans);
+	}
+	FREE(mt->list[0].caps);
+	FREE(mt->list[0].pc);
+	FREE(mt->sparse);
+	FREE(mt);
+	rx->matcher = (rxmatch *) NULL;
+    }
+}
+
 /*
  * NAME:	rxbuf->del()
  * DESCRIPTION:	Delete a regular expression buffer.
  */
 void rx_del(rxbuf *rx)
 {
+    rx_clear(rx);
     FREE(rx);
 }
 
@@ -82,9 +152,9 @@ const char *rx_comp(rxbuf *rx, const char *pattern)
     int brac, depth;
 
     /* initialize */
+    rx_clear(rx);
     rx->valid = 0;
     rx->anchor = 0;
-    rx->firstc = '\0';
     cclass = rx->buffer + RXBUFSZ;
     eoln = (char *) NULL;
     dummy = 0;
@@ -306,142 +376,626 @@ const char *rx_comp(rxbuf *rx, const char *pattern)
 	*prevpat = EOL;	/* won't hurt */
     }
     *m = EOM;
-    if (rx->buffer[0] == SINGLE) {
-	rx->firstc = rx->buffer[1];	/* first char for quick search */
-    }
     rx->valid = 1;	/* buffer contains valid NFA */
     return (char *) NULL;
 }
 
 /*
- * NAME:	match()
- * DESCRIPTION:	match the text (t) against the pattern (m). Return 1 if
- *		success.
+ * NAME:	item()
+ * DESCRIPTION:	check whether a character matches a single item of the
+ *		pattern. Starred character classes disregard the case of the
+ *		character itself when case is ignored.
  */
-static bool match(rxbuf *rx, const char *start, const char *text, bool ic,
-		  char *m, const char *t)
+static bool item(rxbuf *rx, char *m, char c, bool ic, bool star)
 {
-    const char *p;
-    char *cclass, code, c;
+    char *cclass;
 
-    for (;;) {
-	switch (code = *m++) {
-	case EOM:
-	    /* found a match */
-	    rx->start = t;
-	    return TRUE;
+    switch (*m) {
+    case ANY:
+	return (c != '\0');
 
-	case EOL:
-	    if (*t != '\0') {
-		return FALSE;
-	    }
-	    /* cannot return at this point as a \) might still follow. */
-	    continue;
+    case SINGLE:
+	return (c == m[1] || (ic && tolower(c) == tolower(m[1])));
 
-	case ANY:
-	    if (*t == '\0') {	/* any but '\0' */
-		return FALSE;
-	    }
-	    break;
+    case CCLASS:
+	cclass = CCL_BUF(rx, m[1]);
+	if (ic) {
+	    char lc;
 
-	case SINGLE:
-	    /* match single character */
-	    if (*t != *m && (!ic || tolower(*t) != tolower(*m))) {
+	    lc = tolower(c);
+	    if (CCL(cclass, &, lc)) {
+		return TRUE;
+	    }
+	    if (star) {
 		return FALSE;
 	    }
-	    m++;
-	    break;
+	}
+	return (CCL(cclass, &, c) != 0);
+    }
+    return FALSE;
+}
 
+/*
+ * NAME:	inslen()
+ * DESCRIPTION:	return the length of an instruction
+ */
+static int inslen(char *m)
+{
+    switch (*m) {
+    case SINGLE:
+    case CCLASS:
+    case LBRAC:
+    case RBRAC:
+	return 2;
+
+    case STAR:
+    case LSTAR:
+	return (m[1] == ANY) ? 2 : 3;
+
+    default:
+	return 1;
+    }
+}
+
+/*
+ * NAME:	rxbuf->flush()
+ * DESCRIPTION:	empty the cache of automaton states
+ */
+static void rx_flush(rxmatch *mt)
+{
+    int i;
+
+    mt->nstates = 0;
+    mt->poolsz = 0;
+    mt->init[0] = mt->init[1] = RX_UNKNOWN;
+    for (i = 0; i < RXHASHSZ; i++) {
+	mt->hash[i] = RX_UNKNOWN;
+    }
+}
+
+/*
+ * NAME:	rxbuf->split()
+ * DESCRIPTION:	refine the character classes with a set of characters
+ */
+static void rx_split(rxmatch *mt, bool *set)
+{
+    short map[256][2];
+    int c, n;
+
+    memset(map, '\xff', sizeof(map));
+    for (n = c = 0; c < 256; c++) {
+	if (map[mt->cls[c]][set[c]] < 0) {
+	    map[mt->cls[c]][set[c]] = n++;
+	}
+	mt->cls[c] = map[mt->cls[c]][set[c]];
+    }
+    mt->nclass = n;
+}
+
+/*
+ * NAME:	rxbuf->classes()
+ * DESCRIPTION:	partition the characters into classes which the pattern
+ *		cannot tell apart, and prepare an empty automaton
+ */
+static void rx_classes(rxbuf *rx, bool ic)
+{
+    rxmatch *mt;
+    char *m;
+    bool set[256];
+    int c;
+
+    mt = rx->matcher;
+    mt->ic = ic;
+    memset(mt->cls, '\0', 256);
+    for (c = 0; c < 256; c++) {
+	set[c] = (c == '\0');
+    }
+    rx_split(mt, set);
+    for (c = 0; c < 256; c++) {
+	set[c] = ISWORD((char) c);
+    }
+    rx_split(mt, set);
+    for (c = 0; c < 256; c++) {
+	set[c] = (isalpha((char) c) || c == '_');
+    }
+    rx_split(mt, set);
+    for (m = rx->buffer; *m != EOM; m += inslen(m)) {
+	switch (*m) {
+	case SINGLE:
 	case CCLASS:
-	    /* match character class */
-	    cclass = CCL_BUF(rx, *m++);
-	    if (CCL(cclass, &, *t) == 0) {
-		if (ic) {
-		    c = tolower(*t);
-		    if (CCL(cclass, &, c)) {
-			break;
-		    }
-		}
-		return FALSE;
+	    for (c = 0; c < 256; c++) {
+		set[c] = item(rx, m, (char) c, ic, FALSE);
 	    }
+	    rx_split(mt, set);
 	    break;
 
 	case STAR:
 	case LSTAR:
-	    p = t;
-	    /* match as much characters as possible */
-	    switch (*m++) {
-	    case ANY:
-		while (*p != '\0') {
-		    p++;
+	    if (m[1] != ANY) {
+		for (c = 0; c < 256; c++) {
+		    set[c] = item(rx, m + 1, (char) c, ic, TRUE);
 		}
-		break;
+		rx_split(mt, set);
+	    }
+	    break;
+	}
+    }
 
-	    case SINGLE:
-		while (*p == *m || (ic && tolower(*p) == tolower(*m))) {
-		    p++;
-		}
-		m++;
-		break;
+    if (mt->trans != (short *) NULL) {
+	FREE(mt->trans);
+    }
+    m_static();
+    mt->trans = ALLOC(short, RXSTATES * mt->nclass);
+    m_dynamic();
+    rx_flush(mt);
+}
 
-	    case CCLASS:
-		cclass = CCL_BUF(rx, *m++);
-		if (!ic) {
-		    while (CCL(cclass, &, *p)) {
-			p++;
-		    }
-		} else {
-		    c = tolower(*p);
-		    while (CCL(cclass, &, c)) {
-			p++;
-			c = tolower(*p);
-		    }
-		}
-		break;
-	    }
-	    if (code == LSTAR) {
-		/* only the maximum match is a match */
-		t = p;
-	    } else {
-		/* try all possible lengths of the starred pattern */
-		while (p > t) {
-		    if (match(rx, start, text, ic, m, p)) {
-			return TRUE;
-		    }
-		    --p;
-		}
+/*
+ * NAME:	rxbuf->build()
+ * DESCRIPTION:	prepare the matching automata for a compiled pattern
+ */
+static rxmatch *rx_build(rxbuf *rx)
+{
+    rxmatch *mt;
+    char *m;
+    int ninst, nbrac;
+
+    /* kept across tasks, along with the buffer */
+    m_static();
+    mt = rx->matcher = ALLOC(rxmatch, 1);
+    mt->trans = (short *) NULL;
+    ninst = nbrac = 0;
+    for (m = rx->buffer; *m != EOM; m += inslen(m)) {
+	if (*m == LBRAC) {
+	    nbrac++;
+	}
+	ninst++;
+    }
+    mt->eom = m - rx->buffer;
+    ninst++;
+    mt->ncap = 1 + 2 * nbrac;
+
+    /* every match starts with the literal characters at the start */
+    mt->prefixlen = 0;
+    for (m = rx->buffer; ; m += inslen(m)) {
+	if (*m == SINGLE) {
+	    mt->prefix[mt->prefixlen++] = m[1];
+	} else if (*m != SOW && *m != EOW && *m != LBRAC && *m != RBRAC) {
+	    break;
+	}
+    }
+    mt->prefix[mt->prefixlen] = '\0';
+
+    mt->sparse = ALLOC(short, RXBUFSZ);
+    memset(mt->sparse, '\0', RXBUFSZ * sizeof(short));
+    mt->list[0].pc = ALLOC(short, 2 * ninst);
+    mt->list[1].pc = mt->list[0].pc + ninst;
+    mt->list[0].caps = ALLOC(const char*, 2 * ninst * mt->ncap);
+    mt->list[1].caps = mt->list[0].caps + ninst * mt->ncap;
+    m_dynamic();
+
+    return mt;
+}
+
+/*
+ * NAME:	rxbuf->thread()
+ * DESCRIPTION:	append a thread to a list
+ */
+static void rx_thread(rxmatch *mt, rxlist *l, int pc, const char **caps)
+{
+    const char **copy;
+    int n;
+
+    mt->sparse[pc] = l->size;
+    l->pc[l->size] = pc;
+    if (caps != (const char **) NULL) {
+	copy = l->caps + l->size * mt->ncap;
+	for (n = mt->ncap; n > 0; --n) {
+	    *copy++ = *caps++;
+	}
+    }
+    l->size++;
+}
+
+/*
+ * NAME:	rxbuf->add()
+ * DESCRIPTION:	add a thread to a list, following all instructions which do
+ *		not consume a character, and keeping only those that can
+ *		consume the next one. A thread that arrives at an
+ *		instruction which an earlier thread has reached is dropped.
+ */
+static void rx_add(rxbuf *rx, rxlist *l, int pc, const char **caps,
+		   const char *t, char c, bool word)
+{
+    rxmatch *mt;
+    char *m;
+    const char *save;
+    int n;
+
+    mt = rx->matcher;
+    for (;;) {
+	n = mt->sparse[pc];
+	if (n < l->size && l->pc[n] == pc) {
+	    return;
+	}
+	m = rx->buffer + pc;
+	switch (*m) {
+	case EOL:
+	    if (c != '\0') {
+		return;
 	    }
+	    pc++;
 	    continue;
 
 	case SOW:
 	    /* start of word */
-	    if ((t != start && (isalnum(t[-1]) || t[-1] == '_'))
-	      || (!isalpha(*t) && *t != '_')) {
-		return FALSE;
+	    if (word || (!isalpha(c) && c != '_')) {
+		return;
 	    }
+	    pc++;
 	    continue;
 
 	case EOW:
 	    /* end of word */
-	    if (t == start || (!isalnum(t[-1]) && t[-1] != '_')
-	      || (isalnum(*t) || *t == '_')) {
-		return FALSE;
+	    if (!word || ISWORD(c)) {
+		return;
 	    }
+	    pc++;
 	    continue;
 
 	case LBRAC:
 	    /* start of subexpression */
-	    rx->se[*m++].start = t;
+	    if (caps != (const char **) NULL) {
+		n = 1 + 2 * UCHAR(m[1]);
+		save = caps[n];
+		caps[n] = t;
+		rx_add(rx, l, pc + 2, caps, t, c, word);
+		caps[n] = save;
+		return;
+	    }
+	    pc += 2;
 	    continue;
 
 	case RBRAC:
 	    /* end of subexpression */
-	    rx->se[*m].size = t - rx->se[*m].start;
-	    m++;
+	    if (caps != (const char **) NULL) {
+		n = 2 + 2 * UCHAR(m[1]);
+		save = caps[n];
+		caps[n] = t;
+		rx_add(rx, l, pc + 2, caps, t, c, word);
+		caps[n] = save;
+		return;
+	    }
+	    pc += 2;
+	    continue;
+
+	case LSTAR:
+	    /* only the maximum match is a match */
+	    if (!item(rx, m + 1, c, mt->ic, TRUE)) {
+		pc += inslen(m);
+		continue;
+	    }
+	    break;
+
+	case STAR:
+	    /* prefer matching one more character, or else try the rest */
+	    if (item(rx, m + 1, c, mt->ic, TRUE)) {
+		rx_thread(mt, l, pc, caps);
+	    }
+	    pc += inslen(m);
 	    continue;
+
+	case EOM:
+	    break;
+
+	default:
+	    /* only keep threads that can proceed */
+	    if (!item(rx, m, c, mt->ic, FALSE)) {
+		return;
+	    }
+	    break;
+	}
+
+	rx_thread(mt, l, pc, caps);
+	return;
+    }
+}
+
+/*
+ * NAME:	rxbuf->cmp()
+ * DESCRIPTION:	compare two instructions
+ */
+static int rx_cmp(const void *cv1, const void *cv2)
+{
+    return *(const short *) cv1 - *(const short *) cv2;
+}
+
+/*
+ * NAME:	rxbuf->state()
+ * DESCRIPTION:	find or create an automaton state. Return RX_UNKNOWN if
+ *		the cache is full.
+ */
+static int rx_state(rxmatch *mt, short *ids, int nids, bool word)
+{
+    rxstate *st;
+    Uint h;
+    int i, s;
+
+    h = word;
+    for (i = 0; i < nids; i++) {
+	h = h * 31 + ids[i];
+    }
+    h %= RXHASHSZ;
+    for (s = mt->hash[h]; s >= 0; s = st->next) {
+	st = &mt->state[s];
+	if (st->word == word && st->nids == nids &&
+	    memcmp(mt->pool + st->ids, ids, nids * sizeof(short)) == 0) {
+	    return s;
+	}
+    }
+
+    if (mt->nstates == RXSTATES || mt->poolsz + nids > RXPOOLSZ) {
+	return RX_UNKNOWN;
+    }
+    s = mt->nstates++;
+    st = &mt->state[s];
+    st->next = mt->hash[h];
+    mt->hash[h] = s;
+    st->nids = nids;
+    st->ids = mt->poolsz;
+    memcpy(mt->pool + st->ids, ids, nids * sizeof(short));
+    mt->poolsz += nids;
+    st->word = word;
+    for (i = mt->nclass, ids = mt->trans + s * i; i > 0; --i) {
+	*ids++ = RX_UNKNOWN;
+    }
+    return s;
+}
+
+/*
+ * NAME:	rxbuf->initial()
+ * DESCRIPTION:	return the initial automaton state
+ */
+static int rx_initial(rxbuf *rx, bool word)
+{
+    rxmatch *mt;
+    short start;
+    int s;
+
+    mt = rx->matcher;
+    s = mt->init[word];
+    if (s < 0) {
+	/* only an anchored pattern starts with a pending instruction */
+	start = 0;
+	s = rx_state(mt, &start, rx->anchor, word);
+	if (s < 0) {
+	    rx_flush(mt);
+	    s = rx_state(mt, &start, rx->anchor, word);
+	}
+	mt->init[word] = s;
+    }
+    return s;
+}
+
+/*
+ * NAME:	rxbuf->step()
+ * DESCRIPTION:	compute the transition from an automaton state on a
+ *		character
+ */
+static int rx_step(rxbuf *rx, int s, char c)
+{
+    rxmatch *mt;
+    rxstate *st;
+    rxlist *l, *next;
+    char *m;
+    int i, n;
+
+    mt = rx->matcher;
+    st = &mt->state[s];
+    l = &mt->list[0];
+    l->size = 0;
+    for (i = 0; i < st->nids; i++) {
+	rx_add(rx, l, mt->pool[st->ids + i], (const char **) NULL,
+	       (const char *) NULL, c, st->word);
+    }
+    if (!rx->anchor) {
+	/* a match may start here */
+	rx_add(rx, l, 0, (const char **) NULL, (const char *) NULL, c,
+	       st->word);
+    }
+
+    n = mt->sparse[mt->eom];
+    if (n < l->size && l->pc[n] == mt->eom) {
+	n = RX_MATCH;
+    } else {
+	/* collect the instructions pending after this character */
+	next = &mt->list[1];
+	next->size = 0;
+	for (i = 0; i < l->size; i++) {
+	    m = rx->buffer + l->pc[i];
+	    next->pc[next->size++] = (*m == STAR || *m == LSTAR) ?
+				      l->pc[i] : l->pc[i] + inslen(m);
+	}
+	if (c == '\0' || (next->size == 0 && rx->anchor)) {
+	    n = RX_FAIL;
+	} else {
+	    /* sort, and remove duplicates */
+	    qsort(next->pc, next->size, sizeof(short), rx_cmp);
+	    for (i = n = 0; i < next->size; i++) {
+		if (n == 0 || next->pc[i] != next->pc[n - 1]) {
+		    next->pc[n++] = next->pc[i];
+		}
+	    }
+	    next->size = n;
+	    n = rx_state(mt, next->pc, next->size, ISWORD(c));
+	    if (n < 0) {
+		/* cache full: start over */
+		rx_flush(mt);
+		return rx_state(mt, next->pc, next->size, ISWORD(c));
+	    }
+	}
+    }
+
+    mt->trans[s * mt->nclass + mt->cls[UCHAR(c)]] = n;
+    return n;
+}
+
+/*
+ * NAME:	rxbuf->find()
+ * DESCRIPTION:	find the next occurrence of the literal prefix of the
+ *		pattern
+ */
+static const char *rx_find(rxbuf *rx, const char *t)
+{
+    rxmatch *mt;
+    char set[4];
+    int i;
+
+    mt = rx->matcher;
+    if (!mt->ic) {
+	return strstr(t, mt->prefix);
+    }
+
+    set[0] = mt->prefix[0];
+    set[1] = tolower(set[0]);
+    set[2] = toupper(set[0]);
+    set[3] = '\0';
+    while ((t=strpbrk(t, set)) != (char *) NULL) {
+	for (i = 1; i < mt->prefixlen; i++) {
+	    if (t[i] != mt->prefix[i] &&
+		tolower(t[i]) != tolower(mt->prefix[i])) {
+		break;
+	    }
+	}
+	if (i == mt->prefixlen) {
+	    break;
+	}
+	t++;
+    }
+    return t;
+}
+
+/*
+ * NAME:	rxbuf->dfa()
+ * DESCRIPTION:	determine whether the text matches, from the given position,
+ *		and if so, how far along in the text the match must start
+ */
+static bool rx_dfa(rxbuf *rx, const char *text, const char **from)
+{
+    rxmatch *mt;
+    const char *t;
+    int s, n;
+    char c;
+
+    mt = rx->matcher;
+    t = *from;
+    s = rx_initial(rx, t != text && ISWORD(t[-1]));
+    for (;;) {
+	if (mt->state[s].nids == 0 && !rx->anchor) {
+	    /* nothing pending: a match cannot start before this point */
+	    if (mt->prefixlen != 0) {
+		/* skip to where a match could start */
+		t = rx_find(rx, t);
+		if (t == (char *) NULL) {
+		    return FALSE;
+		}
+		s = rx_initial(rx, t != text && ISWORD(t[-1]));
+	    }
+	    *from = t;
+	}
+
+	c = *t++;
+	n = mt->trans[s * mt->nclass + mt->cls[UCHAR(c)]];
+	if (n == RX_UNKNOWN) {
+	    n = rx_step(rx, s, c);
+	}
+	if (n < 0) {
+	    return (n == RX_MATCH);
+	}
+	s = n;
+    }
+}
+
+/*
+ * NAME:	rxbuf->pike()
+ * DESCRIPTION:	find the first match in the text, from the given position,
+ *		and the subexpressions within it
+ */
+static bool rx_pike(rxbuf *rx, const char *text, const char *t)
+{
+    rxmatch *mt;
+    rxlist *l, *next;
+    const char **caps, *start[1 + 2 * NSUBEXP];
+    char *m;
+    bool found, word;
+    int i, j, pc;
+    char c;
+
+    mt = rx->matcher;
+    l = &mt->list[0];
+    next = &mt->list[1];
+    l->size = 0;
+    found = FALSE;
+    word = (t != text && ISWORD(t[-1]));
+    memset(start, '\0', sizeof(start));
+
+    for (;;) {
+	if (!found && (!rx->anchor || t == text)) {
+	    if (l->size == 0 && !rx->anchor && mt->prefixlen != 0) {
+		/* skip to where a match could start */
+		t = rx_find(rx, t);
+		if (t == (char *) NULL) {
+		    break;
+		}
+		word = (t != text && ISWORD(t[-1]));
+	    }
+	    /* a match starting here is the last choice */
+	    start[0] = t;
+	    rx_add(rx, l, 0, start, t, *t, word);
+	} else if (l->size == 0) {
+	    break;
+	}
+
+	c = *t;
+	next->size = 0;
+	for (i = 0; i < l->size; i++) {
+	    pc = l->pc[i];
+	    m = rx->buffer + pc;
+	    caps = l->caps + i * mt->ncap;
+	    switch (*m) {
+	    case EOM:
+		/* found a match, which takes precedence over the rest */
+		rx->start = caps[0];
+		rx->size = t - caps[0];
+		for (j = 0; 2 * j + 1 < mt->ncap; j++) {
+		    rx->se[j].start = caps[2 * j + 1];
+		    rx->se[j].size = caps[2 * j + 2] - caps[2 * j + 1];
+		}
+		found = TRUE;
+		break;
+
+	    case STAR:
+	    case LSTAR:
+		rx_add(rx, next, pc, caps, t + 1, t[1], ISWORD(c));
+		continue;
+
+	    default:
+		rx_add(rx, next, pc + inslen(m), caps, t + 1, t[1], ISWORD(c));
+		continue;
+	    }
+	    break;
+	}
+	if (c == '\0') {
+	    break;
 	}
+
+	l = next;
+	next = &mt->list[l == &mt->list[0]];
+	word = ISWORD(c);
 	t++;
     }
+
+    return found;
 }
 
 /*
@@ -453,49 +1007,32 @@ static bool match(rxbuf *rx, const char *start, const char *text, bool ic,
  */
 int rx_exec(rxbuf *rx, const char *text, int idx, bool ic)
 {
+    rxmatch *mt;
+    const char *t;
+
     rx->start = (char *) NULL;
     if (!rx->valid) {
 	return -1;
     }
+    if (rx->anchor && idx != 0) {
+	return 0;
+    }
 
-    if (rx->anchor) {
-	/* the easy case */
-	if (idx || !match(rx, text, text, ic, rx->buffer, text)) {
-	    return 0;
-	}
-    } else {
-	for (;;) {
-	    if (rx->firstc != '\0') {
-		const char *p;
-
-		/* find the first character of the pattern in the string */
-		p = strchr(text + idx, rx->firstc);
-		if (ic) {
-		    const char *q;
-
-		    q = strchr(text + idx, toupper(rx->firstc));
-		    if (q != (char*) NULL && (p == (char *) NULL || p > q)) {
-			p = q;
-		    }
-		}
-		if (p != (char *) NULL) {
-		    idx = p - text;
-		} else {
-		    return 0;
-		}
-	    }
-	    if (match(rx, text, text + idx, ic, rx->buffer, text + idx)) {
-		break;
-	    }
-	    /* if no match, try the next character in the string */
-	    if (text[idx++] == '\0') {
-		return 0;
-	    }
-	}
+    mt = rx->matcher;
+    if (mt == (rxmatch *) NULL) {
+	mt = rx_build(rx);
+	rx_classes(rx, ic);
+    } else if (mt->ic != ic) {
+	rx_classes(rx, ic);
     }
 
-    /* a match was found, record its starting place and length */
-    rx->size = rx->start - text - idx;
-    rx->start -= rx->size;
+    /*
+     * decide whether there is a match before looking for its position, and
+     * only look from where the automaton last had nothing pending
+     */
+    t = text + idx;
+    if (!rx_dfa(rx, text, &t) || !rx_pike(rx, text, t)) {
+	return 0;
+    }
     return 1;
 }
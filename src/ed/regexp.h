@@ -25,10 +25,12 @@
 # define RXBUFSZ	2048
 # define NSUBEXP	9
 
+struct rxmatch;
+
 struct rxbuf {
     bool valid;			/* is the present matcher valid? */
     bool anchor;		/* is the match anchored (^pattern) */
-    char firstc;		/* first character in match, if any */
+    rxmatch *matcher;		/* matching automata, built on first use */
     const char *start;		/* start of matching sequence */
     int size;			/* size of matching sequence */
     struct {
@@ -43,13 +43,15 @@ static bool internal;		/* flag editor internal error */
 
 /*
  * NAME:	ed->init()
- * DESCRIPTION:	initialize editor handling
+ * DESCRIPTION:	initialize editor handling, with a memory budget for the
+ *		editor buffers
  */
-void ed_init(char *tmp, int num)
+void ed_init(char *tmp, int num, size_t memory)
 {
     editor *e, *f;
 
     tmpedfile = tmp;
+    lb_init(memory);
     f = (editor *) NULL;
     neditors = num;
     if (num != 0) {
@@ -17,7 +17,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-extern void	   ed_init	(char*, int);
+extern void	   ed_init	(char*, int, size_t);
 extern void	   ed_finish	();
 extern void	   ed_clear	();
 extern void	   ed_new	(Object*);
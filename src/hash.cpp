@@ -104,11 +104,28 @@ unsigned short Hashtab::hashmem(const char *mem, unsigned int len)
     return (unsigned short) ((h << 8) | l);
 }
 
+/*
+ * NAME:	Hashtab::hashfull()
+ * DESCRIPTION:	hash memory to a full-width value, considering every byte
+ *		(FNV-1a)
+ */
+Uint Hashtab::hashfull(const char *mem, unsigned int len)
+{
+    Uint h;
+
+    h = 2166136261U;
+    while (len > 0) {
+	h = (h ^ (unsigned char) *mem++) * 16777619U;
+	--len;
+    }
+    return h;
+}
+
 
 /*
  * NAME:	HashtabImpl()
  * DESCRIPTION:	create a new hashtable of size "size", where "maxlen" characters
- *		of each string are significant
+ *		of each string are significant, or all of them if "maxlen" is 0
  */
 HashtabImpl::HashtabImpl(unsigned int size, unsigned int maxlen, bool mem)
 {
@@ -128,6 +145,21 @@ HashtabImpl::~HashtabImpl()
     FREE(m_table);
 }
 
+/*
+ * NAME:	HashtabImpl::hash()
+ * DESCRIPTION:	return the hash table index for a name
+ */
+Uint HashtabImpl::hash(const char *name)
+{
+    if (m_mem) {
+	return hashmem(name, m_maxlen) % m_size;
+    } else if (m_maxlen != 0) {
+	return hashstr(name, m_maxlen) % m_size;
+    } else {
+	return hashfull(name, strlen(name)) % m_size;
+    }
+}
+
 /*
  * NAME:	HashtabImpl::lookup()
  * DESCRIPTION:	lookup a name in a hashtable, return the address of the entry
@@ -137,8 +169,8 @@ Hashtab::Entry **HashtabImpl::lookup(const char *name, bool move)
 {
     Entry **first, **e, *next;
 
+    first = e = &m_table[hash(name)];
     if (m_mem) {
-	first = e = &(m_table[hashmem(name, m_maxlen) % m_size]);
 	while (*e != (Entry *) NULL) {
 	    if (memcmp((*e)->name, name, m_maxlen) == 0) {
 		if (move && e != first) {
@@ -154,7 +186,6 @@ Hashtab::Entry **HashtabImpl::lookup(const char *name, bool move)
 	    e = &((*e)->next);
 	}
     } else {
-	first = e = &(m_table[hashstr(name, m_maxlen) % m_size]);
 	while (*e != (Entry *) NULL) {
 	    if (strcmp((*e)->name, name) == 0) {
 		if (move && e != first) {
@@ -172,3 +203,32 @@ Hashtab::Entry **HashtabImpl::lookup(const char *name, bool move)
     }
     return e;
 }
+
+/*
+ * NAME:	HashtabImpl::resize()
+ * DESCRIPTION:	rehash all entries into a table of a different size,
+ *		keeping entries with the same name in the same order
+ */
+void HashtabImpl::resize(Uint size)
+{
+    Entry **table, **t, **e, *next;
+    Uint i;
+
+    table = m_table;
+    i = m_size;
+    m_size = size;
+    m_table = ALLOC(Entry*, size);
+    memset(m_table, '\0', size * sizeof(Entry*));
+
+    for (t = table; i > 0; --i, t++) {
+	while (*t != (Entry *) NULL) {
+	    next = (*t)->next;
+	    for (e = &m_table[hash((*t)->name)]; *e != (Entry *) NULL;
+		 e = &(*e)->next) ;
+	    (*t)->next = (Entry *) NULL;
+	    *e = *t;
+	    *t = next;
+	}
+    }
+    FREE(table);
+}
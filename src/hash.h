@@ -31,6 +31,7 @@ public:
     }
     static unsigned short hashstr(const char *str, unsigned int len);
     static unsigned short hashmem(const char *mem, unsigned int len);
+    static Uint hashfull(const char *mem, unsigned int len);
 
     struct Entry : public Allocated {
 	Entry *next;		/* next entry in hash table */
@@ -40,6 +41,7 @@ public:
     virtual Entry **table() = 0;
     virtual Uint size() = 0;
     virtual Entry **lookup(const char*, bool) = 0;
+    virtual void resize(Uint size) = 0;
 
 private:
     static unsigned char tab[256];
@@ -59,8 +61,11 @@ public:
     }
 
     virtual Entry **lookup(const char *name, bool move);
+    virtual void resize(Uint size);
 
 private:
+    Uint hash(const char *name);
+
     Uint m_size;		/* size of hash table (power of two) */
     unsigned short m_maxlen;	/* max length of string to be used in hashing */
     bool m_mem;			/* \0-terminated string or raw memory? */
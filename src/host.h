@@ -230,6 +230,10 @@ typedef unsigned int Uint;
 #  endif
 # endif
 
+# if !defined(Uuuint) && !defined(NOUUUINT) && defined(__SIZEOF_INT128__)
+# define Uuuint			unsigned __int128
+# endif
+
 extern void  P_message	(const char*);
 
 # ifndef O_BINARY
@@ -255,6 +259,7 @@ extern void  P_message	(const char*);
 # define P_rmdir	rmdir
 # define P_chdir	chdir
 # define P_execv	execv
+# define P_fsync	fsync
 # else
 	/* filename translation */
 typedef long off_t;
@@ -274,7 +279,13 @@ extern int P_mkdir	(const char*, int);
 extern int P_rmdir	(const char*);
 extern int P_chdir	(const char*);
 extern int P_execv	(const char*, char**);
+extern int P_fsync	(int);
 # endif
+
+extern char *P_mmap	(int, size_t);
+extern void  P_munmap	(char*, size_t);
+extern void  P_madvise	(char*, size_t, bool);
+extern void  P_prefetch	(char*, size_t);
 # endif /* INCLUDE_FILE_IO */
 
 extern bool  P_opendir	(const char*);
@@ -292,6 +303,7 @@ extern long  P_random	();
 
 extern Uint  P_time	();
 extern Uint  P_mtime	(unsigned short*);
+extern Uuint P_utime	();
 extern char *P_ctime	(char*, Uint);
 
 /* these must be the same on all hosts */
@@ -200,6 +200,49 @@ static void asi_mult1(Uint *c, Uint a, Uint b)
 }
 # endif
 
+/*
+ * NAME:	asi->mult_row()
+ * DESCRIPTION:	c += a * word
+ */
+static bool asi_mult_row(Uint *c, Uint *a, Uint b, Uint size)
+{
+# ifdef Uuint
+    Uuint t;
+    Uint carry;
+
+    carry = 0;
+    do {
+	t = (Uuint) *a++ * b + *c + carry;
+	*c++ = (Uint) t;
+	carry = (Uint) (t >> 32);
+    } while (--size != 0);
+
+    return ((*c += carry) < carry);
+# else
+    Uint s, carry;
+    Uint t[2];
+
+    s = 0;
+    carry = 0;
+    do {
+	asi_mult1(t, *a++, b);
+	if ((s += t[0]) < t[0]) {
+	    t[1]++;
+	}
+	carry = ((s += carry) < carry);
+	carry += ((*c++ += s) < s);
+	s = t[1];
+    } while (--size != 0);
+
+    carry = ((s += carry) < carry);
+    return (bool) (carry + ((*c += s) < s));
+# endif
+}
+
+# ifndef KARATSUBA
+# define KARATSUBA	24	/* smallest operand size for Karatsuba */
+# endif
+
 /*
  * NAME:	asi->mult()
  * DESCRIPTION:	c = a * b (sizea - sizeb <= 1)
@@ -207,16 +250,14 @@ static void asi_mult1(Uint *c, Uint a, Uint b)
  */
 static void asi_mult(Uint *c, Uint *t, Uint *a, Uint *b, Uint sizea1, Uint sizeb1)
 {
-    if (sizeb1 == 1) {
-	/* sizea <= 2, sizeb == 1 */
-	asi_mult1(c, a[0], b[0]);
-	if (sizea1 > 1) {
-	    /* sizea == 2, sizeb == 1 */
-	    asi_mult1(t, a[1], b[0]);
-	    if ((c[1] += t[0]) < t[0]) {
-		t[1]++;
-	    }
-	    c[2] = t[1];
+    if (sizeb1 < KARATSUBA) {
+	Uint i;
+
+	/* schoolbook */
+	memset(c, '\0', sizea1 * sizeof(Uint));
+	for (i = 0; i < sizeb1; i++) {
+	    c[sizea1 + i] = 0;
+	    asi_mult_row(c + i, a, b[i], sizea1);
 	}
     } else {
 	Uint sizeab0, sizet2, sizet3, *t2;
@@ -272,7 +313,7 @@ static void asi_mult(Uint *c, Uint *t, Uint *a, Uint *b, Uint sizea1, Uint sizeb
 	if (sizet2 >= sizet3) {
 	    asi_mult(t2, t, c, c + sizet2, sizet2, sizet3);
 	} else {
-	    asi_mult(t2, t, c + sizet2, t2, sizet3, sizet2);
+	    asi_mult(t2, t, c + sizet2, c, sizet3, sizet2);
 	}
 
 	/* c1:c0 = a0 * b0, c3:c2 = a1 * b1 */
@@ -280,11 +321,14 @@ static void asi_mult(Uint *c, Uint *t, Uint *a, Uint *b, Uint sizea1, Uint sizeb
 	asi_mult(c + (sizeab0 << 1), t, a + sizeab0, b + sizeab0, sizea1,
 		 sizeb1);
 
-	/* t1:t0 = c3:c2 + c1:c0 + t3:t2 */
+	/*
+	 * t1:t0 = c3:c2 + c1:c0 + t3:t2, one word wider than the larger of
+	 * c3:c2 and c1:c0, which may be the lower one if the split is uneven
+	 */
 	sizea1 += sizeb1;
+	sizeb1 = ((sizea1 > sizeab0 << 1) ? sizea1 : sizeab0 << 1) + 1;
 	memcpy(t, c + (sizeab0 << 1), sizea1 * sizeof(Uint));
-	t[sizea1] = 0;
-	sizeb1 = sizea1 + 1;
+	memset(t + sizea1, '\0', (sizeb1 - sizea1) * sizeof(Uint));
 	asi_add(t, c, sizeb1, sizeab0 << 1);
 	if (minus) {
 	    asi_sub(t, t2, sizeb1, sizet2 + sizet3);
@@ -297,31 +341,6 @@ static void asi_mult(Uint *c, Uint *t, Uint *a, Uint *b, Uint sizea1, Uint sizeb
     }
 }
 
-/*
- * NAME:	asi->mult_row()
- * DESCRIPTION:	c += a * word
- */
-static bool asi_mult_row(Uint *c, Uint *a, Uint b, Uint size)
-{
-    Uint s, carry;
-    Uint t[2];
-
-    s = 0;
-    carry = 0;
-    do {
-	asi_mult1(t, *a++, b);
-	if ((s += t[0]) < t[0]) {
-	    t[1]++;
-	}
-	carry = ((s += carry) < carry);
-	carry += ((*c++ += s) < s);
-	s = t[1];
-    } while (--size != 0);
-
-    carry = ((s += carry) < carry);
-    return (bool) (carry + ((*c += s) < s));
-}
-
 # ifdef Uuint
 # define asi_sqr1(b, a)	{				\
 			    Uuint _t;			\
@@ -359,6 +378,22 @@ static void asi_sqr(Uint *b, Uint *t, Uint *a, Uint sizea1)
 {
     if (sizea1 == 1) {
 	asi_sqr1(b, a[0]);
+    } else if (sizea1 < KARATSUBA) {
+	Uint i, sq[2];
+
+	/* cross products */
+	memset(b, '\0', (sizea1 + 1) * sizeof(Uint));
+	for (i = 0; i < sizea1 - 1; i++) {
+	    b[sizea1 + i + 1] = 0;
+	    asi_mult_row(b + (i << 1) + 1, a + i + 1, a[i], sizea1 - i - 1);
+	}
+
+	/* double them, and add the squares */
+	asi_lshift(b, sizea1 << 1, 1);
+	for (i = 0; i < sizea1; i++) {
+	    asi_sqr1(sq, a[i]);
+	    asi_add(b + (i << 1), sq, (sizea1 - i) << 1, 2);
+	}
     } else {
 	Uint sizea0, sizet2, *t2;
 
@@ -1316,6 +1351,184 @@ static Uint asn_wordinv(Uint n)
     return n1;
 }
 
+# ifdef Uuuint
+/*
+ * NAME:	asn->dwordinv()
+ * DESCRIPTION:	compute an inverse modulo the double word size (for odd n)
+ */
+static Uuint asn_dwordinv(Uuint n)
+{
+    Uuint n1;
+    int i;
+
+    /* correct to 3 bits, doubling with each iteration */
+    n1 = n;
+    for (i = 5; i > 0; --i) {
+	n1 *= 2 - n * n1;
+    }
+
+    return n1;
+}
+
+/*
+ * NAME:	asn->dmonpro()
+ * DESCRIPTION:	compute the Montgomery product of a and b, in double words
+ *		sizeof(t) = size + 2
+ */
+static void asn_dmonpro(Uuint *c, Uuint *t, Uuint *a, Uuint *b, Uuint *n, Uint size, Uuint n0)
+{
+    Uuuint p;
+    Uuint m, carry;
+    Uint i, j;
+
+    memset(t, '\0', (size + 2) * sizeof(Uuint));
+    for (i = 0; i < size; i++) {
+	/* t += a * b[i] */
+	carry = 0;
+	for (j = 0; j < size; j++) {
+	    p = (Uuuint) a[j] * b[i] + t[j] + carry;
+	    t[j] = (Uuint) p;
+	    carry = (Uuint) (p >> 64);
+	}
+	p = (Uuuint) t[size] + carry;
+	t[size] = (Uuint) p;
+	t[size + 1] = (Uuint) (p >> 64);
+
+	/* t = (t + m * n) / 2 ** 64 */
+	m = t[0] * n0;
+	p = (Uuuint) m * n[0] + t[0];
+	carry = (Uuint) (p >> 64);
+	for (j = 1; j < size; j++) {
+	    p = (Uuuint) m * n[j] + t[j] + carry;
+	    t[j - 1] = (Uuint) p;
+	    carry = (Uuint) (p >> 64);
+	}
+	p = (Uuuint) t[size] + carry;
+	t[size - 1] = (Uuint) p;
+	t[size] = t[size + 1] + (Uuint) (p >> 64);
+    }
+
+    /* t < 2 * n */
+    if (t[size] == 0) {
+	for (i = size; i > 0; ) {
+	    --i;
+	    if (t[i] != n[i]) {
+		break;
+	    }
+	}
+	if (t[i] < n[i]) {
+	    memcpy(c, t, size * sizeof(Uuint));
+	    return;
+	}
+    }
+    carry = 0;
+    for (i = 0; i < size; i++) {
+	m = t[i] - carry;
+	carry = (m > t[i]);
+	c[i] = m - n[i];
+	carry += (c[i] > m);
+    }
+}
+
+/*
+ * NAME:	asn->powqmod()
+ * DESCRIPTION:	compute a ** b % mod (a > 1, b > 1, (mod & 1) != 0)
+ *		sizeof(t) = (sizemod + 1) << 1
+ */
+static void asn_powqmod(Uint *c, Uint *t, Uint *a, Uint *b, Uint *mod, Uint sizea, Uint sizeb, Uint sizemod)
+{
+    Uint size, i, j, bit, bits, window, wsize;
+    Uuint n0, *n, *x, *xx, *y, *tab;
+    Uint *z;
+
+    /* modulus in double words */
+    size = (sizemod + 1) >> 1;
+    n = ALLOCA(Uuint, size * 4 + 2);
+    x = n + size;
+    xx = x + size;
+    y = xx + size;
+    for (i = 0; i < sizemod; i++) {
+	if (i & 1) {
+	    n[i >> 1] |= (Uuint) mod[i] << 32;
+	} else {
+	    n[i >> 1] = mod[i];
+	}
+    }
+
+    /* x = a * R % mod */
+    z = ALLOCA(Uint, (size << 1) + sizea + 2);
+    memset(z, '\0', (size << 1) * sizeof(Uint));
+    memcpy(z + (size << 1), a, sizea * sizeof(Uint));
+    asi_div(z, t, z, mod, (size << 1) + sizea, sizemod);
+    memset(z + sizemod, '\0', ((size << 1) - sizemod) * sizeof(Uint));
+    for (i = 0; i < size; i++) {
+	x[i] = z[i << 1] | ((Uuint) z[(i << 1) + 1] << 32);
+    }
+    AFREE(z);
+
+    /* sliding window size, by number of bits in the exponent */
+    for (bits = 32; !(b[sizeb - 1] & ((Uint) 1 << (bits - 1))); --bits) ;
+    bits += (sizeb - 1) << 5;
+    wsize = (bits > 768) ? 6 : (bits > 240) ? 5 : (bits > 80) ? 4 :
+	    (bits > 24) ? 3 : 1;
+
+    /* tab[] = { odd powers of x } */
+    tab = ALLOCA(Uuint, size << (wsize - 1));
+    memcpy(tab, x, size * sizeof(Uuint));
+    n0 = -asn_dwordinv(n[0]);
+    if (wsize > 1) {
+	asn_dmonpro(xx, y, x, x, n, size, n0);
+	for (i = 1; i < (Uint) 1 << (wsize - 1); i++) {
+	    asn_dmonpro(tab + i * size, y, tab + (i - 1) * size, xx, n, size,
+			n0);
+	}
+    }
+
+    /* left to right */
+    bit = bits - 1;
+    j = bit - ((bit >= wsize) ? wsize - 1 : bit);
+    while (!((b[j >> 5] >> (j & 0x1f)) & 1)) {
+	j++;
+    }
+    for (window = 0, i = bit + 1; i > j; ) {
+	--i;
+	window = (window << 1) | ((b[i >> 5] >> (i & 0x1f)) & 1);
+    }
+    memcpy(x, tab + (window >> 1) * size, size * sizeof(Uuint));
+    bit = j;
+    while (bit != 0) {
+	--bit;
+	if (!((b[bit >> 5] >> (bit & 0x1f)) & 1)) {
+	    asn_dmonpro(x, y, x, x, n, size, n0);
+	    continue;
+	}
+
+	/* window of bits ending in 1 */
+	j = bit - ((bit >= wsize) ? wsize - 1 : bit);
+	while (!((b[j >> 5] >> (j & 0x1f)) & 1)) {
+	    j++;
+	}
+	for (window = 0, i = bit + 1; i > j; ) {
+	    --i;
+	    window = (window << 1) | ((b[i >> 5] >> (i & 0x1f)) & 1);
+	    asn_dmonpro(x, y, x, x, n, size, n0);
+	}
+	asn_dmonpro(x, y, x, tab + (window >> 1) * size, n, size, n0);
+	bit = j;
+    }
+
+    /* c = x * (R ** -1) */
+    memset(xx, '\0', size * sizeof(Uuint));
+    xx[0] = 1;
+    asn_dmonpro(x, y, x, xx, n, size, n0);
+    for (i = 0; i < sizemod; i++) {
+	c[i] = (Uint) (x[i >> 1] >> ((i & 1) << 5));
+    }
+
+    AFREE(tab);
+    AFREE(n);
+}
+# else
 /*
  * NAME:	asn->monpro()
  * DESCRIPTION:	compute the Montgomery product of a and b
@@ -1448,15 +1661,16 @@ static void asn_powqmod(Uint *c, Uint *t, Uint *a, Uint *b, Uint *mod, Uint size
     AFREE(y);
     AFREE(x);
 }
+# endif	/* Uuuint */
 
 /*
  * NAME:	asn->pow2mod()
  * DESCRIPTION:	compute a ** b, (all operations in size words)
- *		sizeof(t) = (size + 1) << 1
+ *		sizeof(t) = size << 2
  */
-static void asn_pow2mod(Uint *c, Uint *t, Uint *a, Uint *b, Uint sizea, Uint size)
+static void asn_pow2mod(Uint *c, Uint *t, Uint *a, Uint *b, Uint sizea, Uint sizeb, Uint size)
 {
-    Uint *x, *y, *z, e, bit, sizeb;
+    Uint *x, *y, *z, e, bit;
 
     x = ALLOCA(Uint, size);
     y = ALLOCA(Uint, size << 1);
@@ -1471,7 +1685,7 @@ static void asn_pow2mod(Uint *c, Uint *t, Uint *a, Uint *b, Uint sizea, Uint siz
     }
 
     /* remove leading zeroes from b */
-    for (sizeb = size; b[sizeb - 1] == 0; --sizeb) {
+    for (; b[sizeb - 1] == 0; --sizeb) {
 	if (sizeb == 1) {
 	    /* a ** 0 = 1 */
 	    memset(c, '\0', size * sizeof(Uint));
@@ -1545,17 +1759,18 @@ static void asn_power(Uint *c, Uint *t, Uint *a, Uint *b, Uint *mod, Uint sizea,
 	 */
 	asn_powqmod(c, t, a, b, mod, sizea, sizeb, sizemod);
     } else {
-	Uint size, i, *x, *y, *z;
-	Uint *q, *qinv, sizeq;
+	Uint size, i, n, *x, *y, *z, *w;
+	Uint *q, *qinv, sizeq, sizeqinv;
 
 	/*
 	 * modulo even number
 	 */
 	x = ALLOCA(Uint, sizemod);
-	y = ALLOCA(Uint, sizemod + 1);
-	z = ALLOCA(Uint, sizemod << 1);
+	y = ALLOCA(Uint, sizemod);
+	z = ALLOCA(Uint, sizemod + 1);
+	w = ALLOCA(Uint, sizemod << 1);
 	q = ALLOCA(Uint, sizemod);
-	qinv = ALLOCA(Uint, sizemod);
+	qinv = ALLOCA(Uint, sizemod + 1);
 
 	/* j = (size << 5) + i = number of least significant zero bits */
 	for (size = 0; mod[size] == 0; size++) ;
@@ -1570,68 +1785,65 @@ static void asn_power(Uint *c, Uint *t, Uint *a, Uint *b, Uint *mod, Uint sizea,
 	}
 
 	/* size = number of words, i = mask */
-	size++;
 	if (i != 0) {
+	    size++;
 	    i = 0xffffffffL >> (32 - i);
 	} else {
 	    i = 0xffffffffL;
 	}
 
-	/* x = b % 2 ** (j - 1) */
-	if (sizeb >= size) {
-	    memcpy(x, b, size * sizeof(Uint));
-	} else {
-	    memcpy(x, b, sizeb * sizeof(Uint));
-	    memset(x + sizeb, '\0', (size - sizeb) * sizeof(Uint));
-	}
-	x[size - 1] &= i >> 1;
-
-	/* y = a ** x % 2 ** j */
-	asn_pow2mod(y, t, a, x, sizea, size);
+	/* y = a ** b % 2 ** j */
+	asn_pow2mod(y, t, a, b, sizea, sizeb, size);
 	y[size - 1] &= i;
 
 	if (sizeq != 1 || q[0] != 1) {
 	    asn_powqmod(x, t, a, b, q, sizea, sizeb, sizeq);
 
 	    /*
-	     * y = x + q * ((y - x) * q ** -1 % 2 ** j)
+	     * c = x + q * ((y - x) * q ** -1 % 2 ** j), with the products
+	     * done in n words
 	     */
-	    if (sizeq < size) {
-		memset(x + sizeq, '\0', (size - sizeq) * sizeof(Uint));
-	    }
+	    n = (size > sizeq) ? size : sizeq;
+	    memset(x + sizeq, '\0', (n - sizeq) * sizeof(Uint));
+	    memset(y + size, '\0', (n - size) * sizeof(Uint));
+	    memset(q + sizeq, '\0', (n - sizeq) * sizeof(Uint));
 	    /* y - x */
 	    asi_sub(y, x, size, size);
 	    /* q ** -1 */
 	    if (size == 1) {
 		qinv[0] = asn_wordinv(q[0]);
-		sizea = 1;
+		sizeqinv = 1;
 	    } else {
 		memset(z, '\0', size * sizeof(Uint));
 		if (i == 0xffffffffL) {
 		    z[size] = 1;
-		    sizea = size + 1;
+		    sizeqinv = size + 1;
 		} else {
 		    z[size - 1] = i + 1;
-		    sizea = size;
+		    sizeqinv = size;
 		}
-		asn_modinv(qinv, &sizea, q, z, sizeq, sizea);
+		asn_modinv(qinv, &sizeqinv, q, z, sizeq, sizeqinv);
 	    }
+	    memset(qinv + sizeqinv, '\0', (n - sizeqinv) * sizeof(Uint));
 	    /* (y - x) * q ** -1 % 2 ** j */
-	    asi_mult(z, t, y, qinv, size, sizea);
+	    asi_mult(w, t, y, qinv, n, n);
+	    memcpy(z, w, size * sizeof(Uint));
+	    memset(z + size, '\0', (n - size) * sizeof(Uint));
 	    z[size - 1] &= i;
-	    /* q * ((y - x) * q ** -1 % 2 ** j) */
-	    asi_mult(y, t, q, z, sizeq, size);
 	    /* x + q * ((y - x) * q ** -1 % 2 ** j) */
-	    asi_add(y, x, sizemod, sizeq);
+	    asi_mult(w, t, q, z, n, n);
+	    asi_add(w, x, sizemod, sizeq);
+	    memcpy(c, w, sizemod * sizeof(Uint));
+	} else {
+	    memcpy(c, y, size * sizeof(Uint));
 	}
 
-	memcpy(c, y, size * sizeof(Uint));
-
 	AFREE(qinv);
 	AFREE(q);
+	AFREE(w);
 	AFREE(z);
 	AFREE(y);
-	AFREE(z);
+	AFREE(x);
     }
 }
 
@@ -20,6 +20,17 @@
 # define INCLUDE_CTYPE
 # include "dgd.h"
 # include "xfloat.h"
+# include <float.h>
+
+/*
+ * A Float maps exactly onto an IEEE double with the low 16 mantissa bits
+ * cleared.  Where the host evaluates doubles in double precision, basic
+ * arithmetic is done with the FPU, and the exact result is then rounded
+ * the way the emulation would have rounded it.
+ */
+# if !defined(NOFPU) && defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+# define FPU_FLOAT
+# endif
 
 struct flt {
     unsigned short sign;	/* 0: positive, 0x8000: negative */
@@ -628,6 +639,207 @@ static void f_xftof(Float *f, flt *a)
 }
 
 
+# ifdef FPU_FLOAT
+# define DBL_FIELD(bits)	((int) ((bits) >> 52) & 0x7ff)
+# define DBL_SAFE(bits)		(DBL_FIELD(bits) > 64 && DBL_FIELD(bits) < 0x7ff - 64)
+# define DBL_MANT(bits)		(((bits) & 0xfffffffffffffLL) | 0x10000000000000LL)
+# define XF_MANT(f)		((((Uuint) ((f)->high & 0x000f) << 32) | (f)->low) \
+				 | 0x1000000000LL)
+
+/*
+ * NAME:	d_bits()
+ * DESCRIPTION:	get the bits of a double
+ */
+static inline Uuint d_bits(double d)
+{
+    Uuint bits;
+
+    memcpy(&bits, &d, sizeof(double));
+    return bits;
+}
+
+/*
+ * NAME:	d_xftod()
+ * DESCRIPTION:	convert Float to double, or return FALSE if the Float is
+ *		zero, or too close to the limits of the range
+ */
+static inline bool d_xftod(Float *f, double *d)
+{
+    Uuint bits;
+
+    bits = ((Uuint) f->high << 48) | ((Uuint) f->low << 16);
+    if (!DBL_SAFE(bits)) {
+	return FALSE;
+    }
+    memcpy(d, &bits, sizeof(double));
+    return TRUE;
+}
+
+/*
+ * NAME:	d_dtoxf()
+ * DESCRIPTION:	Round an exact result to a Float, the way the emulation does
+ *		it: truncate to 44 bits plus 2 guard bits, or to a multiple
+ *		of 2 ** trunc if trunc is not INT_MIN, and round to 44 and
+ *		then to 36 bits, incrementing odd mantissas only.  The exact
+ *		result is d, or slightly smaller in magnitude if below is
+ *		TRUE.  Return FALSE if the result is not within range.
+ */
+static bool d_dtoxf(double d, bool below, int trunc, Float *f)
+{
+    Uuint bits, m;
+    int exp, n;
+
+    bits = d_bits(d);
+    exp = DBL_FIELD(bits);
+    if (exp == 0 || exp == 0x7ff) {
+	return FALSE;
+    }
+    m = DBL_MANT(bits);
+
+    if (trunc == INT_MIN) {
+	if (below && m == 0x10000000000000LL) {
+	    /* exact result is just below a power of two */
+	    m = 0x3fffffffffffLL;
+	    --exp;
+	} else {
+	    m = (m >> 7) - (below && (m & 0x7f) == 0);
+	}
+    } else {
+	n = trunc - (exp - 1023 - 52);
+	if (n < 7 || n > 52) {
+	    return FALSE;
+	}
+	m = (m >> n) - (below && (m & (((Uuint) 1 << n) - 1)) == 0);
+	exp = trunc + 1023 + 45;
+	while (m < ((Uuint) 1 << 45)) {
+	    m <<= 1;
+	    --exp;
+	}
+    }
+
+    /* round */
+    m = (m >> 2) + ((m >> 2) & (m >> 1) & 1);
+    m = (m >> 7) + ((m >> 7) & (m >> 6) & 1);
+    if (m >> 37) {
+	m >>= 1;
+	exp++;
+    }
+
+    if (exp < 1 || exp > 1023 + 1023) {
+	return FALSE;
+    }
+    f->high = (unsigned short) ((bits >> 48) & 0x8000) | (exp << 4) |
+	      ((unsigned short) (m >> 32) & 0x000f);
+    f->low = (Uint) m;
+    return TRUE;
+}
+
+/*
+ * NAME:	d_add()
+ * DESCRIPTION:	add or subtract two Floats with the FPU
+ */
+static bool d_add(Float *f1, Float *f2, bool sub)
+{
+    double a, b, s, t;
+    int exp;
+
+    if (!d_xftod(f1, &a) || !d_xftod(f2, &b)) {
+	return FALSE;
+    }
+    if (sub) {
+	b = -b;
+    }
+
+    s = a + b;
+    if (s == 0.0) {
+	f1->high = 0;
+	f1->low = 0;
+	return TRUE;
+    }
+    if ((a < 0.0) == (b < 0.0)) {
+	/* truncated to the precision of the result */
+	exp = INT_MIN;
+    } else {
+	/* truncated to the precision of the largest operand */
+	exp = DBL_FIELD(d_bits(a));
+	if (DBL_FIELD(d_bits(b)) > exp) {
+	    exp = DBL_FIELD(d_bits(b));
+	}
+	exp -= 1023 + 45;
+    }
+
+    /* the rounding error of the sum */
+    t = s - a;
+    t = (a - (s - t)) + (b - t);
+    return d_dtoxf(s, t != 0.0 && (t < 0.0) != (s < 0.0), exp, f1);
+}
+
+/*
+ * NAME:	d_mult()
+ * DESCRIPTION:	multiply two Floats with the FPU
+ */
+static bool d_mult(Float *f1, Float *f2)
+{
+    double a, b, p;
+    Uuint bits, diff;
+
+    if (!d_xftod(f1, &a) || !d_xftod(f2, &b)) {
+	return FALSE;
+    }
+
+    p = a * b;
+    bits = d_bits(p);
+    if (!DBL_SAFE(bits)) {
+	return FALSE;
+    }
+
+    /* the low bits of the exact product show how it was rounded */
+    diff = XF_MANT(f1) * XF_MANT(f2) -
+	   (DBL_MANT(bits) << (20 + DBL_FIELD(bits) + 1023 -
+			       DBL_FIELD(d_bits(a)) - DBL_FIELD(d_bits(b))));
+    return d_dtoxf(p, diff >> 63, INT_MIN, f1);
+}
+
+/*
+ * NAME:	d_div()
+ * DESCRIPTION:	divide two Floats with the FPU
+ */
+static bool d_div(Float *f1, Float *f2)
+{
+    double a, b, q;
+    Uuint bits, diff;
+    int shift;
+    Uint digits;
+
+    if (!d_xftod(f1, &a) || !d_xftod(f2, &b)) {
+	return FALSE;
+    }
+
+    q = a / b;
+    bits = d_bits(q);
+    if (!DBL_SAFE(bits)) {
+	return FALSE;
+    }
+    shift = 52 + DBL_FIELD(d_bits(a)) - DBL_FIELD(d_bits(b)) -
+	    DBL_FIELD(bits) + 1023;
+
+    /*
+     * f_div() produces 16 quotient bits at a time, and goes wrong when
+     * its estimate for one of the lower two is too large
+     */
+    digits = (Uint) (DBL_MANT(bits) >> (shift - 47));
+    if ((Uint) ((digits & 0xffff) - 1) >= 0xfffd ||
+	((digits >> 16) & 0xffff) >= 0xfffe) {
+	return FALSE;
+    }
+
+    /* the sign of the remainder shows where the exact quotient lies */
+    diff = DBL_MANT(bits) * XF_MANT(f2) - (XF_MANT(f1) << shift);
+    return d_dtoxf(q, diff != 0 && (diff >> 63) == 0, INT_MIN, f1);
+}
+# endif	/* FPU_FLOAT */
+
+
 static flt tens[] = {
     FLT_CONST(0,     3, 0x4000, 0x0000000L),	/* 10 ** 1 */
     FLT_CONST(0,     6, 0x9000, 0x0000000L),	/* 10 ** 2 */
@@ -918,6 +1130,11 @@ void Float::add(Float &f)
 {
     flt a, b;
 
+# ifdef FPU_FLOAT
+    if (d_add(this, &f, FALSE)) {
+	return;
+    }
+# endif
     f_xftof(&f, &b);
     f_xftof(this, &a);
     f_add(&a, &b);
@@ -932,6 +1149,11 @@ void Float::sub(Float &f)
 {
     flt a, b;
 
+# ifdef FPU_FLOAT
+    if (d_add(this, &f, TRUE)) {
+	return;
+    }
+# endif
     f_xftof(&f, &b);
     f_xftof(this, &a);
     f_sub(&a, &b);
@@ -946,6 +1168,11 @@ void Float::mult(Float &f)
 {
     flt a, b;
 
+# ifdef FPU_FLOAT
+    if (d_mult(this, &f)) {
+	return;
+    }
+# endif
     f_xftof(this, &a);
     f_xftof(&f, &b);
     f_mult(&a, &b);
@@ -960,6 +1187,11 @@ void Float::div(Float &f)
 {
     flt a, b;
 
+# ifdef FPU_FLOAT
+    if (d_div(this, &f)) {
+	return;
+    }
+# endif
     f_xftof(&f, &b);
     f_xftof(this, &a);
     f_div(&a, &b);
@@ -19,6 +19,7 @@
 
 # include <sys/time.h>
 # include <sys/socket.h>
+# include <sys/uio.h>
 # include <netinet/in.h>
 # include <arpa/inet.h>
 # include <netdb.h>
@@ -50,6 +51,24 @@
 
 # define NFREE		32
 
+# define UDPBUFSZ	16384		/* datagram ring buffer size */
+# define UDPMASK	(UDPBUFSZ - 1)
+# define UDPBATCH	16		/* max # datagrams per system call */
+# define UDPOBUFSZ	65536		/* datagram output buffer size */
+
+# if UDPBUFSZ < BINBUF_SIZE + 2 || (UDPBUFSZ & UDPMASK) != 0
+# error UDPBUFSZ must be a power of 2, and large enough for any datagram
+# endif
+
+# ifdef MSG_WAITFORONE
+# define UDP_MMSG			/* recvmmsg() and sendmmsg() */
+# endif
+
+# define ATOMIC_LOAD(p)		__atomic_load_n(p, __ATOMIC_ACQUIRE)
+# define ATOMIC_STORE(p, v)	__atomic_store_n(p, v, __ATOMIC_RELEASE)
+# define ATOMIC_ADD(p, v)	__atomic_fetch_add(p, v, __ATOMIC_ACQ_REL)
+# define ATOMIC_SUB(p, v)	__atomic_fetch_sub(p, v, __ATOMIC_ACQ_REL)
+
 struct in46addr {
     union {
 # ifdef INET6
@@ -423,9 +442,10 @@ static void ipa_lookup()
 
 struct connection : public Hashtab::Entry {
     int fd;				/* file descriptor */
-    int npkts;				/* # packets in buffer */
-    int bufsz;				/* # bytes in buffer */
-    char *udpbuf;			/* datagram buffer */
+    int bufsz;				/* # bytes in challenge */
+    char *udpbuf;			/* datagram ring buffer */
+    Uint uhead;				/* ring head, set by UDP thread */
+    Uint utail;				/* ring tail, set by main thread */
     ipaddr *addr;			/* internet address of connection */
     unsigned short port;		/* UDP port of connection */
     short at;				/* port connection was accepted at */
@@ -444,6 +464,26 @@ struct udpdesc {
     unsigned short hashval;		/* address hash */
     int size;				/* size in buffer */
     char buffer[BINBUF_SIZE];		/* buffer */
+    Uint received;			/* # datagrams received */
+    Uint sent;				/* # datagrams sent */
+    Uint dropped;			/* # datagrams dropped */
+    Uint failed;			/* # datagrams that could not be sent */
+};
+
+union udpaddr {
+# ifdef INET6
+    struct sockaddr_in6 in6;		/* IPv6 address */
+# endif
+    struct sockaddr_in in;		/* IPv4 address */
+};
+
+struct udpmsg {
+    int fd;				/* port descriptor */
+    int at;				/* datagram port index */
+    socklen_t tolen;			/* address length */
+    udpaddr to;				/* destination */
+    char *buf;				/* datagram */
+    unsigned int len;			/* datagram length */
 };
 
 static connection **udphtab;		/* UDP hash table */
@@ -455,201 +495,313 @@ static int inpkts, outpkts;		/* UDP packet notification pipe */
 static pthread_t udp;			/* UDP thread */
 static pthread_mutex_t udpmutex;	/* UDP mutex */
 static bool udpstop;			/* stop UDP thread? */
+static Uint udppending;			/* # datagrams not yet processed */
+static char ibufs[UDPBATCH][BINBUF_SIZE]; /* datagram input buffers */
+static udpaddr ifrom[UDPBATCH];		/* datagram source addresses */
+static int isizes[UDPBATCH];		/* datagram sizes */
+static udpmsg uout[UDPBATCH];		/* datagram output queue */
+static int nuout;			/* # datagrams in output queue */
+static char *uobuf;			/* datagram output buffer */
+static unsigned int uobufsz;		/* # bytes in output buffer */
+
+/*
+ * NAME:	udp->recvbatch()
+ * DESCRIPTION:	receive as many UDP packets as are available, up to UDPBATCH
+ */
+static int udp_recvbatch(int fd, socklen_t fromlen)
+{
+# ifdef UDP_MMSG
+    struct mmsghdr msgs[UDPBATCH];
+    struct iovec iov[UDPBATCH];
+    int i, n;
+
+    memset(msgs, '\0', sizeof(msgs));
+    for (i = 0; i < UDPBATCH; i++) {
+	memset(ibufs[i], '\0', UDPHASHSZ);
+	iov[i].iov_base = ibufs[i];
+	iov[i].iov_len = BINBUF_SIZE;
+	msgs[i].msg_hdr.msg_name = &ifrom[i];
+	msgs[i].msg_hdr.msg_namelen = fromlen;
+	msgs[i].msg_hdr.msg_iov = &iov[i];
+	msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    n = recvmmsg(fd, msgs, UDPBATCH, MSG_WAITFORONE, (struct timespec *) NULL);
+    for (i = 0; i < n; i++) {
+	isizes[i] = msgs[i].msg_len;
+    }
+    return n;
+# else
+    memset(ibufs[0], '\0', UDPHASHSZ);
+    isizes[0] = recvfrom(fd, ibufs[0], BINBUF_SIZE, 0,
+			 (struct sockaddr *) &ifrom[0], &fromlen);
+    return (isizes[0] < 0) ? -1 : 1;
+# endif
+}
+
+/*
+ * NAME:	udp->put()
+ * DESCRIPTION:	append a packet to the ring buffer of a connection
+ */
+static bool udp_put(connection *conn, char *buffer, int size)
+{
+    Uint head, offset;
+
+    head = conn->uhead;
+    if (head - ATOMIC_LOAD(&conn->utail) + size + 2 > UDPBUFSZ) {
+	return FALSE;	/* no room */
+    }
+    conn->udpbuf[head++ & UDPMASK] = size >> 8;
+    conn->udpbuf[head++ & UDPMASK] = size;
+    offset = head & UDPMASK;
+    if (offset + size > UDPBUFSZ) {
+	memcpy(conn->udpbuf + offset, buffer, UDPBUFSZ - offset);
+	memcpy(conn->udpbuf, buffer + UDPBUFSZ - offset,
+	       size - (UDPBUFSZ - offset));
+    } else {
+	memcpy(conn->udpbuf + offset, buffer, size);
+    }
+    ATOMIC_STORE(&conn->uhead, head + size);
+    return TRUE;
+}
+
+/*
+ * NAME:	udp->count()
+ * DESCRIPTION:	count the packets in the ring buffer of a connection
+ */
+static int udp_count(connection *conn)
+{
+    Uint tail;
+    int npkts;
+
+    npkts = 0;
+    for (tail = conn->utail; tail != conn->uhead; ) {
+	tail += ((UCHAR(conn->udpbuf[tail & UDPMASK]) << 8) |
+		 UCHAR(conn->udpbuf[(tail + 1) & UDPMASK])) + 2;
+	npkts++;
+    }
+    return npkts;
+}
+
+/*
+ * NAME:	udp->notify()
+ * DESCRIPTION:	make new packets known to the main thread
+ */
+static void udp_notify(int npkts)
+{
+    char c;
+
+    if (ATOMIC_ADD(&udppending, npkts) == 0) {
+	/* wake up main thread */
+	c = '\0';
+	write(outpkts, &c, 1);
+    }
+}
 
 # ifdef INET6
 /*
  * NAME:	udp->recv6()
- * DESCRIPTION:	receive an UDP packet
+ * DESCRIPTION:	receive UDP packets
  */
 static void udp_recv6(int n)
 {
-    char buffer[BINBUF_SIZE];
-    struct sockaddr_in6 from;
-    socklen_t fromlen;
-    int size;
+    struct sockaddr_in6 *from;
+    int i, count, size, npkts;
     unsigned short hashval;
     connection **hash, *conn;
-    char *p;
+    char *buffer;
 
-    memset(buffer, '\0', UDPHASHSZ);
-    fromlen = sizeof(struct sockaddr_in6);
-    size = recvfrom(udescs[n].fd.in6, buffer, BINBUF_SIZE, 0,
-		    (struct sockaddr *) &from, &fromlen);
-    if (size < 0) {
+    count = udp_recvbatch(udescs[n].fd.in6, sizeof(struct sockaddr_in6));
+    if (count <= 0) {
 	return;
     }
 
-    hashval = (Hashtab::hashmem((char *) &from.sin6_addr,
-				sizeof(struct in6_addr)) ^ from.sin6_port) %
-								    udphtabsz;
-    hash = &udphtab[hashval];
+    npkts = 0;
     pthread_mutex_lock(&udpmutex);
-    for (;;) {
-	conn = *hash;
-	if (conn == (connection *) NULL) {
-	    if (!conf_attach(n)) {
-		if (!udescs[n].accept) {
-		    if (IN6_IS_ADDR_V4MAPPED(&from.sin6_addr)) {
-			/* convert to IPv4 address */
-			udescs[n].addr.in.addr = *(struct in_addr *)
-						    &from.sin6_addr.s6_addr[12];
-			udescs[n].addr.ipv6 = FALSE;
+    for (i = 0; i < count; i++) {
+	buffer = ibufs[i];
+	size = isizes[i];
+	from = &ifrom[i].in6;
+	udescs[n].received++;
+
+	hashval = (Hashtab::hashmem((char *) &from->sin6_addr,
+				    sizeof(struct in6_addr)) ^
+		   from->sin6_port) % udphtabsz;
+	hash = &udphtab[hashval];
+	for (;;) {
+	    conn = *hash;
+	    if (conn == (connection *) NULL) {
+		if (!conf_attach(n)) {
+		    if (!udescs[n].accept) {
+			if (IN6_IS_ADDR_V4MAPPED(&from->sin6_addr)) {
+			    /* convert to IPv4 address */
+			    udescs[n].addr.in.addr = *(struct in_addr *)
+						&from->sin6_addr.s6_addr[12];
+			    udescs[n].addr.ipv6 = FALSE;
+			} else {
+			    udescs[n].addr.in.addr6 = from->sin6_addr;
+			    udescs[n].addr.ipv6 = TRUE;
+			}
+			udescs[n].port = from->sin6_port;
+			udescs[n].hashval = hashval;
+			udescs[n].size = size;
+			memcpy(udescs[n].buffer, buffer, size);
+			udescs[n].accept = TRUE;
+			npkts++;
 		    } else {
-			udescs[n].addr.in.addr6 = from.sin6_addr;
-			udescs[n].addr.ipv6 = TRUE;
+			udescs[n].dropped++;
 		    }
-		    udescs[n].port = from.sin6_port;
-		    udescs[n].hashval = hashval;
-		    udescs[n].size = size;
-		    memcpy(udescs[n].buffer, buffer, size);
-		    udescs[n].accept = TRUE;
-		    write(outpkts, buffer, 1);
+		    break;
 		}
-		break;
-	    }
 
-	    /*
-	     * see if the packet matches an outstanding challenge
-	     */
-	    hash = (connection **) chtab->lookup(buffer, FALSE);
-	    while ((conn=*hash) != (connection *) NULL &&
-		   memcmp(conn->name, buffer, UDPHASHSZ) == 0) {
-		if (conn->bufsz == size &&
-		    memcmp(conn->udpbuf, buffer, size) == 0 &&
-		    conn->addr->ipnum.ipv6 &&
-		    memcmp(&conn->addr->ipnum, &from.sin6_addr,
-			   sizeof(struct in6_addr)) == 0) {
-		    /*
-		     * attach new UDP channel
-		     */
-		    *hash = (connection *) conn->next;
-		    conn->name = (char *) NULL;
-		    conn->bufsz = 0;
-		    conn->port = from.sin6_port;
-		    hash = &udphtab[hashval];
-		    conn->next = *hash;
-		    *hash = conn;
-
-		    break;
+		/*
+		 * see if the packet matches an outstanding challenge
+		 */
+		hash = (connection **) chtab->lookup(buffer, FALSE);
+		while ((conn=*hash) != (connection *) NULL &&
+		       memcmp(conn->name, buffer, UDPHASHSZ) == 0) {
+		    if (conn->bufsz == size &&
+			memcmp(conn->udpbuf, buffer, size) == 0 &&
+			conn->addr->ipnum.ipv6 &&
+			memcmp(&conn->addr->ipnum, &from->sin6_addr,
+			       sizeof(struct in6_addr)) == 0) {
+			/*
+			 * attach new UDP channel
+			 */
+			*hash = (connection *) conn->next;
+			conn->name = (char *) NULL;
+			conn->bufsz = 0;
+			conn->port = from->sin6_port;
+			hash = &udphtab[hashval];
+			conn->next = *hash;
+			*hash = conn;
+
+			break;
+		    }
+		    hash = (connection **) &conn->next;
 		}
-		hash = (connection **) &conn->next;
+		break;
 	    }
-	    break;
-	}
 
-	if (conn->at == n && conn->port == from.sin6_port &&
-	    memcmp(&conn->addr->ipnum, &from.sin6_addr,
-		   sizeof(struct in6_addr)) == 0) {
-	    /*
-	     * packet from known correspondent
-	     */
-	    if (conn->bufsz + size <= BINBUF_SIZE) {
-		p = conn->udpbuf + conn->bufsz;
-		*p++ = size >> 8;
-		*p++ = size;
-		memcpy(p, buffer, size);
-		conn->bufsz += size + 2;
-		conn->npkts++;
-		write(outpkts, buffer, 1);
+	    if (conn->at == n && conn->port == from->sin6_port &&
+		memcmp(&conn->addr->ipnum, &from->sin6_addr,
+		       sizeof(struct in6_addr)) == 0) {
+		/*
+		 * packet from known correspondent
+		 */
+		if (udp_put(conn, buffer, size)) {
+		    npkts++;
+		} else {
+		    udescs[n].dropped++;
+		}
+		break;
 	    }
-	    break;
+	    hash = (connection **) &conn->next;
 	}
-	hash = (connection **) &conn->next;
     }
     pthread_mutex_unlock(&udpmutex);
+
+    if (npkts != 0) {
+	udp_notify(npkts);
+    }
 }
 # endif
 
 /*
  * NAME:	udp->recv()
- * DESCRIPTION:	receive an UDP packet
+ * DESCRIPTION:	receive UDP packets
  */
 static void udp_recv(int n)
 {
-    char buffer[BINBUF_SIZE];
-    struct sockaddr_in from;
-    socklen_t fromlen;
-    int size;
+    struct sockaddr_in *from;
+    int i, count, size, npkts;
     unsigned short hashval;
     connection **hash, *conn;
-    char *p;
+    char *buffer;
 
-    memset(buffer, '\0', UDPHASHSZ);
-    fromlen = sizeof(struct sockaddr_in);
-    size = recvfrom(udescs[n].fd.in4, buffer, BINBUF_SIZE, 0,
-		    (struct sockaddr *) &from, &fromlen);
-    if (size < 0) {
+    count = udp_recvbatch(udescs[n].fd.in4, sizeof(struct sockaddr_in));
+    if (count <= 0) {
 	return;
     }
 
-    hashval = ((Uint) from.sin_addr.s_addr ^ from.sin_port) % udphtabsz;
-    hash = &udphtab[hashval];
+    npkts = 0;
     pthread_mutex_lock(&udpmutex);
-    for (;;) {
-	conn = *hash;
-	if (conn == (connection *) NULL) {
-	    if (!conf_attach(n)) {
-		if (!udescs[n].accept) {
-		    udescs[n].addr.in.addr = from.sin_addr;
-		    udescs[n].addr.ipv6 = FALSE;
-		    udescs[n].port = from.sin_port;
-		    udescs[n].hashval = hashval;
-		    udescs[n].size = size;
-		    memcpy(udescs[n].buffer, buffer, size);
-		    udescs[n].accept = TRUE;
-		    write(outpkts, buffer, 1);
+    for (i = 0; i < count; i++) {
+	buffer = ibufs[i];
+	size = isizes[i];
+	from = &ifrom[i].in;
+	udescs[n].received++;
+
+	hashval = ((Uint) from->sin_addr.s_addr ^ from->sin_port) % udphtabsz;
+	hash = &udphtab[hashval];
+	for (;;) {
+	    conn = *hash;
+	    if (conn == (connection *) NULL) {
+		if (!conf_attach(n)) {
+		    if (!udescs[n].accept) {
+			udescs[n].addr.in.addr = from->sin_addr;
+			udescs[n].addr.ipv6 = FALSE;
+			udescs[n].port = from->sin_port;
+			udescs[n].hashval = hashval;
+			udescs[n].size = size;
+			memcpy(udescs[n].buffer, buffer, size);
+			udescs[n].accept = TRUE;
+			npkts++;
+		    } else {
+			udescs[n].dropped++;
+		    }
+		    break;
 		}
-		break;
-	    }
 
-	    /*
-	     * see if the packet matches an outstanding challenge
-	     */
-	    hash = (connection **) chtab->lookup(buffer, FALSE);
-	    while ((conn=*hash) != (connection *) NULL &&
-		   memcmp((*hash)->name, buffer, UDPHASHSZ) == 0) {
-		if (conn->bufsz == size &&
-		    memcmp(conn->udpbuf, buffer, size) == 0 &&
-		    !conn->addr->ipnum.ipv6 &&
-		    conn->addr->ipnum.in.addr.s_addr == from.sin_addr.s_addr) {
-		    /*
-		     * attach new UDP channel
-		     */
-		    *hash = (connection *) conn->next;
-		    conn->name = (char *) NULL;
-		    conn->bufsz = 0;
-		    conn->port = from.sin_port;
-		    hash = &udphtab[hashval];
-		    conn->next = *hash;
-		    *hash = conn;
-
-		    break;
+		/*
+		 * see if the packet matches an outstanding challenge
+		 */
+		hash = (connection **) chtab->lookup(buffer, FALSE);
+		while ((conn=*hash) != (connection *) NULL &&
+		       memcmp((*hash)->name, buffer, UDPHASHSZ) == 0) {
+		    if (conn->bufsz == size &&
+			memcmp(conn->udpbuf, buffer, size) == 0 &&
+			!conn->addr->ipnum.ipv6 &&
+			conn->addr->ipnum.in.addr.s_addr ==
+							from->sin_addr.s_addr) {
+			/*
+			 * attach new UDP channel
+			 */
+			*hash = (connection *) conn->next;
+			conn->name = (char *) NULL;
+			conn->bufsz = 0;
+			conn->port = from->sin_port;
+			hash = &udphtab[hashval];
+			conn->next = *hash;
+			*hash = conn;
+
+			break;
+		    }
+		    hash = (connection **) &conn->next;
 		}
-		hash = (connection **) &conn->next;
+		break;
 	    }
-	    break;
-	}
 
-	if (conn->at == n &&
-	    conn->addr->ipnum.in.addr.s_addr == from.sin_addr.s_addr &&
-	    conn->port == from.sin_port) {
-	    /*
-	     * packet from known correspondent
-	     */
-	    if (conn->bufsz + size <= BINBUF_SIZE) {
-		p = conn->udpbuf + conn->bufsz;
-		*p++ = size >> 8;
-		*p++ = size;
-		memcpy(p, buffer, size);
-		conn->bufsz += size + 2;
-		conn->npkts++;
-		write(outpkts, buffer, 1);
+	    if (conn->at == n &&
+		conn->addr->ipnum.in.addr.s_addr == from->sin_addr.s_addr &&
+		conn->port == from->sin_port) {
+		/*
+		 * packet from known correspondent
+		 */
+		if (udp_put(conn, buffer, size)) {
+		    npkts++;
+		} else {
+		    udescs[n].dropped++;
+		}
+		break;
 	    }
-	    break;
+	    hash = (connection **) &conn->next;
 	}
-	hash = (connection **) &conn->next;
     }
     pthread_mutex_unlock(&udpmutex);
+
+    if (npkts != 0) {
+	udp_notify(npkts);
+    }
 }
 
 extern "C" {
@@ -1073,6 +1225,8 @@ bool conn_init(int maxusers, char **thosts, char **bhosts, char **dhosts,
 	}
 
 	udescs[n].accept = FALSE;
+	udescs[n].received = udescs[n].sent = udescs[n].dropped = 0;
+	udescs[n].failed = 0;
     }
 
     flist = (connection *) NULL;
@@ -1086,7 +1240,11 @@ bool conn_init(int maxusers, char **thosts, char **bhosts, char **dhosts,
     udphtab = ALLOC(connection*, udphtabsz = maxusers);
     memset(udphtab, '\0', udphtabsz * sizeof(connection*));
     chtab = Hashtab::create(maxusers, UDPHASHSZ, TRUE);
+    udppending = 0;
+    nuout = 0;
+    uobufsz = 0;
     if (nudescs != 0) {
+	uobuf = ALLOC(char, UDPOBUFSZ);
 	udpstop = FALSE;
 	pthread_mutex_init(&udpmutex, NULL);
 	if (pthread_create(&udp, NULL, &udp_run, (void *) NULL) < 0) {
@@ -1334,7 +1492,7 @@ static connection *conn_udpaccept(int port)
     flist = (connection *) conn->next;
     conn->name = (char *) NULL;
     m_static();
-    conn->udpbuf = ALLOC(char, BINBUF_SIZE + 2);
+    conn->udpbuf = ALLOC(char, UDPBUFSZ);
     m_dynamic();
     hash = &udphtab[udescs[port].hashval];
     pthread_mutex_lock(&udpmutex);
@@ -1344,11 +1502,9 @@ static connection *conn_udpaccept(int port)
     conn->addr = ipa_new(&udescs[port].addr);
     conn->port = udescs[port].port;
     conn->at = port;
-    conn->udpbuf[0] = udescs[port].size >> 8;
-    conn->udpbuf[1] = udescs[port].size;
-    memcpy(conn->udpbuf + 2, udescs[port].buffer, udescs[port].size);
-    conn->bufsz = udescs[port].size + 2;
-    conn->npkts = 1;
+    conn->bufsz = 0;
+    conn->uhead = conn->utail = 0;
+    udp_put(conn, udescs[port].buffer, udescs[port].size);
     udescs[port].accept = FALSE;
     pthread_mutex_unlock(&udpmutex);
 
@@ -1486,9 +1642,9 @@ bool conn_udp(connection *conn, char *challenge, unsigned int len)
 
     conn->next = *hash;
     *hash = conn;
-    conn->npkts = 0;
+    conn->uhead = conn->utail = 0;
     m_static();
-    conn->udpbuf = ALLOC(char, BINBUF_SIZE + 2);
+    conn->udpbuf = ALLOC(char, UDPBUFSZ);
     m_dynamic();
     memset(conn->udpbuf, '\0', UDPHASHSZ);
     conn->name = (const char *) memcpy(conn->udpbuf, challenge, conn->bufsz = len);
@@ -1504,6 +1660,7 @@ bool conn_udp(connection *conn, char *challenge, unsigned int len)
 void conn_del(connection *conn)
 {
     connection **hash;
+    int npkts;
 
     if (conn->fd >= 0) {
 	shutdown(conn->fd, SHUT_WR);
@@ -1532,8 +1689,9 @@ void conn_del(connection *conn)
 	    hash = (connection **) &(*hash)->next;
 	}
 	*hash = (connection *) conn->next;
-	if (conn->npkts != 0) {
-	    read(inpkts, conn->udpbuf, conn->npkts);
+	npkts = udp_count(conn);
+	if (npkts != 0) {
+	    ATOMIC_SUB(&udppending, npkts);
 	}
 	pthread_mutex_unlock(&udpmutex);
 	FREE(conn->udpbuf);
@@ -1598,7 +1756,7 @@ int conn_select(Uint t, unsigned int mtime)
 	}
     }
     memcpy(&writefds, &waitfds, sizeof(fd_set));
-    if (closed != 0) {
+    if (closed != 0 || ATOMIC_LOAD(&udppending) != 0) {
 	t = 0;
 	mtime = 0;
     }
@@ -1616,6 +1774,15 @@ int conn_select(Uint t, unsigned int mtime)
 	retval = 0;
     }
     retval += closed;
+    if (FD_ISSET(inpkts, &readfds)) {
+	char buf[64];
+
+	/* drain wakeup pipe; pending datagrams are counted separately */
+	read(inpkts, buf, sizeof(buf));
+    }
+    if (ATOMIC_LOAD(&udppending) != 0) {
+	retval++;
+    }
 
     /*
      * Now check writability for all sockets in a polling call.
@@ -1673,28 +1840,34 @@ int conn_read(connection *conn, char *buf, unsigned int len)
  */
 int conn_udpread(connection *conn, char *buf, unsigned int len)
 {
-    unsigned short size, n;
-    char *p, *q, discard;
+    Uint head, tail, offset;
+    unsigned short size;
 
-    pthread_mutex_lock(&udpmutex);
-    while (conn->bufsz != 0) {
+    /* the UDP thread only appends, so no lock is needed here */
+    head = ATOMIC_LOAD(&conn->uhead);
+    tail = conn->utail;
+    while (tail != head) {
 	/* udp buffer is not empty */
-	size = (UCHAR(conn->udpbuf[0]) << 8) | UCHAR(conn->udpbuf[1]);
+	size = (UCHAR(conn->udpbuf[tail & UDPMASK]) << 8) |
+	       UCHAR(conn->udpbuf[(tail + 1) & UDPMASK]);
+	tail += 2;
 	if (size <= len) {
-	    memcpy(buf, conn->udpbuf + 2, len = size);
-	}
-	--conn->npkts;
-	read(inpkts, &discard, 1);
-	conn->bufsz -= size + 2;
-	for (p = conn->udpbuf, q = p + size + 2, n = conn->bufsz; n != 0; --n) {
-	    *p++ = *q++;
+	    offset = tail & UDPMASK;
+	    if (offset + size > UDPBUFSZ) {
+		memcpy(buf, conn->udpbuf + offset, UDPBUFSZ - offset);
+		memcpy(buf + UDPBUFSZ - offset, conn->udpbuf,
+		       size - (UDPBUFSZ - offset));
+	    } else {
+		memcpy(buf, conn->udpbuf + offset, size);
+	    }
 	}
-	if (len == size) {
-	    pthread_mutex_unlock(&udpmutex);
-	    return len;
+	tail += size;
+	ATOMIC_STORE(&conn->utail, tail);
+	ATOMIC_SUB(&udppending, 1);
+	if (size <= len) {
+	    return size;
 	}
     }
-    pthread_mutex_unlock(&udpmutex);
     return -1;
 }
 
@@ -1734,40 +1907,179 @@ int conn_write(connection *conn, char *buf, unsigned int len)
     return size;
 }
 
+/*
+ * NAME:	conn->writev()
+ * DESCRIPTION:	write several buffers to a connection at once; return the
+ *		amount of bytes written
+ */
+int conn_writev(connection *conn, char **bufs, unsigned int *lens, int n)
+{
+    struct iovec *iov;
+    unsigned int len;
+    int i, size;
+
+    if (n == 1) {
+	return conn_write(conn, bufs[0], lens[0]);
+    }
+    if (conn->fd < 0) {
+	return -1;
+    }
+    if (!FD_ISSET(conn->fd, &writefds)) {
+	/* the write would fail */
+	FD_SET(conn->fd, &waitfds);
+	return 0;
+    }
+    iov = ALLOCA(struct iovec, n);
+    for (len = 0, i = 0; i < n; i++) {
+	iov[i].iov_base = bufs[i];
+	iov[i].iov_len = lens[i];
+	len += lens[i];
+    }
+    size = (len != 0) ? writev(conn->fd, iov, n) : 0;
+    AFREE(iov);
+    if (size < 0 && errno != EWOULDBLOCK) {
+	close(conn->fd);
+	FD_CLR(conn->fd, &infds);
+	FD_CLR(conn->fd, &outfds);
+	conn->fd = -1;
+	closed++;
+    } else if ((unsigned int) size != len) {
+	/* waiting for wrdone */
+	FD_SET(conn->fd, &waitfds);
+	FD_CLR(conn->fd, &writefds);
+	if (size < 0) {
+	    return 0;
+	}
+    }
+    return size;
+}
+
 /*
  * NAME:	conn->udpwrite()
- * DESCRIPTION:	write a message to a UDP channel
+ * DESCRIPTION:	queue a message for a UDP channel, return the number of bytes
+ *		queued or -1; failures to send are counted by conn_udpflush()
  */
 int conn_udpwrite(connection *conn, char *buf, unsigned int len)
 {
+    udpmsg *msg;
+    int size;
+
     if (conn->fd != -1) {
+	if (nuout == UDPBATCH || uobufsz + len > UDPOBUFSZ) {
+	    conn_udpflush();
+	}
+	msg = &uout[nuout];
 # ifdef INET6
 	if (conn->addr->ipnum.ipv6) {
-	    struct sockaddr_in6 to;
-
-	    memset(&to, '\0', sizeof(struct sockaddr_in6));
-	    to.sin6_family = AF_INET6;
-	    memcpy(&to.sin6_addr, &conn->addr->ipnum.in.addr6,
+	    memset(&msg->to.in6, '\0', sizeof(struct sockaddr_in6));
+	    msg->to.in6.sin6_family = AF_INET6;
+	    memcpy(&msg->to.in6.sin6_addr, &conn->addr->ipnum.in.addr6,
 		   sizeof(struct in6_addr));
-	    to.sin6_port = conn->port;
-	    return sendto(udescs[conn->at].fd.in6, buf, len, 0,
-			  (struct sockaddr *) &to, sizeof(struct sockaddr_in6));
+	    msg->to.in6.sin6_port = conn->port;
+	    msg->tolen = sizeof(struct sockaddr_in6);
+	    msg->fd = udescs[conn->at].fd.in6;
 	} else
 # endif
 	{
-	    struct sockaddr_in to;
-
-	    memset(&to, '\0', sizeof(struct sockaddr_in));
-	    to.sin_family = AF_INET;
-	    to.sin_addr = conn->addr->ipnum.in.addr;
-	    to.sin_port = conn->port;
-	    return sendto(udescs[conn->at].fd.in4, buf, len, 0,
-			  (struct sockaddr *) &to, sizeof(struct sockaddr_in));
+	    memset(&msg->to.in, '\0', sizeof(struct sockaddr_in));
+	    msg->to.in.sin_family = AF_INET;
+	    msg->to.in.sin_addr = conn->addr->ipnum.in.addr;
+	    msg->to.in.sin_port = conn->port;
+	    msg->tolen = sizeof(struct sockaddr_in);
+	    msg->fd = udescs[conn->at].fd.in4;
+	}
+	msg->at = conn->at;
+
+	if (len > UDPOBUFSZ) {
+	    /* too large to queue */
+	    size = sendto(msg->fd, buf, len, 0, (struct sockaddr *) &msg->to,
+			  msg->tolen);
+	    if (size < 0) {
+		udescs[conn->at].failed++;
+	    } else {
+		udescs[conn->at].sent++;
+	    }
+	    return size;
 	}
+	msg->buf = (char *) memcpy(uobuf + uobufsz, buf, len);
+	msg->len = len;
+	uobufsz += len;
+	nuout++;
+	return len;
     }
     return -1;
 }
 
+/*
+ * NAME:	conn->udpflush()
+ * DESCRIPTION:	send all queued UDP messages
+ */
+void conn_udpflush()
+{
+    udpmsg *msg;
+    int i;
+# ifdef UDP_MMSG
+    struct mmsghdr msgs[UDPBATCH];
+    struct iovec iov[UDPBATCH];
+    int j, n, sent, size;
+
+    memset(msgs, '\0', nuout * sizeof(struct mmsghdr));
+    for (i = 0; i < nuout; i = j) {
+	/* send a batch of messages on the same port */
+	msg = &uout[i];
+	for (j = i, n = 0; j < nuout && uout[j].fd == msg->fd; j++, n++) {
+	    iov[n].iov_base = uout[j].buf;
+	    iov[n].iov_len = uout[j].len;
+	    msgs[n].msg_hdr.msg_name = &uout[j].to;
+	    msgs[n].msg_hdr.msg_namelen = uout[j].tolen;
+	    msgs[n].msg_hdr.msg_iov = &iov[n];
+	    msgs[n].msg_hdr.msg_iovlen = 1;
+	}
+	for (sent = 0; sent < n; sent += size) {
+	    size = sendmmsg(msg->fd, msgs + sent, n - sent, 0);
+	    if (size <= 0) {
+		if (size < 0 && errno == EINTR) {
+		    size = 0;
+		    continue;
+		}
+		/* the first unsent message failed: skip it */
+		udescs[uout[i + sent].at].failed++;
+		size = 1;
+	    } else {
+		for (j = sent; j < sent + size; j++) {
+		    udescs[uout[i + j].at].sent++;
+		}
+	    }
+	}
+	j = i + n;
+    }
+# else
+    for (i = nuout, msg = uout; i != 0; --i, msg++) {
+	if (sendto(msg->fd, msg->buf, msg->len, 0, (struct sockaddr *) &msg->to,
+		   msg->tolen) < 0) {
+	    udescs[msg->at].failed++;
+	} else {
+	    udescs[msg->at].sent++;
+	}
+    }
+# endif
+    nuout = 0;
+    uobufsz = 0;
+}
+
+/*
+ * NAME:	conn->udpcount()
+ * DESCRIPTION:	return datagram statistics for a port
+ */
+void conn_udpcount(int port, Uint *received, Uint *sent, Uint *dropped,
+		   Uint *failed)
+{
+    *received = udescs[port].received;
+    *sent = udescs[port].sent;
+    *dropped = udescs[port].dropped;
+    *failed = udescs[port].failed;
+}
+
 /*
  * NAME:	conn->wrdone()
  * DESCRIPTION:	return TRUE if a connection is ready for output
@@ -2043,9 +2355,32 @@ bool conn_export(connection *conn, int *fd, char *addr, unsigned short *port,
     if (conn->fd != -1) {
 	*flags = 0;
 	*at = conn->at;
-	*npkts = conn->npkts;
+	*npkts = 0;
 	*bufsz = conn->bufsz;
 	*buf = conn->udpbuf;
+	if (conn->udpbuf != (char *) NULL && conn->name == (char *) NULL) {
+	    Uint tail, offset;
+	    char *ring;
+
+	    /*
+	     * make the ring buffer contiguous
+	     */
+	    pthread_mutex_lock(&udpmutex);
+	    tail = conn->utail;
+	    *npkts = udp_count(conn);
+	    *bufsz = conn->uhead - tail;
+	    offset = tail & UDPMASK;
+	    if (offset != 0) {
+		ring = ALLOC(char, UDPBUFSZ);
+		memcpy(ring, conn->udpbuf + offset, UDPBUFSZ - offset);
+		memcpy(ring + UDPBUFSZ - offset, conn->udpbuf, offset);
+		memcpy(conn->udpbuf, ring, UDPBUFSZ);
+		FREE(ring);
+	    }
+	    conn->uhead -= tail;
+	    conn->utail = 0;
+	    pthread_mutex_unlock(&udpmutex);
+	}
 	if (FD_ISSET(conn->fd, &readfds)) {
 	    *flags |= CONN_READF;
 	}
@@ -2089,7 +2424,7 @@ connection *conn_import(int fd, char *addr, unsigned short port, short at,
     conn->udpbuf = (char *) NULL;
     conn->addr = (ipaddr *) NULL;
     conn->bufsz = 0;
-    conn->npkts = 0;
+    conn->uhead = conn->utail = 0;
     conn->port = port;
     conn->at = -1;
 
@@ -2127,11 +2462,11 @@ connection *conn_import(int fd, char *addr, unsigned short port, short at,
 	    if (flags & CONN_UCHAN) {
 		connection **hash;
 
-		conn->bufsz = bufsz;
 		m_static();
-		conn->udpbuf = ALLOC(char, BINBUF_SIZE + 2);
+		conn->udpbuf = ALLOC(char, UDPBUFSZ);
 		m_dynamic();
 		memcpy(conn->udpbuf, buf, bufsz);
+		conn->uhead = bufsz;
 # ifdef INET6
 		if (inaddr.ipv6) {
 		    hash = &udphtab[(Hashtab::hashmem((char *) &inaddr.in.addr6,
@@ -2143,8 +2478,9 @@ connection *conn_import(int fd, char *addr, unsigned short port, short at,
 		conn->next = *hash;
 		*hash = conn;
 	    }
-	    conn->npkts = npkts;
-	    write(outpkts, conn->udpbuf, npkts);
+	    if (npkts != 0) {
+		udp_notify(npkts);
+	    }
 	}
     } else {
 	closed++;
@@ -17,8 +17,22 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+# define INCLUDE_FILE_IO
 # include "dgd.h"
 # include <signal.h>
+# include <sys/mman.h>
+# include <pthread.h>
+
+# define NPREFETCH	2		/* max # mappings being prefetched */
+
+struct prefetch {
+    char *addr;			/* mapped region */
+    size_t size;		/* size of mapped region */
+    bool stop;			/* stop prefetching? */
+    pthread_t thread;		/* prefetch thread */
+};
+
+static prefetch prefetches[NPREFETCH];	/* prefetched mappings */
 
 extern "C" {
 
@@ -59,3 +73,93 @@ void P_message(const char *mess)
     fputs(mess, stderr);
     fflush(stderr);
 }
+
+/*
+ * NAME:	P->mmap()
+ * DESCRIPTION:	map a file into memory for reading, or return NULL
+ */
+char *P_mmap(int fd, size_t size)
+{
+    void *addr;
+
+    if (size == 0) {
+	return (char *) NULL;
+    }
+    addr = mmap((void *) NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    return (addr == MAP_FAILED) ? (char *) NULL : (char *) addr;
+}
+
+/*
+ * NAME:	P->munmap()
+ * DESCRIPTION:	unmap a file mapped with P_mmap()
+ */
+void P_munmap(char *addr, size_t size)
+{
+    prefetch *p;
+    int i;
+
+    for (i = NPREFETCH, p = prefetches; i > 0; --i, p++) {
+	if (p->addr == addr) {
+	    /* stop prefetching before the mapping disappears */
+	    __atomic_store_n(&p->stop, TRUE, __ATOMIC_RELAXED);
+	    pthread_join(p->thread, NULL);
+	    p->addr = (char *) NULL;
+	}
+    }
+    munmap(addr, size);
+}
+
+/*
+ * NAME:	prefetcher()
+ * DESCRIPTION:	prefetch thread: page in a mapped file from start to end
+ */
+static void *prefetcher(void *arg)
+{
+    prefetch *p;
+    size_t pagesize, i;
+    volatile char c;
+
+    p = (prefetch *) arg;
+    pagesize = sysconf(_SC_PAGESIZE);
+    for (i = 0; i < p->size; i += pagesize) {
+	if (__atomic_load_n(&p->stop, __ATOMIC_RELAXED)) {
+	    break;
+	}
+	c = p->addr[i];
+    }
+    (void) c;
+    return NULL;
+}
+
+/*
+ * NAME:	P->prefetch()
+ * DESCRIPTION:	page in a mapped file in the background
+ */
+void P_prefetch(char *addr, size_t size)
+{
+    prefetch *p;
+    int i;
+
+    for (i = NPREFETCH, p = prefetches; i > 0; --i, p++) {
+	if (p->addr == (char *) NULL) {
+	    posix_madvise(addr, size, POSIX_MADV_WILLNEED);
+	    p->addr = addr;
+	    p->size = size;
+	    p->stop = FALSE;
+	    if (pthread_create(&p->thread, NULL, &prefetcher, p) != 0) {
+		p->addr = (char *) NULL;
+	    }
+	    return;
+	}
+    }
+}
+
+/*
+ * NAME:	P->madvise()
+ * DESCRIPTION:	tell the kernel how a mapped file is going to be accessed
+ */
+void P_madvise(char *addr, size_t size, bool sequential)
+{
+    posix_madvise(addr, size,
+		  (sequential) ? POSIX_MADV_SEQUENTIAL : POSIX_MADV_RANDOM);
+}
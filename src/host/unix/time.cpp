@@ -43,6 +43,25 @@ Uint P_mtime(unsigned short *milli)
     return (Uint) time.tv_sec;
 }
 
+/*
+ * NAME:	P->utime()
+ * DESCRIPTION:	return a monotonic time in microseconds
+ */
+Uuint P_utime()
+{
+# ifdef CLOCK_MONOTONIC
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (Uuint) time.tv_sec * 1000000 + time.tv_nsec / 1000;
+# else
+    struct timeval time;
+
+    gettimeofday(&time, (struct timezone *) NULL);
+    return (Uuint) time.tv_sec * 1000000 + time.tv_usec;
+# endif
+}
+
 /*
  * NAME:	P->ctime()
  * DESCRIPTION:	convert the given time to a string
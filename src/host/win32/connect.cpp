@@ -371,7 +371,10 @@ struct udpdesc {
     unsigned short hashval;		/* address hash */
     int size;				/* size in buffer */
     char buffer[BINBUF_SIZE];		/* buffer */
-
+    Uint received;			/* # datagrams received */
+    Uint sent;				/* # datagrams sent */
+    Uint dropped;			/* # datagrams dropped */
+    Uint failed;			/* # datagrams that could not be sent */
 };
 
 static connection **udphtab;		/* UDP hash table */
@@ -404,6 +407,7 @@ static void udp_recv6(int n)
     if (size < 0) {
 	return;
     }
+    udescs[n].received++;
 
     hashval = (Hashtab::hashmem((char *) &from.sin6_addr,
 			        sizeof(struct in6_addr)) ^ from.sin6_port) %
@@ -423,6 +427,8 @@ static void udp_recv6(int n)
 		    memcpy(udescs[n].buffer, buffer, size);
 		    udescs[n].accept = TRUE;
 		    send(outpkts, buffer, 1, 0);
+		} else {
+		    udescs[n].dropped++;
 		}
 		break;
 	    }
@@ -470,6 +476,8 @@ static void udp_recv6(int n)
 		conn->bufsz += size + 2;
 		conn->npkts++;
 		send(outpkts, buffer, 1, 0);
+	    } else {
+		udescs[n].dropped++;
 	    }
 	    break;
 	}
@@ -499,6 +507,7 @@ static void udp_recv(int n)
     if (size < 0) {
 	return;
     }
+    udescs[n].received++;
 
     hashval = ((Uint) from.sin_addr.s_addr ^ from.sin_port) % udphtabsz;
     hash = &udphtab[hashval];
@@ -516,6 +525,8 @@ static void udp_recv(int n)
 		    memcpy(udescs[n].buffer, buffer, size);
 		    udescs[n].accept = TRUE;
 		    send(outpkts, buffer, 1, 0);
+		} else {
+		    udescs[n].dropped++;
 		}
 		break;
 	    }
@@ -562,6 +573,8 @@ static void udp_recv(int n)
 		conn->bufsz += size + 2;
 		conn->npkts++;
 		send(outpkts, buffer, 1, 0);
+	    } else {
+		udescs[n].dropped++;
 	    }
 	    break;
 	}
@@ -976,6 +989,8 @@ bool conn_init(int maxusers, char **thosts, char **bhosts, char **dhosts,
 	}
 
 	udescs[n].accept = FALSE;
+	udescs[n].received = udescs[n].sent = udescs[n].dropped = 0;
+	udescs[n].failed = 0;
     }
 
     flist = (connection *) NULL;
@@ -1613,12 +1628,36 @@ int conn_write(connection *conn, char *buf, unsigned int len)
     return (size == SOCKET_ERROR) ? -1 : size;
 }
 
+/*
+ * NAME:	conn->writev()
+ * DESCRIPTION:	write several buffers to a connection; return the amount of
+ *		bytes written
+ */
+int conn_writev(connection *conn, char **bufs, unsigned int *lens, int n)
+{
+    int i, size, total;
+
+    for (total = 0, i = 0; i < n; i++) {
+	size = conn_write(conn, bufs[i], lens[i]);
+	if (size < 0) {
+	    return (total == 0) ? -1 : total;
+	}
+	total += size;
+	if ((unsigned int) size != lens[i]) {
+	    break;
+	}
+    }
+    return total;
+}
+
 /*
  * NAME:	conn->udpwrite()
  * DESCRIPTION:	write a message to a UDP channel
  */
 int conn_udpwrite(connection *conn, char *buf, unsigned int len)
 {
+    int size;
+
     if (conn->fd != INVALID_SOCKET || conn->udp) {
 	if (conn->addr->ipnum.ipv6) {
 	    struct sockaddr_in6 to;
@@ -1628,7 +1667,7 @@ int conn_udpwrite(connection *conn, char *buf, unsigned int len)
 	    memcpy(&to.sin6_addr, &conn->addr->ipnum.in.addr6,
 		   sizeof(struct in6_addr));
 	    to.sin6_port = conn->port;
-	    return sendto(udescs[conn->at].fd.in6, buf, len, 0,
+	    size = sendto(udescs[conn->at].fd.in6, buf, len, 0,
 			  (struct sockaddr *) &to, sizeof(struct sockaddr_in6));
 	} else {
 	    struct sockaddr_in to;
@@ -1636,13 +1675,41 @@ int conn_udpwrite(connection *conn, char *buf, unsigned int len)
 	    to.sin_family = AF_INET;
 	    to.sin_addr.s_addr = conn->addr->ipnum.in.addr.s_addr;
 	    to.sin_port = conn->port;
-	    return sendto(udescs[conn->at].fd.in4, buf, len, 0,
+	    size = sendto(udescs[conn->at].fd.in4, buf, len, 0,
 			  (struct sockaddr *) &to, sizeof(struct sockaddr_in));
 	}
+	if (size < 0) {
+	    udescs[conn->at].failed++;
+	} else {
+	    udescs[conn->at].sent++;
+	}
+	return size;
     }
     return -1;
 }
 
+/*
+ * NAME:	conn->udpflush()
+ * DESCRIPTION:	send all queued UDP messages
+ */
+void conn_udpflush()
+{
+    /* UDP messages are sent immediately */
+}
+
+/*
+ * NAME:	conn->udpcount()
+ * DESCRIPTION:	return datagram statistics for a port
+ */
+void conn_udpcount(int port, Uint *received, Uint *sent, Uint *dropped,
+		   Uint *failed)
+{
+    *received = udescs[port].received;
+    *sent = udescs[port].sent;
+    *dropped = udescs[port].dropped;
+    *failed = udescs[port].failed;
+}
+
 /*
  * NAME:	conn->wrdone()
  * DESCRIPTION:	return TRUE if a connection is ready for output
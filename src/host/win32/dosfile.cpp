@@ -122,6 +122,49 @@ long P_lseek(int fd, long offset, int whence)
     return _lseek(fd, offset, whence);
 }
 
+/*
+ * NAME:	P->mmap()
+ * DESCRIPTION:	file mapping is not supported; the caller should fall back
+ *		to P_read()
+ */
+char *P_mmap(int fd, size_t size)
+{
+    UNREFERENCED_PARAMETER(fd);
+    UNREFERENCED_PARAMETER(size);
+    return (char *) NULL;
+}
+
+/*
+ * NAME:	P->munmap()
+ * DESCRIPTION:	unmap a file mapped with P_mmap()
+ */
+void P_munmap(char *addr, size_t size)
+{
+    UNREFERENCED_PARAMETER(addr);
+    UNREFERENCED_PARAMETER(size);
+}
+
+/*
+ * NAME:	P->prefetch()
+ * DESCRIPTION:	prefetching is not supported
+ */
+void P_prefetch(char *addr, size_t size)
+{
+    UNREFERENCED_PARAMETER(addr);
+    UNREFERENCED_PARAMETER(size);
+}
+
+/*
+ * NAME:	P->madvise()
+ * DESCRIPTION:	access hints are not supported
+ */
+void P_madvise(char *addr, size_t size, bool sequential)
+{
+    UNREFERENCED_PARAMETER(addr);
+    UNREFERENCED_PARAMETER(size);
+    UNREFERENCED_PARAMETER(sequential);
+}
+
 /*
  * NAME:	P->stat()
  * DESCRIPTION:	get information about a file
@@ -291,6 +334,15 @@ void P_closedir()
     }
 }
 
+/*
+ * NAME:	P->fsync()
+ * DESCRIPTION:	flush a file to disk
+ */
+int P_fsync(int fd)
+{
+    return _commit(fd);
+}
+
 /*
  * NAME:	P->execv()
  * DESCRIPTION:	execute a program
@@ -33,7 +33,21 @@
 # endif
 
 
+# define SSEGSIZE	4096		/* value stack segment size */
+
+struct stkseg {
+    stkseg *prev;		/* previous segment */
+    stkseg *next;		/* next segment */
+    Value *lo;			/* bottom of segment */
+    Value *hi;			/* top of segment */
+    Uint offset;		/* # values in previous segments */
+};
+
 static Value stack[MIN_STACK];	/* initial stack */
+static stkseg *sseg;		/* current value stack segment */
+static Value *ssp;		/* value stack pointer */
+static Uint maxdepth;		/* max call depth in this task */
+static Uint maxstack;		/* max value stack size in this task */
 static Frame topframe;		/* top frame */
 static rlinfo rlim;		/* top rlimits info */
 Frame *cframe;			/* current frame */
@@ -47,6 +61,65 @@ Value zero_int = { T_INT, TRUE };
 Value zero_float = { T_FLOAT, TRUE };
 Value nil_value = { T_NIL, TRUE };
 
+/*
+ * NAME:	interpret->new_segment()
+ * DESCRIPTION:	continue the value stack in a new segment with room for at
+ *		least size values
+ */
+static void i_new_segment(int size)
+{
+    stkseg *s, *next;
+
+    s = (sseg != (stkseg *) NULL) ? sseg->next : (stkseg *) NULL;
+    if (s != (stkseg *) NULL && s->hi - s->lo < size) {
+	/* too small: discard it and all segments after it */
+	sseg->next = (stkseg *) NULL;
+	do {
+	    next = s->next;
+	    FREE(s->lo);
+	    FREE(s);
+	} while ((s=next) != (stkseg *) NULL);
+    }
+    if (s == (stkseg *) NULL) {
+	if (size < SSEGSIZE) {
+	    size = SSEGSIZE;
+	}
+	m_static();
+	s = ALLOC(stkseg, 1);
+	s->lo = ALLOC(Value, size);
+	m_dynamic();
+	s->hi = s->lo + size;
+	s->prev = sseg;
+	s->next = (stkseg *) NULL;
+	if (sseg != (stkseg *) NULL) {
+	    sseg->next = s;
+	}
+    }
+    s->offset = (sseg != (stkseg *) NULL) ?
+		 sseg->offset + (sseg->hi - sseg->lo) : 0;
+    sseg = s;
+    ssp = s->hi;
+}
+
+/*
+ * NAME:	interpret->alloc_stack()
+ * DESCRIPTION:	allocate a local stack of size values on the value stack
+ */
+static Value *i_alloc_stack(int size)
+{
+    Uint n;
+
+    if (ssp - sseg->lo < size) {
+	i_new_segment(size);
+    }
+    ssp -= size;
+    n = sseg->offset + (sseg->hi - ssp);
+    if (n > maxstack) {
+	maxstack = n;
+    }
+    return ssp;
+}
+
 /*
  * NAME:	interpret->init()
  * DESCRIPTION:	initialize the interpreter
@@ -56,6 +129,11 @@ void i_init(char *create, bool flag)
     topframe.oindex = OBJ_NONE;
     topframe.fp = topframe.sp = stack + MIN_STACK;
     topframe.stack = stack;
+    sseg = (stkseg *) NULL;
+    i_new_segment(SSEGSIZE);
+    topframe.sseg = sseg;
+    topframe.ssp = ssp;
+    maxdepth = maxstack = 0;
     rlim.maxdepth = 0;
     rlim.ticks = 0;
     rlim.nodepth = TRUE;
@@ -159,33 +237,34 @@ void i_grow_stack(Frame *f, int size)
     if (f->sp < f->stack + size + MIN_STACK) {
 	int spsize;
 	Value *v, *stk;
-	intptr_t offset;
+	Uint n;
 
-	/*
-	 * extend the local stack
-	 */
 	spsize = f->fp - f->sp;
 	size = ALGN(spsize + size + MIN_STACK, 8);
-	stk = ALLOC(Value, size);
-	offset = (intptr_t) (stk + size) - (intptr_t) f->fp;
+	if (f->stack == ssp && ssp - sseg->lo >= size - (f->fp - f->stack)) {
+	    /*
+	     * the local stack is on top of the value stack: extend it in place
+	     */
+	    ssp = f->stack = f->fp - size;
+	    n = sseg->offset + (sseg->hi - ssp);
+	    if (n > maxstack) {
+		maxstack = n;
+	    }
+	    return;
+	}
 
-	/* move stack values */
+	/*
+	 * move the local stack to the top of the value stack; the old space
+	 * is reclaimed when the frame is left
+	 */
+	stk = i_alloc_stack(size);
 	v = stk + size;
 	if (spsize != 0) {
 	    memcpy(v - spsize, f->sp, spsize * sizeof(Value));
 	}
 	f->sp = v - spsize;
-
-	/* replace old stack */
-	if (f->sos) {
-	    /* stack on stack: alloca'd */
-	    AFREE(f->stack);
-	    f->sos = FALSE;
-	} else if (f->stack != stack) {
-	    FREE(f->stack);
-	}
 	f->stack = stk;
-	f->fp = stk + size;
+	f->fp = v;
     }
 }
 
@@ -637,7 +716,7 @@ int i_instanceof(Frame *f, unsigned int oindex, Uint sclass)
  */
 int i_instancestr(unsigned int oindex, char *prog)
 {
-    return instanceof(oindex, prog, Hashtab::hashstr(prog, OBJHASHSZ));
+    return instanceof(oindex, prog, Hashtab::hashfull(prog, strlen(prog)));
 }
 
 /*
@@ -694,8 +773,7 @@ static void i_store_local(Frame *f, int local, Value *val, Value *verify)
 
     i_add_ticks(f, 1);
     var = (local < 0) ? f->fp + local : f->argp + local;
-    if (verify == NULL ||
-	(var->type == T_STRING && var->u.string == verify->u.string)) {
+    if (verify == NULL || VAL_SAME(var, verify)) {
 	d_assign_var(f->data, var, val);
     }
 }
@@ -714,19 +792,30 @@ void i_store_global(Frame *f, int inherit, int index, Value *val, Value *verify)
     offset = f->ctrl->inherits[inherit].varoffset + index;
     if (f->lwobj == NULL) {
 	var = d_get_variable(f->data, offset);
-	if (verify == NULL ||
-	    (var->type == T_STRING && var->u.string == verify->u.string)) {
+	if (verify == NULL || VAL_SAME(var, verify)) {
 	    d_assign_var(f->data, var, val);
 	}
     } else {
 	var = &f->lwobj->elts[2 + offset];
-	if (verify == NULL ||
-	    (var->type == T_STRING && var->u.string == verify->u.string)) {
+	if (verify == NULL || VAL_SAME(var, verify)) {
 	    d_assign_elt(f->data, f->lwobj, var, val);
 	}
     }
 }
 
+/*
+ * NAME:	interpret->store_frozen()
+ * DESCRIPTION:	check an indexed assignment to a value that is not held in a
+ *		variable, which therefore cannot receive a thawed copy
+ */
+static void i_store_frozen(Value *aval)
+{
+    if ((aval->type == T_ARRAY || aval->type == T_MAPPING) &&
+	aval->u.array->frozen) {
+	error("Frozen value cannot be modified");
+    }
+}
+
 /*
  * NAME:	interpret->store_index()
  * DESCRIPTION:	perform an indexed assignment
@@ -757,9 +846,23 @@ bool i_store_index(Frame *f, Value *var, Value *aval, Value *ival, Value *val)
 	    error("Non-numeric array index");
 	}
 	arr = aval->u.array;
+	if (arr->frozen) {
+	    if (var->type != T_NIL) {
+		error("Frozen value cannot be modified");
+	    }
+
+	    /*
+	     * copy on write
+	     */
+	    i = arr_index(arr, ival->u.number);
+	    i_add_ticks(f, arr->size);
+	    arr = arr_thaw(f->data, arr);
+	    d_assign_elt(f->data, arr, &arr->elts[i], val);
+	    PUT_ARRVAL(var, arr);
+	    return TRUE;
+	}
 	aval = &d_get_elts(arr)[arr_index(arr, ival->u.number)];
-	if (var->type != T_STRING ||
-	    (aval->type == T_STRING && var->u.string == aval->u.string)) {
+	if (var->type == T_NIL || VAL_SAME(aval, var)) {
 	    d_assign_elt(f->data, arr, aval, val);
 	}
 	arr_del(arr);
@@ -767,7 +870,22 @@ bool i_store_index(Frame *f, Value *var, Value *aval, Value *ival, Value *val)
 
     case T_MAPPING:
 	arr = aval->u.array;
-	if (var->type != T_STRING) {
+	if (arr->frozen) {
+	    if (var->type != T_NIL) {
+		error("Frozen value cannot be modified");
+	    }
+
+	    /*
+	     * copy on write
+	     */
+	    i_add_ticks(f, arr->size);
+	    arr = arr_thaw(f->data, arr);
+	    map_index(f->data, arr, ival, val, (Value *) NULL);
+	    i_del_value(ival);
+	    PUT_MAPVAL(var, arr);
+	    return TRUE;
+	}
+	if (var->type == T_NIL) {
 	    var = NULL;
 	}
 	map_index(f->data, arr, ival, val, var);
@@ -912,11 +1030,12 @@ static void i_stores(Frame *f, int skip, int assign)
 
 	case I_STORE_INDEX:
 	case I_STORE_INDEX | I_POP_BIT:
+	    i_store_frozen(f->sp + 2);
 	    val = nil_value;
 	    if (i_store_index(f, &val, f->sp + 2, f->sp + 1,
 			      &f->sp->u.array->elts[assign - 1])) {
-		str_del(f->sp[2].u.string);
-		str_del(val.u.string);
+		i_del_value(&f->sp[2]);
+		i_del_value(&val);
 	    }
 	    f->sp[2] = f->sp[0];
 	    f->sp += 2;
@@ -929,8 +1048,8 @@ static void i_stores(Frame *f, int skip, int assign)
 	    if (i_store_index(f, &val, f->sp + 2, f->sp + 1,
 			      &f->sp->u.array->elts[assign - 1])) {
 		i_store_local(f, (short) u, &val, &f->sp[2]);
-		str_del(f->sp[2].u.string);
-		str_del(val.u.string);
+		i_del_value(&f->sp[2]);
+		i_del_value(&val);
 	    }
 	    f->sp[2] = f->sp[0];
 	    f->sp += 2;
@@ -943,8 +1062,8 @@ static void i_stores(Frame *f, int skip, int assign)
 	    if (i_store_index(f, &val, f->sp + 2, f->sp + 1,
 			      &f->sp->u.array->elts[assign - 1])) {
 		i_store_global(f, f->p_ctrl->ninherits - 1, u, &val, &f->sp[2]);
-		str_del(f->sp[2].u.string);
-		str_del(val.u.string);
+		i_del_value(&f->sp[2]);
+		i_del_value(&val);
 	    }
 	    f->sp[2] = f->sp[0];
 	    f->sp += 2;
@@ -958,8 +1077,8 @@ static void i_stores(Frame *f, int skip, int assign)
 	    if (i_store_index(f, &val, f->sp + 2, f->sp + 1,
 			      &f->sp->u.array->elts[assign - 1])) {
 		i_store_global(f, u, u2, &val, &f->sp[2]);
-		str_del(f->sp[2].u.string);
-		str_del(val.u.string);
+		i_del_value(&f->sp[2]);
+		i_del_value(&val);
 	    }
 	    f->sp[2] = f->sp[0];
 	    f->sp += 2;
@@ -972,8 +1091,8 @@ static void i_stores(Frame *f, int skip, int assign)
 			      &f->sp->u.array->elts[assign - 1])) {
 		f->sp[1] = val;
 		i_store_index(f, f->sp + 2, f->sp + 4, f->sp + 3, f->sp + 1);
-		str_del(f->sp[1].u.string);
-		str_del(f->sp[2].u.string);
+		i_del_value(&f->sp[1]);
+		i_del_value(&f->sp[2]);
 	    } else {
 		i_del_value(f->sp + 3);
 		i_del_value(f->sp + 4);
@@ -1226,12 +1345,9 @@ Frame *i_set_sp(Frame *ftop, Value *sp)
 	if (f->lwobj != (Array *) NULL) {
 	    arr_del(f->lwobj);
 	}
-	if (f->sos) {
-	    /* stack on stack */
-	    AFREE(f->stack);
-	} else if (f->oindex != OBJ_NONE) {
-	    FREE(f->stack);
-	}
+	/* release local stack */
+	sseg = f->sseg;
+	ssp = f->ssp;
     }
 }
 
@@ -1569,6 +1685,53 @@ static unsigned short i_switch_str(Frame *f, char *pc)
     return dflt;
 }
 
+/*
+ * NAME:	interpret->switch_strhash()
+ * DESCRIPTION:	handle a string switch with a hash table
+ */
+static unsigned short i_switch_strhash(Frame *f, char *pc)
+{
+    unsigned short h, l, u, u2, dflt, mask;
+    char *p, *tab;
+    String *str, *label;
+    Control *ctrl;
+
+    FETCH2U(pc, h);
+    FETCH2U(pc, dflt);
+    if (FETCH1U(pc) == 0) {
+	FETCH2U(pc, l);
+	if (VAL_NIL(f->sp)) {
+	    return l;
+	}
+	--h;
+    }
+    if (f->sp->type != T_STRING) {
+	return dflt;
+    }
+
+    /* the hash table follows the sorted table */
+    tab = pc + 5 * (h - 1);
+    mask = (1 << FETCH1U(tab)) - 1;
+    ctrl = f->p_ctrl;
+    str = f->sp->u.string;
+    h = Hashtab::hashmem(str->text, str->len);
+    for (;;) {
+	p = tab + 2 * (h & mask);
+	FETCH2U(p, l);
+	if (l == 0) {
+	    return dflt;
+	}
+	p = pc + 5 * (l - 1);
+	u = FETCH1U(p);
+	label = d_get_strconst(ctrl, u, FETCH2U(p, u2));
+	if (label->len == str->len &&
+	    memcmp(label->text, str->text, str->len) == 0) {
+	    return FETCH2U(p, l);
+	}
+	h++;
+    }
+}
+
 /*
  * NAME:	interpret->catcherr()
  * DESCRIPTION:	handle caught error
@@ -1749,10 +1912,11 @@ static void i_interpret1(Frame *f, char *pc)
 
 	case I_STORE_INDEX:
 	case I_STORE_INDEX | I_POP_BIT:
+	    i_store_frozen(f->sp + 2);
 	    val = nil_value;
 	    if (i_store_index(f, &val, f->sp + 2, f->sp + 1, f->sp)) {
-		str_del(f->sp[2].u.string);
-		str_del(val.u.string);
+		i_del_value(&f->sp[2]);
+		i_del_value(&val);
 	    }
 	    f->sp[2] = f->sp[0];
 	    f->sp += 2;
@@ -1764,8 +1928,8 @@ static void i_interpret1(Frame *f, char *pc)
 	    val = nil_value;
 	    if (i_store_index(f, &val, f->sp + 2, f->sp + 1, f->sp)) {
 		i_store_local(f, (short) u, &val, f->sp + 2);
-		str_del(f->sp[2].u.string);
-		str_del(val.u.string);
+		i_del_value(&f->sp[2]);
+		i_del_value(&val);
 	    }
 	    f->sp[2] = f->sp[0];
 	    f->sp += 2;
@@ -1777,8 +1941,8 @@ static void i_interpret1(Frame *f, char *pc)
 	    val = nil_value;
 	    if (i_store_index(f, &val, f->sp + 2, f->sp + 1, f->sp)) {
 		i_store_global(f, f->p_ctrl->ninherits - 1, u, &val, f->sp + 2);
-		str_del(f->sp[2].u.string);
-		str_del(val.u.string);
+		i_del_value(&f->sp[2]);
+		i_del_value(&val);
 	    }
 	    f->sp[2] = f->sp[0];
 	    f->sp += 2;
@@ -1791,8 +1955,8 @@ static void i_interpret1(Frame *f, char *pc)
 	    val = nil_value;
 	    if (i_store_index(f, &val, f->sp + 2, f->sp + 1, f->sp)) {
 		i_store_global(f, u, u2, &val, f->sp + 2);
-		str_del(f->sp[2].u.string);
-		str_del(val.u.string);
+		i_del_value(&f->sp[2]);
+		i_del_value(&val);
 	    }
 	    f->sp[2] = f->sp[0];
 	    f->sp += 2;
@@ -1804,8 +1968,8 @@ static void i_interpret1(Frame *f, char *pc)
 	    if (i_store_index(f, &val, f->sp + 2, f->sp + 1, f->sp)) {
 		f->sp[1] = val;
 		i_store_index(f, f->sp + 2, f->sp + 4, f->sp + 3, f->sp + 1);
-		str_del(f->sp[1].u.string);
-		str_del(f->sp[2].u.string);
+		i_del_value(&f->sp[1]);
+		i_del_value(&f->sp[2]);
 	    } else {
 		i_del_value(f->sp + 3);
 		i_del_value(f->sp + 4);
@@ -1848,6 +2012,10 @@ static void i_interpret1(Frame *f, char *pc)
 	    case SWITCH_STRING:
 		pc = f->prog + i_switch_str(f, pc);
 		break;
+
+	    case SWITCH_STRHASH:
+		pc = f->prog + i_switch_strhash(f, pc);
+		break;
 	    }
 	    i_del_value(f->sp++);
 	    continue;
@@ -2094,7 +2262,12 @@ void i_funcall(Frame *prev_f, Object *obj, Array *lwobj, int p_ctrli, int funci,
 	f.data = prev_f->data;
 	f.external = FALSE;
     }
+    f.sseg = sseg;
+    f.ssp = ssp;
     f.depth = prev_f->depth + 1;
+    if ((Uint) f.depth > maxdepth) {
+	maxdepth = f.depth;
+    }
     f.rlim = prev_f->rlim;
     if (f.depth >= f.rlim->maxdepth && !f.rlim->nodepth) {
 	error("Stack overflow");
@@ -2238,9 +2411,8 @@ void i_funcall(Frame *prev_f, Object *obj, Array *lwobj, int p_ctrli, int funci,
     /* create new local stack */
     f.argp = f.sp;
     FETCH2U(pc, n);
-    f.stack = ALLOCA(Value, n + MIN_STACK + EXTRA_STACK);
+    f.stack = i_alloc_stack(n + MIN_STACK + EXTRA_STACK);
     f.fp = f.sp = f.stack + n + MIN_STACK + EXTRA_STACK;
-    f.sos = TRUE;
 
     /* initialize local variables */
     n = FETCH1U(pc);
@@ -2266,13 +2438,8 @@ void i_funcall(Frame *prev_f, Object *obj, Array *lwobj, int p_ctrli, int funci,
     }
 # endif
     i_pop(&f, f.fp - f.sp);
-    if (f.sos) {
-	    /* still alloca'd */
-	AFREE(f.stack);
-    } else {
-	/* extended and malloced */
-	FREE(f.stack);
-    }
+    sseg = f.sseg;
+    ssp = f.ssp;
 
     if (f.lwobj != (Array *) NULL) {
 	arr_del(f.lwobj);
@@ -2546,6 +2713,18 @@ static unsigned short i_line1(Frame *f)
 		}
 		pc += (u - 1) * 5;
 		break;
+
+	    case 3:
+		FETCH2U(pc, u);
+		pc += 2;
+		if (FETCH1U(pc) == 0) {
+		    pc += 2;
+		    --u;
+		}
+		pc += (u - 1) * 5;
+		sz = FETCH1U(pc);
+		pc += 2 << sz;
+		break;
 	    }
 	    break;
 	}
@@ -2771,18 +2950,33 @@ Frame *i_restore(Frame *ftop, Int level)
 
 /*
  * NAME:	interpret->clear()
- * DESCRIPTION:	clean up the interpreter state
+ * DESCRIPTION:	clean up the interpreter state, and return the number of
+ *		ticks used by the task, as well as the maximum call depth and
+ *		value stack size reached
  */
-void i_clear()
+Uint i_clear(Uint *depth, Uint *size)
 {
     Frame *f;
+    Uint ticks;
 
     f = cframe;
     if (f->stack != stack) {
-	FREE(f->stack);
 	f->fp = f->sp = stack + MIN_STACK;
 	f->stack = stack;
     }
+    sseg = f->sseg;
+    ssp = f->ssp;
+    *depth = maxdepth;
+    *size = maxstack;
+    maxdepth = maxstack = 0;
 
     f->rlim = &rlim;
+
+    /*
+     * The top-level rlimits are unlimited and count down from 0x7fffffff.
+     * Ticks given to nested rlimits are subtracted from them as well.
+     */
+    ticks = (rlim.ticks > 0) ? 0x7fffffff - rlim.ticks : 0;
+    rlim.ticks = 0x7fffffff;
+    return ticks;
 }
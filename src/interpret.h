@@ -122,6 +122,10 @@
 # define VAL_NIL(v)	((v)->type == nil_type && (v)->u.number == 0)
 # define VAL_TRUE(v)	((v)->u.number != 0 || (v)->type > T_FLOAT ||	\
 			 ((v)->type == T_FLOAT && (v)->oindex != 0))
+# define VAL_SAME(v1, v2) ((v1)->type == (v2)->type &&			\
+			 (((v1)->type == T_STRING) ?			\
+			   (v1)->u.string == (v2)->u.string :		\
+			   (v1)->u.array == (v2)->u.array))
 
 # define PUSH_INTVAL(f, i)	((--(f)->sp)->u.number = (i),		\
 				 (f)->sp->type = T_INT)
@@ -193,6 +197,7 @@
 # define SWITCH_INT	0
 # define SWITCH_RANGE	1
 # define SWITCH_STRING	2
+# define SWITCH_STRHASH	3
 
 
 struct rlinfo {
@@ -213,7 +218,6 @@ struct Frame {
     unsigned short p_index;	/* program index */
     unsigned short nargs;	/* # arguments */
     bool external;		/* TRUE if it's an external call */
-    bool sos;			/* stack on stack */
     uindex foffset;		/* program function offset */
     struct dfuncdef *func;	/* current function */
     char *prog;			/* start of program */
@@ -222,6 +226,8 @@ struct Frame {
     Value *sp;			/* stack pointer */
     Value *argp;		/* argument pointer (previous sp) */
     Value *fp;			/* frame pointer (at end of local stack) */
+    struct stkseg *sseg;	/* value stack segment below this frame */
+    Value *ssp;			/* value stack pointer below this frame */
     Int depth;			/* stack depth */
     rlinfo *rlim;		/* rlimits info */
     Int level;			/* plane level */
@@ -269,7 +275,7 @@ extern bool	i_call_critical	(Frame*, const char*, int, int);
 extern void	i_runtime_error	(Frame*, Int);
 extern void	i_atomic_error	(Frame*, Int);
 extern Frame   *i_restore	(Frame*, Int);
-extern void	i_clear		();
+extern Uint	i_clear		(Uint*, Uint*);
 
 extern Frame *cframe;
 extern int nil_type;
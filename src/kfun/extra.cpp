@@ -167,7 +167,7 @@ int kf_explode(Frame *f, int n, kfunc *kf)
 	 */
 	a = arr_new(f->data, (long) len);
 	for (v = a->elts; len > 0; v++, --len) {
-	    PUT_STRVAL(v, str_new(p, 1L));
+	    PUT_STRVAL(v, str_pool(p, 1L));
 	    p++;
 	}
     } else {
@@ -207,7 +207,7 @@ int kf_explode(Frame *f, int n, kfunc *kf)
 	while (len > slen) {
 	    if (memcmp(p, s, slen) == 0) {
 		/* separator found */
-		PUT_STRVAL(v, str_new(p - size, (long) size));
+		PUT_STRVAL(v, str_pool(p - size, (long) size));
 		v++;
 		p += slen;
 		len -= slen;
@@ -225,7 +225,7 @@ int kf_explode(Frame *f, int n, kfunc *kf)
 	    p += len;
 	}
 	/* final array element */
-	PUT_STRVAL(v, str_new(p - size, (long) size));
+	PUT_STRVAL(v, str_pool(p - size, (long) size));
     }
 
     str_del((f->sp++)->u.string);
@@ -975,34 +975,11 @@ void kf_xcrypt(Frame *f, int nargs, Value *val)
 # define R4(a, b, c, d, Mj, s, ti)	(a += (c ^ (b | ~d)) + Mj + ti,	     \
 					 a = b + ROTL(a, s))
 
-/*
- * NAME:	hash->md5_start()
- * DESCRIPTION:	MD5 message digest.  See "Applied Cryptography" by Bruce
- *		Schneier, Second Edition, p. 436-441.
- */
-static Int hash_md5_start(Frame *f, int nargs, Uint *digest)
-{
-    Int cost;
-
-    /*
-     * These constants must apparently be little-endianized, though AC2 does
-     * not explicitly say so.
-     */
-    digest[0] = 0x67452301L;
-    digest[1] = 0xefcdab89L;
-    digest[2] = 0x98badcfeL;
-    digest[3] = 0x10325476L;
-
-    cost = 3 * nargs + 64;
-    while (--nargs >= 0) {
-	cost += f->sp[nargs].u.string->len;
-    }
-    return cost;
-}
-
 /*
  * NAME:	hash->md5_block()
- * DESCRIPTION:	add another 512 bit block to the message digest
+ * DESCRIPTION:	add another 512 bit block to the message digest.  See
+ *		"Applied Cryptography" by Bruce Schneier, Second Edition,
+ *		p. 436-441.
  */
 static void hash_md5_block(Uint *ABCD, char *block)
 {
@@ -1095,62 +1072,10 @@ static void hash_md5_block(Uint *ABCD, char *block)
     ABCD[3] += d;
 }
 
-/*
- * NAME:	hash->md5_end()
- * DESCRIPTION:	finish up MD5 hash
- */
-static String *hash_md5_end(Uint *digest, char *buffer, unsigned int bufsz, Uint length)
-{
-    int i;
-
-    /* append padding and digest final block(s) */
-    buffer[bufsz++] = 0x80;
-    if (bufsz > 56) {
-	memset(buffer + bufsz, '\0', 64 - bufsz);
-	hash_md5_block(digest, buffer);
-	bufsz = 0;
-    }
-    memset(buffer + bufsz, '\0', 64 - bufsz);
-    buffer[56] = length << 3;
-    buffer[57] = length >> 5;
-    buffer[58] = length >> 13;
-    buffer[59] = length >> 21;
-    buffer[60] = length >> 29;
-    hash_md5_block(digest, buffer);
-
-    for (bufsz = i = 0; i < 4; bufsz += 4, i++) {
-	buffer[bufsz + 0] = digest[i];
-	buffer[bufsz + 1] = digest[i] >> 8;
-	buffer[bufsz + 2] = digest[i] >> 16;
-	buffer[bufsz + 3] = digest[i] >> 24;
-    }
-    return str_new(buffer, 16L);
-}
-
-/*
- * NAME:	hash->sha1_start()
- * DESCRIPTION:	SHA-1 message digest.  See FIPS 180-2.
- */
-static Int hash_sha1_start(Frame *f, int nargs, Uint *digest)
-{
-    Int cost;
-
-    digest[0] = 0x67452301L;
-    digest[1] = 0xefcdab89L;
-    digest[2] = 0x98badcfeL;
-    digest[3] = 0x10325476L;
-    digest[4] = 0xc3d2e1f0L;
-
-    cost = 3 * nargs + 64;
-    while (--nargs >= 0) {
-	cost += f->sp[nargs].u.string->len;
-    }
-    return cost;
-}
-
 /*
  * NAME:	hash->sha1_block()
- * DESCRIPTION:	add another 512 bit block to the message digest
+ * DESCRIPTION:	add another 512 bit block to the message digest.  See
+ *		FIPS 180-2.
  */
 static void hash_sha1_block(Uint *ABCDE, char *block)
 {
@@ -1217,54 +1142,388 @@ static void hash_sha1_block(Uint *ABCDE, char *block)
     ABCDE[4] += e;
 }
 
+# define ROTR(x, s)		(((x) >> s) | ((x) << (32 - s)))
+# define ROTR64(x, s)		(((x) >> s) | ((x) << (64 - s)))
+# define CH(x, y, z)		((((y) ^ (z)) & (x)) ^ (z))
+# define MAJ(x, y, z)		(((x) & (y)) | (((x) | (y)) & (z)))
+# define S256(a, b, c, d, e, f, g, h, Wi, Ki) \
+	(t = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + CH(e, f, g) + \
+	     Ki + Wi,							 \
+	 d += t,							 \
+	 h = t + (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + MAJ(a, b, c))
+# define S512(a, b, c, d, e, f, g, h, Wi, Ki) \
+	(t = h + (ROTR64(e, 14) ^ ROTR64(e, 18) ^ ROTR64(e, 41)) +	 \
+	     CH(e, f, g) + Ki + Wi,					 \
+	 d += t,							 \
+	 h = t + (ROTR64(a, 28) ^ ROTR64(a, 34) ^ ROTR64(a, 39)) +	 \
+	     MAJ(a, b, c))
 
 /*
- * NAME:	hash->sha1_end()
- * DESCRIPTION:	finish up SHA-1 hash
+ * NAME:	hash->sha256_block()
+ * DESCRIPTION:	add another 512 bit block to the message digest.  See
+ *		FIPS 180-4.
  */
-static String *hash_sha1_end(Uint *digest, char *buffer, unsigned int bufsz, Uint length)
+static void hash_sha256_block(Uint *H, char *block)
 {
+    static const Uint K[64] = {
+	0x428a2f98L, 0x71374491L, 0xb5c0fbcfL, 0xe9b5dba5L, 0x3956c25bL,
+	0x59f111f1L, 0x923f82a4L, 0xab1c5ed5L, 0xd807aa98L, 0x12835b01L,
+	0x243185beL, 0x550c7dc3L, 0x72be5d74L, 0x80deb1feL, 0x9bdc06a7L,
+	0xc19bf174L, 0xe49b69c1L, 0xefbe4786L, 0x0fc19dc6L, 0x240ca1ccL,
+	0x2de92c6fL, 0x4a7484aaL, 0x5cb0a9dcL, 0x76f988daL, 0x983e5152L,
+	0xa831c66dL, 0xb00327c8L, 0xbf597fc7L, 0xc6e00bf3L, 0xd5a79147L,
+	0x06ca6351L, 0x14292967L, 0x27b70a85L, 0x2e1b2138L, 0x4d2c6dfcL,
+	0x53380d13L, 0x650a7354L, 0x766a0abbL, 0x81c2c92eL, 0x92722c85L,
+	0xa2bfe8a1L, 0xa81a664bL, 0xc24b8b70L, 0xc76c51a3L, 0xd192e819L,
+	0xd6990624L, 0xf40e3585L, 0x106aa070L, 0x19a4c116L, 0x1e376c08L,
+	0x2748774cL, 0x34b0bcb5L, 0x391c0cb3L, 0x4ed8aa4aL, 0x5b9cca4fL,
+	0x682e6ff3L, 0x748f82eeL, 0x78a5636fL, 0x84c87814L, 0x8cc70208L,
+	0x90befffaL, 0xa4506cebL, 0xbef9a3f7L, 0xc67178f2L
+    };
+    Uint W[64];
+    int i, j;
+    Uint a, b, c, d, e, f, g, h, t;
+
+    for (i = j = 0; i < 16; i++, j += 4) {
+	W[i] = (UCHAR(block[j + 0]) << 24) | (UCHAR(block[j + 1]) << 16) |
+	       (UCHAR(block[j + 2]) << 8) | UCHAR(block[j + 3]);
+    }
+    while (i < 64) {
+	a = W[i - 15];
+	b = W[i - 2];
+	W[i] = W[i - 16] + (ROTR(a, 7) ^ ROTR(a, 18) ^ (a >> 3)) + W[i - 7] +
+	       (ROTR(b, 17) ^ ROTR(b, 19) ^ (b >> 10));
+	i++;
+    }
+
+    a = H[0];
+    b = H[1];
+    c = H[2];
+    d = H[3];
+    e = H[4];
+    f = H[5];
+    g = H[6];
+    h = H[7];
+
+    /* eight rounds per iteration, rotating the variables by name */
+    for (i = 0; i < 64; i += 8) {
+	S256(a, b, c, d, e, f, g, h, W[i + 0], K[i + 0]);
+	S256(h, a, b, c, d, e, f, g, W[i + 1], K[i + 1]);
+	S256(g, h, a, b, c, d, e, f, W[i + 2], K[i + 2]);
+	S256(f, g, h, a, b, c, d, e, W[i + 3], K[i + 3]);
+	S256(e, f, g, h, a, b, c, d, W[i + 4], K[i + 4]);
+	S256(d, e, f, g, h, a, b, c, W[i + 5], K[i + 5]);
+	S256(c, d, e, f, g, h, a, b, W[i + 6], K[i + 6]);
+	S256(b, c, d, e, f, g, h, a, W[i + 7], K[i + 7]);
+    }
+
+    H[0] += a;
+    H[1] += b;
+    H[2] += c;
+    H[3] += d;
+    H[4] += e;
+    H[5] += f;
+    H[6] += g;
+    H[7] += h;
+}
+
+/*
+ * NAME:	hash->sha512_block()
+ * DESCRIPTION:	add another 1024 bit block to the message digest.  The
+ *		64 bit state words are kept as pairs of Uints, most
+ *		significant half first.
+ */
+static void hash_sha512_block(Uint *H, char *block)
+{
+    static const Uuint K[80] = {
+	0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL,
+	0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+	0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL,
+	0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+	0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+	0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+	0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL, 0x2de92c6f592b0275ULL,
+	0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+	0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL,
+	0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+	0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL,
+	0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+	0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL,
+	0x92722c851482353bULL, 0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+	0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+	0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+	0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL,
+	0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+	0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL,
+	0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL,
+	0xc67178f2e372532bULL, 0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+	0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL,
+	0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+	0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+	0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+	0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+    };
+    Uuint W[80];
+    int i, j;
+    Uuint a, b, c, d, e, f, g, h, t;
+
+    for (i = j = 0; i < 16; i++, j += 8) {
+	W[i] = ((Uuint) ((UCHAR(block[j + 0]) << 24) |
+			 (UCHAR(block[j + 1]) << 16) |
+			 (UCHAR(block[j + 2]) << 8) |
+			 UCHAR(block[j + 3])) << 32) |
+	       (Uint) ((UCHAR(block[j + 4]) << 24) |
+		       (UCHAR(block[j + 5]) << 16) |
+		       (UCHAR(block[j + 6]) << 8) | UCHAR(block[j + 7]));
+    }
+    while (i < 80) {
+	a = W[i - 15];
+	b = W[i - 2];
+	W[i] = W[i - 16] + (ROTR64(a, 1) ^ ROTR64(a, 8) ^ (a >> 7)) +
+	       W[i - 7] + (ROTR64(b, 19) ^ ROTR64(b, 61) ^ (b >> 6));
+	i++;
+    }
+
+    a = ((Uuint) H[ 0] << 32) | H[ 1];
+    b = ((Uuint) H[ 2] << 32) | H[ 3];
+    c = ((Uuint) H[ 4] << 32) | H[ 5];
+    d = ((Uuint) H[ 6] << 32) | H[ 7];
+    e = ((Uuint) H[ 8] << 32) | H[ 9];
+    f = ((Uuint) H[10] << 32) | H[11];
+    g = ((Uuint) H[12] << 32) | H[13];
+    h = ((Uuint) H[14] << 32) | H[15];
+
+    for (i = 0; i < 80; i += 8) {
+	S512(a, b, c, d, e, f, g, h, W[i + 0], K[i + 0]);
+	S512(h, a, b, c, d, e, f, g, W[i + 1], K[i + 1]);
+	S512(g, h, a, b, c, d, e, f, W[i + 2], K[i + 2]);
+	S512(f, g, h, a, b, c, d, e, W[i + 3], K[i + 3]);
+	S512(e, f, g, h, a, b, c, d, W[i + 4], K[i + 4]);
+	S512(d, e, f, g, h, a, b, c, W[i + 5], K[i + 5]);
+	S512(c, d, e, f, g, h, a, b, W[i + 6], K[i + 6]);
+	S512(b, c, d, e, f, g, h, a, W[i + 7], K[i + 7]);
+    }
+
+    a += ((Uuint) H[ 0] << 32) | H[ 1];
+    b += ((Uuint) H[ 2] << 32) | H[ 3];
+    c += ((Uuint) H[ 4] << 32) | H[ 5];
+    d += ((Uuint) H[ 6] << 32) | H[ 7];
+    e += ((Uuint) H[ 8] << 32) | H[ 9];
+    f += ((Uuint) H[10] << 32) | H[11];
+    g += ((Uuint) H[12] << 32) | H[13];
+    h += ((Uuint) H[14] << 32) | H[15];
+    H[ 0] = a >> 32;
+    H[ 1] = a;
+    H[ 2] = b >> 32;
+    H[ 3] = b;
+    H[ 4] = c >> 32;
+    H[ 5] = c;
+    H[ 6] = d >> 32;
+    H[ 7] = d;
+    H[ 8] = e >> 32;
+    H[ 9] = e;
+    H[10] = f >> 32;
+    H[11] = f;
+    H[12] = g >> 32;
+    H[13] = g;
+    H[14] = h >> 32;
+    H[15] = h;
+}
+
+/*
+ * hash algorithms with a Merkle-Damgard construction
+ */
+struct hashalg {
+    char tag;			/* identifies the algorithm in a saved state */
+    bool little;		/* little-endian words and length */
+    unsigned short blocksz;	/* block size */
+    unsigned short lensz;	/* size of the length field in the last block */
+    unsigned short words;	/* # 32 bit words in the digest */
+    const Uint *init;		/* initial digest */
+    void (*block) (Uint*, char*);	/* block function */
+};
+
+static const Uint md5_init[] = {
+    /*
+     * These constants must apparently be little-endianized, though AC2 does
+     * not explicitly say so.
+     */
+    0x67452301L, 0xefcdab89L, 0x98badcfeL, 0x10325476L
+};
+static const Uint sha1_init[] = {
+    0x67452301L, 0xefcdab89L, 0x98badcfeL, 0x10325476L, 0xc3d2e1f0L
+};
+static const Uint sha256_init[] = {
+    0x6a09e667L, 0xbb67ae85L, 0x3c6ef372L, 0xa54ff53aL, 0x510e527fL,
+    0x9b05688cL, 0x1f83d9abL, 0x5be0cd19L
+};
+static const Uint sha512_init[] = {
+    0x6a09e667L, 0xf3bcc908L, 0xbb67ae85L, 0x84caa73bL, 0x3c6ef372L,
+    0xfe94f82bL, 0xa54ff53aL, 0x5f1d36f1L, 0x510e527fL, 0xade682d1L,
+    0x9b05688cL, 0x2b3e6c1fL, 0x1f83d9abL, 0xfb41bd6bL, 0x5be0cd19L,
+    0x137e2179L
+};
+
+static const hashalg md5 =	{ 'M', TRUE,   64,  8,  4, md5_init,
+				  &hash_md5_block };
+static const hashalg sha1 =	{ '1', FALSE,  64,  8,  5, sha1_init,
+				  &hash_sha1_block };
+static const hashalg sha256 =	{ '2', FALSE,  64,  8,  8, sha256_init,
+				  &hash_sha256_block };
+static const hashalg sha512 =	{ '5', FALSE, 128, 16, 16, sha512_init,
+				  &hash_sha512_block };
+
+# define HASH_STATE	(1 + 64 + 8)	/* max saved state, excluding buffer */
+
+/*
+ * NAME:	hash->ticks()
+ * DESCRIPTION:	charge ticks for hashing the arguments
+ */
+static void hash_ticks(Frame *f, int nargs)
+{
+    Int cost;
+
+    cost = 3 * nargs + 64;
+    while (--nargs >= 0) {
+	cost += f->sp[nargs].u.string->len;
+    }
+    if (!f->rlim->noticks && f->rlim->ticks <= cost) {
+	f->rlim->ticks = 0;
+	error("Out of ticks");
+    }
+    i_add_ticks(f, cost);
+}
+
+/*
+ * NAME:	hash->restore()
+ * DESCRIPTION:	continue from a saved hash state, or start a new hash if
+ *		the state is empty
+ */
+static void hash_restore(const hashalg *h, String *state, Uint *digest,
+			 char *buffer, unsigned short *bufsize, Uuint *length)
+{
+    char *p;
     int i;
+    Uuint len;
+
+    if (state == (String *) NULL || state->len == 0) {
+	memcpy(digest, h->init, h->words * sizeof(Uint));
+	*bufsize = 0;
+	*length = 0;
+	return;
+    }
+
+    p = state->text;
+    if (state->len < 1 + h->words * 4 + 8 || *p++ != h->tag) {
+	error("Bad hash state");
+    }
+    for (i = 0; i < h->words; i++, p += 4) {
+	digest[i] = (UCHAR(p[0]) << 24) | (UCHAR(p[1]) << 16) |
+		    (UCHAR(p[2]) << 8) | UCHAR(p[3]);
+    }
+    for (len = i = 0; i < 8; i++) {
+	len = (len << 8) | UCHAR(*p++);
+    }
+    i = state->len - (p - state->text);
+    if ((Uint) i != (Uint) (len & (h->blocksz - 1))) {
+	error("Bad hash state");
+    }
+    memcpy(buffer, p, i);
+    *bufsize = i;
+    *length = len;
+}
+
+/*
+ * NAME:	hash->save()
+ * DESCRIPTION:	save a hash state in a string
+ */
+static String *hash_save(const hashalg *h, Uint *digest, char *buffer,
+			 unsigned short bufsz, Uuint length)
+{
+    char state[HASH_STATE + 128];
+    char *p;
+    int i;
+
+    p = state;
+    *p++ = h->tag;
+    for (i = 0; i < h->words; i++) {
+	*p++ = digest[i] >> 24;
+	*p++ = digest[i] >> 16;
+	*p++ = digest[i] >> 8;
+	*p++ = digest[i];
+    }
+    for (i = 56; i >= 0; i -= 8) {
+	*p++ = length >> i;
+    }
+    memcpy(p, buffer, bufsz);
+
+    return str_new(state, p + bufsz - state);
+}
+
+/*
+ * NAME:	hash->end()
+ * DESCRIPTION:	finish up a hash
+ */
+static String *hash_end(const hashalg *h, Uint *digest, char *buffer,
+			unsigned int bufsz, Uuint length)
+{
+    unsigned int i;
 
     /* append padding and digest final block(s) */
     buffer[bufsz++] = 0x80;
-    if (bufsz > 56) {
-	memset(buffer + bufsz, '\0', 64 - bufsz);
-	hash_sha1_block(digest, buffer);
+    if (bufsz > (unsigned int) (h->blocksz - h->lensz)) {
+	memset(buffer + bufsz, '\0', h->blocksz - bufsz);
+	(*h->block)(digest, buffer);
 	bufsz = 0;
     }
-    memset(buffer + bufsz, '\0', 64 - bufsz);
-    buffer[59] = length >> 29;
-    buffer[60] = length >> 21;
-    buffer[61] = length >> 13;
-    buffer[62] = length >> 5;
-    buffer[63] = length << 3;
-    hash_sha1_block(digest, buffer);
-
-    for (bufsz = i = 0; i < 5; bufsz += 4, i++) {
-	buffer[bufsz + 0] = digest[i] >> 24;
-	buffer[bufsz + 1] = digest[i] >> 16;
-	buffer[bufsz + 2] = digest[i] >> 8;
-	buffer[bufsz + 3] = digest[i];
+    memset(buffer + bufsz, '\0', h->blocksz - bufsz);
+    if (h->little) {
+	for (i = 0; i < 8; i++) {
+	    buffer[h->blocksz - 8 + i] = (length << 3) >> (i << 3);
+	}
+    } else {
+	for (i = 0; i < 8; i++) {
+	    buffer[h->blocksz - 1 - i] = (length << 3) >> (i << 3);
+	}
+	if (h->lensz > 8) {
+	    buffer[h->blocksz - 1 - i] = length >> 61;
+	}
+    }
+    (*h->block)(digest, buffer);
+
+    for (bufsz = i = 0; i < h->words; bufsz += 4, i++) {
+	if (h->little) {
+	    buffer[bufsz + 0] = digest[i];
+	    buffer[bufsz + 1] = digest[i] >> 8;
+	    buffer[bufsz + 2] = digest[i] >> 16;
+	    buffer[bufsz + 3] = digest[i] >> 24;
+	} else {
+	    buffer[bufsz + 0] = digest[i] >> 24;
+	    buffer[bufsz + 1] = digest[i] >> 16;
+	    buffer[bufsz + 2] = digest[i] >> 8;
+	    buffer[bufsz + 3] = digest[i];
+	}
     }
-    return str_new(buffer, 20L);
+    return str_new(buffer, bufsz);
 }
 
 /*
  * NAME:	hash->blocks()
- * DESCRIPTION:	hash string blocks with a given function
+ * DESCRIPTION:	hash string blocks with a given function, return the number
+ *		of bytes added
  */
-static Uint hash_blocks(Frame *f, int nargs, Uint *digest, char *buffer,
+static Uuint hash_blocks(Frame *f, int nargs, Uint *digest, char *buffer,
 	unsigned short *bufsize, unsigned int blocksz,
 	void (*hash_block) (Uint*, char*))
 {
     ssizet len;
     unsigned short bufsz;
     char *p;
-    Uint length;
+    Uuint length;
 
     length = 0;
-    bufsz = 0;
+    bufsz = *bufsize;
     while (--nargs >= 0) {
 	len = f->sp[nargs].u.string->len;
 	if (len != 0) {
@@ -1307,55 +1566,151 @@ static Uint hash_blocks(Frame *f, int nargs, Uint *digest, char *buffer,
     return length;
 }
 
+# define HASH_DIGEST	0	/* hash strings */
+# define HASH_UPDATE	1	/* continue from state, return new state */
+# define HASH_FINAL	2	/* continue from state, return digest */
+
 /*
- * NAME:	kfun->md5()
- * DESCRIPTION:	compute MD5 hash
+ * NAME:	hash->strings()
+ * DESCRIPTION:	hash the string arguments.  In update and final mode, the
+ *		first argument is a state previously returned by update,
+ *		or an empty string to start a new hash.
  */
-void kf_md5(Frame *f, int nargs, Value *val)
+static void hash_strings(Frame *f, int nargs, Value *val, const hashalg *h,
+			 int mode)
 {
-    char buffer[64];
-    Uint digest[5];
-    Int cost;
-    Uint length;
+    char buffer[128];
+    Uint digest[16];
+    Uuint length;
     unsigned short bufsz;
-    String *str;
+    String *state, *str;
 
-    cost = hash_md5_start(f, nargs, digest);
-    if (!f->rlim->noticks && f->rlim->ticks <= cost) {
-	f->rlim->ticks = 0;
-	error("Out of ticks");
+    hash_ticks(f, nargs);
+    if (mode == HASH_DIGEST) {
+	state = (String *) NULL;
+    } else if (nargs == 0) {
+	error("Too few arguments for kfun hash_string");
+    } else {
+	state = f->sp[--nargs].u.string;
     }
-    i_add_ticks(f, cost);
+    hash_restore(h, state, digest, buffer, &bufsz, &length);
 
-    length = hash_blocks(f, nargs, digest, buffer, &bufsz, 64, &hash_md5_block);
-    str = hash_md5_end(digest, buffer, bufsz, length);
+    length += hash_blocks(f, nargs, digest, buffer, &bufsz, h->blocksz,
+			  h->block);
+    if (mode == HASH_UPDATE) {
+	str = hash_save(h, digest, buffer, bufsz, length);
+    } else {
+	str = hash_end(h, digest, buffer, bufsz, length);
+    }
     PUT_STRVAL_NOREF(val, str);
 }
 
+/*
+ * NAME:	kfun->md5()
+ * DESCRIPTION:	compute MD5 hash
+ */
+void kf_md5(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &md5, HASH_DIGEST);
+}
+
+/*
+ * NAME:	kfun->md5_update()
+ * DESCRIPTION:	continue MD5 hash
+ */
+void kf_md5_update(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &md5, HASH_UPDATE);
+}
+
+/*
+ * NAME:	kfun->md5_final()
+ * DESCRIPTION:	finish MD5 hash
+ */
+void kf_md5_final(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &md5, HASH_FINAL);
+}
+
 /*
  * NAME:	kfun->sha1()
  * DESCRIPTION:	compute SHA1 hash
  */
 void kf_sha1(Frame *f, int nargs, Value *val)
 {
-    char buffer[64];
-    Uint digest[5];
-    Int cost;
-    Uint length;
-    unsigned short bufsz;
-    String *str;
+    hash_strings(f, nargs, val, &sha1, HASH_DIGEST);
+}
 
-    cost = hash_sha1_start(f, nargs, digest);
-    if (!f->rlim->noticks && f->rlim->ticks <= cost) {
-	f->rlim->ticks = 0;
-	error("Out of ticks");
-    }
-    i_add_ticks(f, cost);
+/*
+ * NAME:	kfun->sha1_update()
+ * DESCRIPTION:	continue SHA1 hash
+ */
+void kf_sha1_update(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &sha1, HASH_UPDATE);
+}
 
-    length = hash_blocks(f, nargs, digest, buffer, &bufsz, 64,
-			 &hash_sha1_block);
-    str = hash_sha1_end(digest, buffer, bufsz, length);
-    PUT_STRVAL_NOREF(val, str);
+/*
+ * NAME:	kfun->sha1_final()
+ * DESCRIPTION:	finish SHA1 hash
+ */
+void kf_sha1_final(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &sha1, HASH_FINAL);
+}
+
+/*
+ * NAME:	kfun->sha256()
+ * DESCRIPTION:	compute SHA256 hash
+ */
+void kf_sha256(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &sha256, HASH_DIGEST);
+}
+
+/*
+ * NAME:	kfun->sha256_update()
+ * DESCRIPTION:	continue SHA256 hash
+ */
+void kf_sha256_update(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &sha256, HASH_UPDATE);
+}
+
+/*
+ * NAME:	kfun->sha256_final()
+ * DESCRIPTION:	finish SHA256 hash
+ */
+void kf_sha256_final(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &sha256, HASH_FINAL);
+}
+
+/*
+ * NAME:	kfun->sha512()
+ * DESCRIPTION:	compute SHA512 hash
+ */
+void kf_sha512(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &sha512, HASH_DIGEST);
+}
+
+/*
+ * NAME:	kfun->sha512_update()
+ * DESCRIPTION:	continue SHA512 hash
+ */
+void kf_sha512_update(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &sha512, HASH_UPDATE);
+}
+
+/*
+ * NAME:	kfun->sha512_final()
+ * DESCRIPTION:	finish SHA512 hash
+ */
+void kf_sha512_final(Frame *f, int nargs, Value *val)
+{
+    hash_strings(f, nargs, val, &sha512, HASH_FINAL);
 }
 # endif
 
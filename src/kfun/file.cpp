@@ -111,6 +111,23 @@ int kf_query_editor(Frame *f, int n, kfunc *kf)
 # ifdef FUNCDEF
 FUNCDEF("save_object", kf_save_object, pt_save_object, 0)
 # else
+/*
+ * Save files with a name ending in BSAVE_EXT are written in a compact binary
+ * format, which restore_object() recognizes by the BSAVE_MAGIC header.
+ */
+# define BSAVE_EXT	".bin"
+# define BSAVE_MAGIC	"\0DGB\1"
+# define BSAVE_MAGICSZ	5
+
+# define B_NIL		0	/* nil */
+# define B_INT		1	/* zigzag-encoded variable-length integer */
+# define B_FLOAT	2	/* 6-byte float */
+# define B_STRING	3	/* length + characters */
+# define B_ARRAY	4	/* size + elements */
+# define B_MAPPING	5	/* # pairs + index/value pairs */
+# define B_AREF		6	/* reference to earlier array */
+# define B_MREF		7	/* reference to earlier mapping */
+
 struct savecontext {
     int fd;			/* save/restore file descriptor */
     char *buffer;		/* save/restore buffer */
@@ -367,6 +384,157 @@ static void save_mapping(savecontext *x, Array *a)
     put(x, "])", 2);
 }
 
+/*
+ * NAME:	bsave_number()
+ * DESCRIPTION:	save a variable-length unsigned number
+ */
+static void bsave_number(savecontext *x, Uint n)
+{
+    char buf[5];
+    int len;
+
+    for (len = 0; n >= 0x80; n >>= 7) {
+	buf[len++] = (char) (n | 0x80);
+    }
+    buf[len++] = (char) n;
+    put(x, buf, len);
+}
+
+static void bsave_array	(savecontext*, Array*);
+static void bsave_mapping	(savecontext*, Array*);
+
+/*
+ * NAME:	bsave_value()
+ * DESCRIPTION:	save a value in binary format
+ */
+static void bsave_value(savecontext *x, Value *v)
+{
+    char buf[7];
+    Float flt;
+
+    switch (v->type) {
+    case T_NIL:
+	put(x, "\0", 1);	/* B_NIL */
+	break;
+
+    case T_INT:
+	buf[0] = B_INT;
+	put(x, buf, 1);
+	bsave_number(x, ((Uint) v->u.number << 1) ^ (Uint) -(v->u.number < 0));
+	break;
+
+    case T_FLOAT:
+	GET_FLT(v, flt);
+	buf[0] = B_FLOAT;
+	buf[1] = flt.high >> 8;
+	buf[2] = flt.high;
+	buf[3] = flt.low >> 24;
+	buf[4] = flt.low >> 16;
+	buf[5] = flt.low >> 8;
+	buf[6] = flt.low;
+	put(x, buf, 7);
+	break;
+
+    case T_STRING:
+	buf[0] = B_STRING;
+	put(x, buf, 1);
+	bsave_number(x, v->u.string->len);
+	put(x, v->u.string->text, v->u.string->len);
+	break;
+
+    case T_OBJECT:
+    case T_LWOBJECT:
+	if (conf_typechecking() >= 2) {
+	    put(x, "\0", 1);	/* B_NIL */
+	} else {
+	    buf[0] = B_INT;
+	    buf[1] = 0;
+	    put(x, buf, 2);
+	}
+	break;
+
+    case T_ARRAY:
+	bsave_array(x, v->u.array);
+	break;
+
+    case T_MAPPING:
+	bsave_mapping(x, v->u.array);
+	break;
+    }
+}
+
+/*
+ * NAME:	bsave_array()
+ * DESCRIPTION:	save an array in binary format
+ */
+static void bsave_array(savecontext *x, Array *a)
+{
+    char buf[1];
+    Uint i;
+    Value *v;
+
+    i = arr_put(a, x->narrays);
+    if (i < x->narrays) {
+	/* same as some previous array */
+	buf[0] = B_AREF;
+	put(x, buf, 1);
+	bsave_number(x, i);
+	return;
+    }
+    x->narrays++;
+
+    buf[0] = B_ARRAY;
+    put(x, buf, 1);
+    bsave_number(x, a->size);
+    for (i = a->size, v = d_get_elts(a); i > 0; --i, v++) {
+	bsave_value(x, v);
+    }
+}
+
+/*
+ * NAME:	bsave_mapping()
+ * DESCRIPTION:	save a mapping in binary format
+ */
+static void bsave_mapping(savecontext *x, Array *a)
+{
+    char buf[1];
+    Uint i;
+    uindex n;
+    Value *v;
+
+    i = arr_put(a, x->narrays);
+    if (i < x->narrays) {
+	/* same as some previous mapping */
+	buf[0] = B_MREF;
+	put(x, buf, 1);
+	bsave_number(x, i);
+	return;
+    }
+    x->narrays++;
+    map_compact(a->primary->data, a);
+
+    /*
+     * skip index/value pairs of which either is an object
+     */
+    for (i = n = a->size >> 1, v = d_get_elts(a); i > 0; --i, v += 2) {
+	if (v[0].type == T_OBJECT || v[0].type == T_LWOBJECT ||
+	    v[1].type == T_OBJECT || v[1].type == T_LWOBJECT) {
+	    --n;
+	}
+    }
+    buf[0] = B_MAPPING;
+    put(x, buf, 1);
+    bsave_number(x, n);
+
+    for (i = a->size >> 1, v = a->elts; i > 0; --i, v += 2) {
+	if (v[0].type != T_OBJECT && v[0].type != T_LWOBJECT &&
+	    v[1].type != T_OBJECT && v[1].type != T_LWOBJECT) {
+	    bsave_value(x, &v[0]);
+	    bsave_value(x, &v[1]);
+	}
+    }
+}
+
 char pt_save_object[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_VOID,
 			  T_STRING };
 
@@ -386,6 +554,8 @@ int kf_save_object(Frame *f, int n, kfunc *kf)
     char file[STRINGSZ], buf[18], tmp[STRINGSZ + 8], *_tmp;
     savecontext x;
     Float flt;
+    size_t len;
+    bool binary;
 
     UNREFERENCED_PARAMETER(n);
     UNREFERENCED_PARAMETER(kf);
@@ -397,6 +567,9 @@ int kf_save_object(Frame *f, int n, kfunc *kf)
     if (f->level != 0) {
 	error("save_object() within atomic function");
     }
+    len = strlen(file);
+    binary = (len > sizeof(BSAVE_EXT) - 1 &&
+	      strcmp(file + len - (sizeof(BSAVE_EXT) - 1), BSAVE_EXT) == 0);
 
     /*
      * First save in a different file in the same directory, so a possibly
@@ -413,6 +586,9 @@ int kf_save_object(Frame *f, int n, kfunc *kf)
     }
     x.buffer = ALLOCA(char, BUF_SIZE);
     x.bufsz = 0;
+    if (binary) {
+	put(&x, BSAVE_MAGIC, BSAVE_MAGICSZ);
+    }
 
     ctrl = f->ctrl;
     arr_merge();
@@ -443,35 +619,42 @@ int kf_save_object(Frame *f, int n, kfunc *kf)
 		     * don't save object values, nil or 0
 		     */
 		    str = d_get_strconst(ctrl, v->inherit, v->index);
-		    put(&x, str->text, str->len);
-		    put(&x, " ", 1);
-		    switch (var->type) {
-		    case T_INT:
-			sprintf(buf, "%ld", (long) var->u.number);
-			put(&x, buf, strlen(buf));
-			break;
-
-		    case T_FLOAT:
-			GET_FLT(var, flt);
-			flt.ftoa(buf);
-			put(&x, buf, strlen(buf));
-			sprintf(buf, "=%04x%08lx", flt.high, (long) flt.low);
-			put(&x, buf, 13);
-			break;
-
-		    case T_STRING:
-			save_string(&x, var->u.string);
-			break;
-
-		    case T_ARRAY:
-			save_array(&x, var->u.array);
-			break;
-
-		    case T_MAPPING:
-			save_mapping(&x, var->u.array);
-			break;
+		    if (binary) {
+			bsave_number(&x, str->len);
+			put(&x, str->text, str->len);
+			bsave_value(&x, var);
+		    } else {
+			put(&x, str->text, str->len);
+			put(&x, " ", 1);
+			switch (var->type) {
+			case T_INT:
+			    sprintf(buf, "%ld", (long) var->u.number);
+			    put(&x, buf, strlen(buf));
+			    break;
+
+			case T_FLOAT:
+			    GET_FLT(var, flt);
+			    flt.ftoa(buf);
+			    put(&x, buf, strlen(buf));
+			    sprintf(buf, "=%04x%08lx", flt.high,
+				    (long) flt.low);
+			    put(&x, buf, 13);
+			    break;
+
+			case T_STRING:
+			    save_string(&x, var->u.string);
+			    break;
+
+			case T_ARRAY:
+			    save_array(&x, var->u.array);
+			    break;
+
+			case T_MAPPING:
+			    save_mapping(&x, var->u.array);
+			    break;
+			}
+			put(&x, "\012", 1);	/* LF */
 		    }
-		    put(&x, "\012", 1);	/* LF */
 		}
 		var++;
 		nvars++;
@@ -541,6 +724,9 @@ struct restcontext {
     Frame *f;			/* interpreter frame */
     vchunk alist;		/* list of array value chunks */
     Uint narrays;		/* # of arrays/mappings */
+    bool binary;		/* binary save file? */
+    char *end;			/* end of binary save file */
+    char name[STRINGSZ];	/* variable name in binary save file */
     char file[STRINGSZ];	/* current restore file */
 };
 
@@ -574,7 +760,8 @@ static Value *ac_get(restcontext *x, Uint n)
  */
 static void restore_error(restcontext *x, const char *err)
 {
-    error("Format error in \"/%s\", line %d: %s", x->file, x->line, err);
+    error("Format error in \"/%s\", %s %d: %s", x->file,
+	  (x->binary) ? "record" : "line", x->line, err);
 }
 
 /*
@@ -701,7 +888,7 @@ static char *restore_string(restcontext *x, char *buf, Value *val)
 	*q++ = *p;
     }
 
-    PUT_STRVAL_NOREF(val, str_new(buf, (intptr_t) q - (intptr_t) buf));
+    PUT_STRVAL_NOREF(val, str_pool(buf, (intptr_t) q - (intptr_t) buf));
     return p + 1;
 }
 
@@ -870,6 +1057,233 @@ static char *restore_value(restcontext *x, char *buf, Value *val)
     }
 }
 
+/*
+ * NAME:	brestore_number()
+ * DESCRIPTION:	restore a variable-length unsigned number
+ */
+static char *brestore_number(restcontext *x, char *buf, Uint *n)
+{
+    int shift;
+    Uint c;
+
+    *n = 0;
+    for (shift = 0; ; shift += 7) {
+	if (buf == x->end || shift > 28) {
+	    restore_error(x, "bad number");
+	}
+	c = UCHAR(*buf++);
+	*n |= (c & 0x7f) << shift;
+	if (!(c & 0x80)) {
+	    return buf;
+	}
+    }
+}
+
+/*
+ * NAME:	brestore_name()
+ * DESCRIPTION:	restore a variable name
+ */
+static char *brestore_name(restcontext *x, char *buf)
+{
+    Uint len;
+
+    buf = brestore_number(x, buf, &len);
+    if (len == 0 || len >= STRINGSZ || len > (Uint) (x->end - buf) ||
+	memchr(buf, '\0', len) != (void *) NULL) {
+	restore_error(x, "bad variable name");
+    }
+    memcpy(x->name, buf, len);
+    x->name[len] = '\0';
+    return buf + len;
+}
+
+static char *brestore_value	(restcontext*, char*, Value*);
+
+/*
+ * NAME:	brestore_array()
+ * DESCRIPTION:	restore an array or mapping in binary format
+ */
+static char *brestore_array(restcontext *x, char *buf, Value *val,
+			    bool mapping)
+{
+    Uint i;
+    Value *v;
+    Array *a;
+
+    buf = brestore_number(x, buf, &i);
+    if (i > (Uint) (x->end - buf)) {
+	/* each element takes at least one byte */
+	restore_error(x, "bad array size");
+    }
+    if (mapping) {
+	a = map_new(x->f->data, (long) i << 1);
+    } else {
+	a = arr_new(x->f->data, (long) i);
+    }
+    ac_put(x, (mapping) ? T_MAPPING : T_ARRAY, a);
+    for (i = a->size, v = a->elts; i > 0; --i) {
+	*v++ = nil_value;
+    }
+    try {
+	ec_push((ec_ftn) NULL);
+	/* restore the values */
+	for (i = a->size, v = a->elts; i > 0; --i) {
+	    buf = brestore_value(x, buf, v);
+	    i_ref_value(v++);
+	}
+	if (mapping) {
+	    map_sort(a);
+	}
+	ec_pop();
+    } catch (...) {
+	arr_ref(a);
+	arr_del(a);
+	error((char *) NULL);	/* pass on the error */
+    }
+
+    if (mapping) {
+	PUT_MAPVAL_NOREF(val, a);
+    } else {
+	PUT_ARRVAL_NOREF(val, a);
+    }
+    return buf;
+}
+
+/*
+ * NAME:	brestore_value()
+ * DESCRIPTION:	restore a value in binary format
+ */
+static char *brestore_value(restcontext *x, char *buf, Value *val)
+{
+    Uint n;
+    Float flt;
+
+    if (buf == x->end) {
+	restore_error(x, "value expected");
+    }
+    switch (*buf++) {
+    case B_NIL:
+	*val = nil_value;
+	return buf;
+
+    case B_INT:
+	buf = brestore_number(x, buf, &n);
+	PUT_INTVAL(val, (Int) ((n >> 1) ^ -(n & 1)));
+	return buf;
+
+    case B_FLOAT:
+	if (x->end - buf < 6) {
+	    restore_error(x, "bad float");
+	}
+	flt.high = (UCHAR(buf[0]) << 8) | UCHAR(buf[1]);
+	flt.low = ((Uint) UCHAR(buf[2]) << 24) | (UCHAR(buf[3]) << 16) |
+		  (UCHAR(buf[4]) << 8) | UCHAR(buf[5]);
+	if ((flt.high & 0x7ff0) == 0x7ff0) {
+	    restore_error(x, "illegal exponent");
+	}
+	PUT_FLTVAL(val, flt);
+	return buf + 6;
+
+    case B_STRING:
+	buf = brestore_number(x, buf, &n);
+	if (n > (Uint) (x->end - buf)) {
+	    restore_error(x, "bad string length");
+	}
+	PUT_STRVAL_NOREF(val, str_pool(buf, (long) n));
+	return buf + n;
+
+    case B_ARRAY:
+	return brestore_array(x, buf, val, FALSE);
+
+    case B_MAPPING:
+	return brestore_array(x, buf, val, TRUE);
+
+    case B_AREF:
+	buf = brestore_number(x, buf, &n);
+	if (n >= x->narrays) {
+	    restore_error(x, "bad array reference");
+	}
+	*val = *ac_get(x, n);
+	if (val->type != T_ARRAY && val->type != T_NIL) {
+	    /* nil refers to a value that was skipped */
+	    restore_error(x, "bad array reference");
+	}
+	return buf;
+
+    case B_MREF:
+	buf = brestore_number(x, buf, &n);
+	if (n >= x->narrays) {
+	    restore_error(x, "bad mapping reference");
+	}
+	*val = *ac_get(x, n);
+	if (val->type != T_MAPPING && val->type != T_NIL) {
+	    /* nil refers to a value that was skipped */
+	    restore_error(x, "bad mapping reference");
+	}
+	return buf;
+
+    default:
+	restore_error(x, "bad value type");
+	return buf;
+    }
+}
+
+/*
+ * NAME:	bskip_value()
+ * DESCRIPTION:	skip a value in binary format, keeping the array count
+ */
+static char *bskip_value(restcontext *x, char *buf)
+{
+    Uint n;
+
+    if (buf == x->end) {
+	restore_error(x, "value expected");
+    }
+    switch (*buf++) {
+    case B_NIL:
+	return buf;
+
+    case B_INT:
+    case B_AREF:
+    case B_MREF:
+	return brestore_number(x, buf, &n);
+
+    case B_FLOAT:
+	if (x->end - buf < 6) {
+	    restore_error(x, "bad float");
+	}
+	return buf + 6;
+
+    case B_STRING:
+	buf = brestore_number(x, buf, &n);
+	if (n > (Uint) (x->end - buf)) {
+	    restore_error(x, "bad string length");
+	}
+	return buf + n;
+
+    case B_MAPPING:
+	buf = brestore_number(x, buf, &n);
+	ac_put(x, T_NIL, (Array *) NULL);	/* cannot be referenced */
+	for (n <<= 1; n > 0; --n) {
+	    buf = bskip_value(x, buf);
+	}
+	return buf;
+
+    case B_ARRAY:
+	buf = brestore_number(x, buf, &n);
+	ac_put(x, T_NIL, (Array *) NULL);	/* cannot be referenced */
+	while (n > 0) {
+	    buf = bskip_value(x, buf);
+	    --n;
+	}
+	return buf;
+
+    default:
+	restore_error(x, "bad value type");
+	return buf;
+    }
+}
+
 char pt_restore_object[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_INT,
 			     T_STRING };
 
@@ -892,7 +1306,8 @@ int kf_restore_object(Frame *f, int n, kfunc *kf)
     Object *obj;
     int fd;
     char *buffer, *name;
-    bool onstack, pending;
+    char magic[BSAVE_MAGICSZ];
+    bool onstack, mapped, pending;
 
     UNREFERENCED_PARAMETER(n);
     UNREFERENCED_PARAMETER(kf);
@@ -917,24 +1332,39 @@ int kf_restore_object(Frame *f, int n, kfunc *kf)
 	P_close(fd);
 	return 0;
     }
-    buffer = ALLOCA(char, sbuf.st_size + 1);
-    if (buffer == (char *) NULL) {
-	buffer = ALLOC(char, sbuf.st_size + 1);
-	onstack = FALSE;
-    } else {
-	onstack = TRUE;
-    }
-    if (P_read(fd, buffer, (unsigned int) sbuf.st_size) != sbuf.st_size) {
-	/* read failed (should never happen, but...) */
-	P_close(fd);
-	if (onstack) {
-	    AFREE(buffer);
+
+    /*
+     * A binary save file is mapped rather than read, if possible.
+     */
+    x.binary = (sbuf.st_size >= BSAVE_MAGICSZ &&
+		P_read(fd, magic, BSAVE_MAGICSZ) == BSAVE_MAGICSZ &&
+		memcmp(magic, BSAVE_MAGIC, BSAVE_MAGICSZ) == 0);
+    P_lseek(fd, 0, SEEK_SET);
+    onstack = mapped = FALSE;
+    buffer = (char *) NULL;
+    if (x.binary) {
+	buffer = P_mmap(fd, (size_t) sbuf.st_size);
+	mapped = (buffer != (char *) NULL);
+    }
+    if (!mapped) {
+	buffer = ALLOCA(char, sbuf.st_size + 1);
+	if (buffer == (char *) NULL) {
+	    buffer = ALLOC(char, sbuf.st_size + 1);
 	} else {
-	    FREE(buffer);
+	    onstack = TRUE;
 	}
-	return 0;
+	if (P_read(fd, buffer, (unsigned int) sbuf.st_size) != sbuf.st_size) {
+	    /* read failed (should never happen, but...) */
+	    P_close(fd);
+	    if (onstack) {
+		AFREE(buffer);
+	    } else {
+		FREE(buffer);
+	    }
+	    return 0;
+	}
+	buffer[sbuf.st_size] = '\0';
     }
-    buffer[sbuf.st_size] = '\0';
     P_close(fd);
 
     /*
@@ -977,7 +1407,12 @@ int kf_restore_object(Frame *f, int n, kfunc *kf)
     x.line = 1;
     x.f = f;
     x.narrays = 0;
-    buf = buffer;
+    if (x.binary) {
+	buf = buffer + BSAVE_MAGICSZ;
+	x.end = buffer + sbuf.st_size;
+    } else {
+	buf = buffer;
+    }
     pending = FALSE;
     try {
 	ec_push((ec_ftn) NULL);
@@ -1007,11 +1442,15 @@ int kf_restore_object(Frame *f, int n, kfunc *kf)
 			     * The saved variable is not in this object.
 			     * Skip it.
 			     */
-			    buf = strchr(buf, LF);
-			    if (buf == (char *) NULL) {
-				restore_error(&x, "'\\n' expected");
+			    if (x.binary) {
+				buf = bskip_value(&x, buf);
+			    } else {
+				buf = strchr(buf, LF);
+				if (buf == (char *) NULL) {
+				    restore_error(&x, "'\\n' expected");
+				}
+				buf++;
 			    }
-			    buf++;
 			    x.line++;
 			    pending = FALSE;
 			}
@@ -1019,32 +1458,41 @@ int kf_restore_object(Frame *f, int n, kfunc *kf)
 			    /*
 			     * get a new variable name from the save file
 			     */
-			    while (*buf == '#') {
-				/* skip comment */
-				buf = strchr(buf, LF);
-				if (buf == (char *) NULL) {
-				    restore_error(&x, "'\\n' expected");
+			    if (x.binary) {
+				if (buf == x.end) {
+				    /* end of file */
+				    break;
+				}
+				buf = brestore_name(&x, buf);
+				name = x.name;
+			    } else {
+				while (*buf == '#') {
+				    /* skip comment */
+				    buf = strchr(buf, LF);
+				    if (buf == (char *) NULL) {
+					restore_error(&x, "'\\n' expected");
+				    }
+				    buf++;
+				    x.line++;
+				}
+				if (*buf == '\0') {
+				    /* end of file */
+				    break;
 				}
-				buf++;
-				x.line++;
-			    }
-			    if (*buf == '\0') {
-				/* end of file */
-				break;
-			    }
 
-			    name = buf;
-			    if (!isalpha(*buf) && *buf != '_') {
-				restore_error(&x, "alphanumeric expected");
-			    }
-			    do {
-				buf++;
-			    } while (isalnum(*buf) || *buf == '_');
-			    if (*buf != ' ') {
-				restore_error(&x, "' ' expected");
-			    }
+				name = buf;
+				if (!isalpha(*buf) && *buf != '_') {
+				    restore_error(&x, "alphanumeric expected");
+				}
+				do {
+				    buf++;
+				} while (isalnum(*buf) || *buf == '_');
+				if (*buf != ' ') {
+				    restore_error(&x, "' ' expected");
+				}
 
-			    *buf++ = '\0';	/* terminate name */
+				*buf++ = '\0';	/* terminate name */
+			    }
 			    pending = TRUE;	/* start checking variables */
 			    checkpoint = nvars;	/* from here */
 			}
@@ -1057,7 +1505,8 @@ int kf_restore_object(Frame *f, int n, kfunc *kf)
 			    /*
 			     * found the proper variable to restore
 			     */
-			    buf = restore_value(&x, buf, &tmp);
+			    buf = (x.binary) ? brestore_value(&x, buf, &tmp) :
+					       restore_value(&x, buf, &tmp);
 			    if (v->type != tmp.type && v->type != T_MIXED &&
 				conf_typechecking() &&
 				(!VAL_NIL(&tmp) || !T_POINTER(v->type)) &&
@@ -1072,7 +1521,7 @@ int kf_restore_object(Frame *f, int n, kfunc *kf)
 			    } else {
 				d_assign_var(data, var, &tmp);
 			    }
-			    if (*buf++ != LF) {
+			    if (!x.binary && *buf++ != LF) {
 				restore_error(&x, "'\\n' expected");
 			    }
 			    x.line++;
@@ -1081,12 +1530,15 @@ int kf_restore_object(Frame *f, int n, kfunc *kf)
 			var++;
 			nvars++;
 		    }
-		    if (!pending && *buf == '\0') {
+		    if (!pending &&
+			((x.binary) ? buf == x.end : *buf == '\0')) {
 			/*
 			 * finished restoring
 			 */
 			x.alist.clean();
-			if (onstack) {
+			if (mapped) {
+			    P_munmap(buffer, (size_t) sbuf.st_size);
+			} else if (onstack) {
 			    AFREE(buffer);
 			} else {
 			    FREE(buffer);
@@ -1101,7 +1553,9 @@ int kf_restore_object(Frame *f, int n, kfunc *kf)
     } catch (...) {
 	/* error; clean up */
 	x.alist.clean();
-	if (onstack) {
+	if (mapped) {
+	    P_munmap(buffer, (size_t) sbuf.st_size);
+	} else if (onstack) {
 	    AFREE(buffer);
 	} else {
 	    FREE(buffer);
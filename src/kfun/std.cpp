@@ -122,6 +122,7 @@ int kf_call_other(Frame *f, int nargs, kfunc *kf)
     Value *val;
     Object *obj;
     Array *lwobj;
+    String *path;
 
     UNREFERENCED_PARAMETER(kf);
 
@@ -129,10 +130,23 @@ int kf_call_other(Frame *f, int nargs, kfunc *kf)
     lwobj = (Array *) NULL;
     val = &f->sp[nargs - 1];
     if (val->type == T_STRING) {
-	*--f->sp = *val;
-	*val = nil_value;	/* erase old copy */
-	call_driver_object(f, "call_object", 1);
-	*val = *f->sp++;
+	path = val->u.string;
+	obj = o_pcache_find(f->p_ctrl->oindex, path);
+	if (obj != (Object *) NULL) {
+	    /* resolved before */
+	    PUT_OBJVAL(val, obj);
+	    str_del(path);
+	} else {
+	    /* the argument keeps its reference in case of an error */
+	    str_ref(path);
+	    *--f->sp = *val;
+	    call_driver_object(f, "call_object", 1);
+	    if (f->sp->type == T_OBJECT) {
+		o_pcache_add(f->p_ctrl->oindex, path, OBJR(f->sp->oindex));
+	    }
+	    str_del(path);
+	    *val = *f->sp++;
+	}
     }
     switch (val->type) {
     case T_OBJECT:
@@ -909,6 +923,43 @@ int kf_sizeof(Frame *f, int n, kfunc *kf)
 # endif
 
 
+# ifdef FUNCDEF
+FUNCDEF("freeze", kf_freeze, pt_freeze, 0)
+# else
+char pt_freeze[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_MIXED, T_MIXED };
+
+/*
+ * NAME:	kfun->freeze()
+ * DESCRIPTION:	return an immutable copy of an array or mapping, which is
+ *		shared between objects rather than copied into each of them
+ */
+int kf_freeze(Frame *f, int n, kfunc *kf)
+{
+    Array *a;
+
+    UNREFERENCED_PARAMETER(n);
+    UNREFERENCED_PARAMETER(kf);
+
+    switch (f->sp->type) {
+    case T_ARRAY:
+    case T_MAPPING:
+	a = f->sp->u.array;
+	if (!a->frozen) {
+	    i_add_ticks(f, 4 * a->size);
+	    arr_ref(f->sp->u.array = arr_freeze(a, f->sp->type));
+	    arr_del(a);
+	}
+	break;
+
+    case T_LWOBJECT:
+	error("Bad argument for kfun freeze");
+	break;
+    }
+    return 0;
+}
+# endif
+
+
 # ifdef FUNCDEF
 FUNCDEF("map_indices", kf_map_indices, pt_map_indices, 0)
 # else
@@ -1163,6 +1214,60 @@ int kf_block_input(Frame *f, int n, kfunc *kf)
 # endif
 
 
+# ifdef FUNCDEF
+FUNCDEF("frame_input", kf_frame_input, pt_frame_input, 0)
+# else
+char pt_frame_input[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_VOID,
+			  T_MIXED };
+
+/*
+ * NAME:	kfun->frame_input()
+ * DESCRIPTION:	set input framing for the current binary connection: 0 for
+ *		none, 2 or 4 for a big-endian length prefix of that size, or
+ *		a single-character delimiter
+ */
+int kf_frame_input(Frame *f, int n, kfunc *kf)
+{
+    Object *obj;
+    int type, delim;
+
+    UNREFERENCED_PARAMETER(n);
+    UNREFERENCED_PARAMETER(kf);
+
+    delim = '\0';
+    switch (f->sp->type) {
+    case T_INT:
+	type = f->sp->u.number;
+	if (type != FRAME_NONE && type != FRAME_LEN2 && type != FRAME_LEN4) {
+	    return 1;
+	}
+	break;
+
+    case T_STRING:
+	if (f->sp->u.string->len != 1) {
+	    return 1;
+	}
+	type = FRAME_DELIM;
+	delim = f->sp->u.string->text[0];
+	str_del(f->sp->u.string);
+	break;
+
+    default:
+	return 1;
+    }
+
+    if (f->lwobj == (Array *) NULL) {
+	obj = OBJR(f->oindex);
+	if ((obj->flags & O_SPECIAL) == O_USER && obj->count != 0) {
+	    comm_framing(obj, type, delim);
+	}
+    }
+    *f->sp = nil_value;
+    return 0;
+}
+# endif
+
+
 # ifdef FUNCDEF
 FUNCDEF("time", kf_time, pt_time, 0)
 # else
@@ -1335,6 +1440,28 @@ int kf_swapout(Frame *f, int n, kfunc *kf)
 # endif
 
 
+# ifdef FUNCDEF
+FUNCDEF("clear_call_cache", kf_clear_call_cache, pt_clear_call_cache, 0)
+# else
+char pt_clear_call_cache[] = { C_STATIC, 0, 0, 0, 6, T_VOID };
+
+/*
+ * NAME:	kfun->clear_call_cache()
+ * DESCRIPTION:	forget how call_other paths were resolved
+ */
+int kf_clear_call_cache(Frame *f, int n, kfunc *kf)
+{
+    UNREFERENCED_PARAMETER(n);
+    UNREFERENCED_PARAMETER(kf);
+
+    o_pcache_clear();
+
+    *--f->sp = nil_value;
+    return 0;
+}
+# endif
+
+
 # ifdef FUNCDEF
 FUNCDEF("dump_state", kf_dump_state, pt_dump_state, 1)
 # else
@@ -1496,6 +1623,34 @@ int kf_status(Frame *f, int nargs, kfunc *kf)
 # endif
 
 
+# ifdef FUNCDEF
+FUNCDEF("memory_top", kf_memory_top, pt_memory_top, 0)
+# else
+char pt_memory_top[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7,
+			 T_OBJECT | (1 << REFSHIFT), T_INT };
+
+/*
+ * NAME:	kfun->memory_top()
+ * DESCRIPTION:	return the objects that use the most memory, largest first
+ */
+int kf_memory_top(Frame *f, int n, kfunc *kf)
+{
+    Int count;
+
+    UNREFERENCED_PARAMETER(n);
+    UNREFERENCED_PARAMETER(kf);
+
+    count = f->sp->u.number;
+    if (count < 0) {
+	return 1;
+    }
+    i_add_ticks(f, 100 + o_count());
+    PUT_ARRVAL(f->sp, conf_memtop(f->data, count));
+    return 0;
+}
+# endif
+
+
 # ifdef CLOSURES
 # ifdef FUNCDEF
 FUNCDEF("new.function", kf_new_function, pt_new_function, 0)
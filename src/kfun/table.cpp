@@ -59,7 +59,17 @@ extern void kf_dec(Frame *, int, Value *);
 extern void kf_dec_key(Frame *, int, Value *);
 extern void kf_xcrypt(Frame *, int, Value *);
 extern void kf_md5(Frame *, int, Value *);
+extern void kf_md5_update(Frame *, int, Value *);
+extern void kf_md5_final(Frame *, int, Value *);
 extern void kf_sha1(Frame *, int, Value *);
+extern void kf_sha1_update(Frame *, int, Value *);
+extern void kf_sha1_final(Frame *, int, Value *);
+extern void kf_sha256(Frame *, int, Value *);
+extern void kf_sha256_update(Frame *, int, Value *);
+extern void kf_sha256_final(Frame *, int, Value *);
+extern void kf_sha512(Frame *, int, Value *);
+extern void kf_sha512_update(Frame *, int, Value *);
+extern void kf_sha512_final(Frame *, int, Value *);
 
 /*
  * NAME:	kfun->clear()
@@ -74,13 +84,23 @@ void kf_clear()
 	{ "decrypt DES", proto, kf_dec },
 	{ "decrypt DES key", proto, kf_dec_key },
 	{ "hash MD5", proto, kf_md5 },
+	{ "hash MD5 update", proto, kf_md5_update },
+	{ "hash MD5 final", proto, kf_md5_final },
 	{ "hash SHA1", proto, kf_sha1 },
+	{ "hash SHA1 update", proto, kf_sha1_update },
+	{ "hash SHA1 final", proto, kf_sha1_final },
+	{ "hash SHA256", proto, kf_sha256 },
+	{ "hash SHA256 update", proto, kf_sha256_update },
+	{ "hash SHA256 final", proto, kf_sha256_final },
+	{ "hash SHA512", proto, kf_sha512 },
+	{ "hash SHA512 update", proto, kf_sha512_update },
+	{ "hash SHA512 final", proto, kf_sha512_final },
 	{ "hash crypt", proto, kf_xcrypt }
     };
 
     nkfun = sizeof(kforig) / sizeof(kfunc);
     ne = nd = nh = 0;
-    kf_ext_kfun(builtin, 7);
+    kf_ext_kfun(builtin, sizeof(builtin) / sizeof(extkfunc));
 }
 
 /*
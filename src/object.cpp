@@ -65,7 +65,7 @@ struct objplane {
     objplane *prev;		/* previous object plane */
 };
 
-Object *otable;			/* object table */
+Object **otable;		/* object table segments */
 Uint *ocmap;			/* object change map */
 bool obase;			/* object base plane flag */
 bool swap, dump, incr, stop, boot; /* global state vars */
@@ -84,16 +84,95 @@ static Uint dinterval;		/* copy interval */
 static Uint dtime;		/* time copying started */
 Uint odcount;			/* objects destructed count */
 
+struct pathcache {
+    String *path;		/* path resolved by the driver object */
+    uindex prog;		/* calling program */
+    uindex obj;			/* resolved object */
+    Uint pcount;		/* creation count of calling program */
+    Uint count;			/* creation count of resolved object */
+};
+
+static pathcache *pcache;	/* call_other path cache */
+static unsigned int pcachesz;	/* size of path cache (power of two) */
+
+/*
+ * NAME:	Object->bmap()
+ * DESCRIPTION:	enlarge a bitmap from size to n bits
+ */
+static Uint *o_bmap(Uint *map, unsigned int size, unsigned int n)
+{
+    Uint *m;
+
+    m = ALLOC(Uint, BMAP(n));
+    if (map != (Uint *) NULL) {
+	memcpy(m, map, BMAP(size) * sizeof(Uint));
+	FREE(map);
+    }
+    memset(m + BMAP(size), '\0', (BMAP(n) - BMAP(size)) * sizeof(Uint));
+    return m;
+}
+
+/*
+ * NAME:	Object->grow()
+ * DESCRIPTION:	enlarge the object table to n objects.  Objects are never
+ *		moved, so both indices and pointers remain valid.
+ */
+static void o_grow(unsigned int n)
+{
+    unsigned int i, osegs, nsegs;
+    Object **tab;
+    Uint *ct;
+
+    osegs = (otabsize + OSEGSIZE - 1) >> OSEGBITS;
+    nsegs = (n + OSEGSIZE - 1) >> OSEGBITS;
+
+    m_static();
+    if (nsegs > osegs) {
+	/* add segments */
+	tab = ALLOC(Object*, nsegs);
+	if (otable != (Object **) NULL) {
+	    memcpy(tab, otable, osegs * sizeof(Object*));
+	    FREE(otable);
+	}
+	for (i = osegs; i < nsegs; i++) {
+	    tab[i] = ALLOC(Object, OSEGSIZE);
+	    memset(tab[i], '\0', OSEGSIZE * sizeof(Object));
+	}
+	otable = tab;
+    }
+    ocmap = o_bmap(ocmap, otabsize, n);
+    omap = o_bmap(omap, otabsize, n);
+    ct = ALLOC(Uint, n);
+    if (counttab != (Uint *) NULL) {
+	memcpy(ct, counttab, otabsize * sizeof(Uint));
+	FREE(counttab);
+    }
+    counttab = ct;
+    if (baseplane.htab != (Hashtab *) NULL) {
+	/* keep the object name hash table in proportion */
+	for (i = 4; i < n; i <<= 1) ;
+	if ((i >>= 2) > baseplane.htab->size()) {
+	    baseplane.htab->resize(i);
+	}
+    }
+    m_dynamic();
+
+    if (otabsize != 0) {
+	d_grow(n);
+    }
+    otabsize = n;
+}
+
 /*
  * NAME:	Object->init()
  * DESCRIPTION:	initialize the object tables
  */
 void o_init(unsigned int n, Uint interval)
 {
-    otable = ALLOC(Object, otabsize = n);
-    memset(otable, '\0', n * sizeof(Object));
-    ocmap = ALLOC(Uint, BMAP(n));
-    memset(ocmap, '\0', BMAP(n) * sizeof(Uint));
+    otable = (Object **) NULL;
+    ocmap = omap = counttab = (Uint *) NULL;
+    otabsize = 0;
+    o_grow(n);
     for (n = 4; n < otabsize; n <<= 1) ;
     baseplane.htab = Hashtab::create(n >> 2, OBJHASHSZ, FALSE);
     baseplane.optab = (optable *) NULL;
@@ -105,9 +184,6 @@ void o_init(unsigned int n, Uint interval)
     baseplane.swap = baseplane.dump = baseplane.incr = baseplane.stop =
 		     baseplane.boot = FALSE;
     oplane = &baseplane;
-    omap = ALLOC(Uint, BMAP(n));
-    memset(omap, '\0', BMAP(n) * sizeof(Uint));
-    counttab = ALLOC(Uint, n);
     upgraded = (Object *) NULL;
     uobjects = dobjects = mobjects = 0;
     dinterval = ((interval + 1) * 19) / 20;
@@ -235,7 +311,7 @@ Object *o_owrite(unsigned int index)
  */
 bool o_space()
 {
-    return (oplane->free != OBJ_NONE) ? TRUE : (oplane->nobjects != otabsize);
+    return (oplane->free != OBJ_NONE) ? TRUE : (oplane->nobjects != UINDEX_MAX);
 }
 
 /*
@@ -256,7 +332,12 @@ static Object *o_alloc()
     } else {
 	/* use new space in object table */
 	if (oplane->nobjects == otabsize) {
-	    error("Too many objects");
+	    if (otabsize == UINDEX_MAX) {
+		error("Too many objects");
+	    }
+	    /* enlarge object table */
+	    n = (otabsize < OSEGSIZE) ? OSEGSIZE : otabsize;
+	    o_grow((otabsize > UINDEX_MAX - n) ? UINDEX_MAX : otabsize + n);
 	}
 	n = oplane->nobjects++;
 	obj = OBJW(n);
@@ -452,6 +533,9 @@ void o_discard_plane()
     Object *obj, *clist;
     objplane *p;
 
+    /* creation counts may be handed out again */
+    o_pcache_clear();
+
     if (oplane->optab != (optable *) NULL) {
 	clist = (Object *) NULL;
 	for (i = OBJPATCHHTABSZ, o = oplane->optab->op; --i >= 0; o++) {
@@ -676,6 +760,9 @@ void o_upgrade(Object *obj, Control *ctrl, Frame *f)
     dinherit *inh;
     int i;
 
+    /* paths may resolve differently with the new program */
+    o_pcache_clear();
+
     /* allocate upgrade object */
     tmpl = o_alloc();
     tmpl->name = (char *) NULL;
@@ -896,6 +983,95 @@ Object *o_find(char *name, int access)
     return (access == OACC_READ) ? o : OBJW(number);
 }
 
+/*
+ * NAME:	Object->pcache_init()
+ * DESCRIPTION:	initialize the call_other path cache with at least n entries
+ */
+void o_pcache_init(unsigned int n)
+{
+    if (n != 0) {
+	for (pcachesz = 1; pcachesz < n; pcachesz <<= 1) ;
+	m_static();
+	pcache = ALLOC(pathcache, pcachesz);
+	m_dynamic();
+	memset(pcache, '\0', pcachesz * sizeof(pathcache));
+    }
+}
+
+/*
+ * NAME:	Object->pcache_entry()
+ * DESCRIPTION:	return the path cache slot for a path used by a program
+ */
+static pathcache *o_pcache_entry(uindex prog, String *path)
+{
+    return &pcache[(str_hash(path) ^ prog) & (pcachesz - 1)];
+}
+
+/*
+ * NAME:	Object->pcache_find()
+ * DESCRIPTION:	find the object that a path used by a program resolved to,
+ *		if it still exists
+ */
+Object *o_pcache_find(uindex prog, String *path)
+{
+    pathcache *e;
+    Object *o;
+
+    if (pcachesz != 0) {
+	e = o_pcache_entry(prog, path);
+	if (e->path != (String *) NULL && e->prog == prog &&
+	    e->path->len == path->len &&
+	    memcmp(e->path->text, path->text, path->len) == 0 &&
+	    OBJR(prog)->count == e->pcount) {
+	    o = OBJR(e->obj);
+	    if (o->count == e->count) {
+		return o;
+	    }
+	}
+    }
+    return (Object *) NULL;
+}
+
+/*
+ * NAME:	Object->pcache_add()
+ * DESCRIPTION:	remember the object that a path used by a program resolved to
+ */
+void o_pcache_add(uindex prog, String *path, Object *obj)
+{
+    pathcache *e;
+
+    if (pcachesz != 0) {
+	e = o_pcache_entry(prog, path);
+	if (e->path != (String *) NULL) {
+	    str_del(e->path);
+	}
+	m_static();
+	str_ref(e->path = str_new(path->text, path->len));
+	m_dynamic();
+	e->prog = prog;
+	e->pcount = OBJR(prog)->count;
+	e->obj = obj->index;
+	e->count = obj->count;
+    }
+}
+
+/*
+ * NAME:	Object->pcache_clear()
+ * DESCRIPTION:	empty the call_other path cache
+ */
+void o_pcache_clear()
+{
+    pathcache *e;
+    unsigned int i;
+
+    for (i = pcachesz, e = pcache; i != 0; --i, e++) {
+	if (e->path != (String *) NULL) {
+	    str_del(e->path);
+	    e->path = (String *) NULL;
+	}
+    }
+}
+
 /*
  * NAME:	Object->restore_object()
  * DESCRIPTION:	restore an object from the snapshot
@@ -1170,6 +1346,15 @@ uindex o_count()
     return oplane->nobjects - oplane->nfreeobjs;
 }
 
+/*
+ * NAME:	Object->tabsize()
+ * DESCRIPTION:	return the current size of the object table
+ */
+uindex o_tabsize()
+{
+    return otabsize;
+}
+
 /*
  * NAME:	Object->dobjects()
  * DESCRIPTION:	return the number of objects left to copy
@@ -1179,6 +1364,16 @@ uindex o_dobjects()
     return dobjects;
 }
 
+/*
+ * NAME:	Object->uncopied()
+ * DESCRIPTION:	return TRUE if the object is still to be copied from the
+ *		snapshot
+ */
+bool o_uncopied(Object *obj)
+{
+    return (BTST(omap, obj->index) != 0);
+}
+
 
 struct dump_header {
     uindex free;	/* free object list */
@@ -1207,11 +1402,13 @@ static char mh_layout[] = "uuuui";
  */
 static void o_sweep(uindex n)
 {
+    uindex i;
     Object *obj;
 
     uobjects = n;
     dobject = 0;
-    for (obj = otable; n > 0; obj++, --n) {
+    for (i = 0; i < n; i++) {
+	obj = OBJ(i);
 	if (obj->count != 0) {
 	    if (obj->cfirst != SW_UNUSED || obj->dfirst != SW_UNUSED) {
 		BSET(omap, obj->index);
@@ -1232,11 +1429,13 @@ static void o_sweep(uindex n)
  */
 static Uint o_recount(uindex n)
 {
+    uindex i;
     Uint count, *ct;
     Object *obj;
 
     count = 3;
-    for (obj = otable, ct = counttab; n > 0; obj++, ct++, --n) {
+    for (i = 0, ct = counttab; i < n; i++, ct++) {
+	obj = OBJ(i);
 	if (obj->count != 0) {
 	    *ct = obj->count;
 	    obj->count = count++;
@@ -1268,21 +1467,31 @@ bool o_dump(int fd, bool incr)
     dh.nobjects = baseplane.nobjects;
     dh.nfreeobjs = baseplane.nfreeobjs;
     dh.onamelen = 0;
-    for (i = baseplane.nobjects, o = otable; i > 0; --i, o++) {
+    for (i = 0; i < baseplane.nobjects; i++) {
+	o = OBJ(i);
 	if (o->name != (char *) NULL) {
 	    dh.onamelen += strlen(o->name) + 1;
 	}
     }
 
     /* write header and objects */
-    if (!sw_write(fd, &dh, sizeof(dump_header)) ||
-	!sw_write(fd, otable, baseplane.nobjects * sizeof(Object))) {
+    if (!sw_write(fd, &dh, sizeof(dump_header))) {
 	return FALSE;
     }
+    for (i = 0; i < baseplane.nobjects; i += len) {
+	len = baseplane.nobjects - i;
+	if (len > OSEGSIZE) {
+	    len = OSEGSIZE;
+	}
+	if (!sw_write(fd, OBJ(i), len * sizeof(Object))) {
+	    return FALSE;
+	}
+    }
 
     /* write object names */
     buflen = 0;
-    for (i = baseplane.nobjects, o = otable; i > 0; --i, o++) {
+    for (i = 0; i < baseplane.nobjects; i++) {
+	o = OBJ(i);
 	if (o->name != (char *) NULL) {
 	    len = strlen(o->name) + 1;
 	    if (buflen + len > CHUNKSZ) {
@@ -1349,17 +1558,24 @@ void o_restore(int fd, bool part)
     conf_dread(fd, (char *) &dh, dh_layout, (Uint) 1);
 
     if (dh.nobjects > otabsize) {
-	error("Too many objects in restore file (%u)", dh.nobjects);
+	o_grow(dh.nobjects);
     }
 
-    conf_dread(fd, (char *) otable, OBJ_LAYOUT, (Uint) dh.nobjects);
+    for (i = 0; i < dh.nobjects; i += len) {
+	len = dh.nobjects - i;
+	if (len > OSEGSIZE) {
+	    len = OSEGSIZE;
+	}
+	conf_dread(fd, (char *) OBJ(i), OBJ_LAYOUT, len);
+    }
     baseplane.free = dh.free;
     baseplane.nobjects = dh.nobjects;
     baseplane.nfreeobjs = dh.nfreeobjs;
 
     /* read object names */
     buflen = 0;
-    for (i = 0, o = otable; i < baseplane.nobjects; i++, o++) {
+    for (i = 0; i < baseplane.nobjects; i++) {
+	o = OBJ(i);
 	if (o->name != (char *) NULL) {
 	    /*
 	     * restore name
@@ -1532,8 +1748,11 @@ bool o_copy(Uint time)
 	}
 
 	while (dobjects > n) {
-	    for (obj = OBJ(dobject); !BTST(omap, obj->index); obj++) ;
-	    dobject = obj->index + 1;
+	    while (!BTST(omap, dobject)) {
+		dobject++;
+	    }
+	    obj = OBJ(dobject);
+	    dobject++;
 	    o_restore_obj(obj, FALSE, FALSE);
 	    if (time == 0) {
 		o_clean();
@@ -1543,7 +1762,8 @@ bool o_copy(Uint time)
     }
 
     if (dobjects == 0) {
-	for (n = uobjects, obj = otable; n > 0; --n, obj++) {
+	for (n = 0; n < uobjects; n++) {
+	    obj = OBJ(n);
 	    if (obj->count != 0 && (obj->flags & O_LWOBJ)) {
 		for (tmpl = obj; tmpl->prev != OBJ_NONE; tmpl = OBJ(tmpl->prev))
 		{
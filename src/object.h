@@ -49,9 +49,12 @@ struct Object : public Hashtab::Entry {
 
 # define OBJ_LAYOUT		"xceuuuiiippdd"
 
-# define OBJ(i)			(&otable[i])
-# define OBJR(i)		((BTST(ocmap, (i))) ? o_oread((i)) : &otable[i])
-# define OBJW(i)		((!obase) ? o_owrite((i)) : &otable[i])
+# define OSEGBITS		10	/* log2 of object table segment size */
+# define OSEGSIZE		(1 << OSEGBITS)
+
+# define OBJ(i)			(&otable[(i) >> OSEGBITS][(i) & (OSEGSIZE - 1)])
+# define OBJR(i)		((BTST(ocmap, (i))) ? o_oread((i)) : OBJ(i))
+# define OBJW(i)		((!obase) ? o_owrite((i)) : OBJ(i))
 
 # define O_UPGRADING(o)		((o)->cref > (o)->u_ref)
 # define O_INHERITED(o)		((o)->u_ref - 1 != (o)->cref)
@@ -81,12 +84,18 @@ extern void	  o_del			(Object*, Frame*);
 extern const char *o_name		(char*, Object*);
 extern const char *o_builtin_name	(Int);
 extern Object	 *o_find		(char*, int);
+extern void	  o_pcache_init		(unsigned int);
+extern Object	 *o_pcache_find		(uindex, String*);
+extern void	  o_pcache_add		(uindex, String*, Object*);
+extern void	  o_pcache_clear	();
 extern Control   *o_control		(Object*);
 extern Dataspace *o_dataspace		(Object*);
 
 extern void	  o_clean		();
 extern uindex	  o_count		();
+extern uindex	  o_tabsize		();
 extern uindex	  o_dobjects		();
+extern bool	  o_uncopied		(Object*);
 extern bool	  o_dump		(int, bool);
 extern void	  o_restore		(int, bool);
 extern bool	  o_copy		(Uint);
@@ -95,7 +104,7 @@ extern void	  swapout		();
 extern void	  dump_state		(bool);
 extern void	  finish		(bool);
 
-extern Object    *otable;
+extern Object   **otable;
 extern Uint	 *ocmap;
 extern bool	  obase, swap, dump, incr, stop, boot;
 extern Uint	  odcount;
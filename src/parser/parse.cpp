@@ -575,7 +575,7 @@ static Int ps_traverse(parser *ps, pnode *pn, pnode *next)
 	    /*
 	     * token
 	     */
-	    pn->u.str = str_new(pn->u.text, (long) pn->len);
+	    pn->u.str = str_pool(pn->u.text, (long) pn->len);
 	    sc_add(&ps->strc, pn->u.str);
 
 	    pn->symbol = PN_STRING;
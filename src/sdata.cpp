@@ -98,6 +98,8 @@ struct sarray {
 
 static char sa_layout[] = "iics";
 
+# define SA_FROZEN	0x40	/* in sarray.type: tag is frozen array id */
+
 struct sarray1 {
     Uint index;			/* index in array value table */
     char type;			/* array type */
@@ -133,11 +135,39 @@ struct scallout {
 
 static char sco_layout[] = "issu[ccui][ccui][ccui][ccui]";
 
+struct sfrozenhdr {
+    Uint narrays;		/* # frozen arrays */
+    Uint eltsize;		/* total size of frozen array elements */
+    Uint nstrings;		/* # strings in frozen arrays */
+    Uint strsize;		/* total size of strings */
+};
+
+static char sfh_layout[] = "iiii";
+
+struct sfrozen {
+    Uint id;			/* registry id */
+    Uint tag;			/* unique value for each array */
+    Uint ref;			/* refcount */
+    char type;			/* array type */
+    unsigned short size;	/* size of array */
+};
+
+static char sf_layout[] = "iiics";
+
+struct frzref {
+    Uint id;			/* frozen array id */
+    Uint idx;			/* index in saved arrays + 1, or 0 */
+};
+
+static frzref *frzmap;		/* frozen arrays in the image being updated */
+static Uint frzmapsz;		/* size of frzmap (power of two) */
+
 struct savedata {
     Uint narr;				/* # of arrays */
     Uint nstr;				/* # of strings */
     Uint arrsize;			/* # of array elements */
     Uint strsize;			/* total string size */
+    Uint nfrozen;			/* # frozen arrays */
     sarray *sarrays;			/* save arrays */
     svalue *selts;			/* save array elements */
     sstring *sstrings;			/* save strings */
@@ -145,29 +175,68 @@ struct savedata {
     Array alist;			/* linked list sentinel */
 };
 
+struct swapstat {
+    Uint count;				/* object creation count */
+    Uint swapins;			/* # times loaded from swap */
+    Uint swapouts;			/* # times swapped out */
+    Uint epoch;				/* swapout round of last swapout */
+    unsigned short reuse;		/* credit for being reused */
+    Uint datamem;			/* dataspace bytes at last swapout */
+    Uint dataswap;			/* dataspace bytes in swap */
+    Uint ctrlmem;			/* control block bytes at last swapout */
+    Uint ctrlswap;			/* control block bytes in swap */
+};
+
 static Control *chead, *ctail;		/* list of control blocks */
 static Dataspace *dhead, *dtail;	/* list of dataspace blocks */
 static Dataspace *gcdata;		/* next dataspace to garbage collect */
 static sector nctrl;			/* # control blocks */
 static sector ndata;			/* # dataspace blocks */
+static swapstat *swapstats;		/* swap statistics per object */
+static uindex nswapstats;		/* # objects with swap statistics */
+static Uint epoch;			/* # partial swapout rounds */
+static size_t budget;			/* memory budget, or 0 */
 static bool conv_14;			/* convert arrays & strings? */
 static bool converted;			/* conversion complete? */
 
 
 /*
  * NAME:	data->init()
- * DESCRIPTION:	initialize swapped data handling
+ * DESCRIPTION:	initialize swapped data handling, with an optional memory
+ *		budget in megabytes
  */
-void d_init()
+void d_init(uindex nobjects, Uint mbytes)
 {
     chead = ctail = (Control *) NULL;
     dhead = dtail = (Dataspace *) NULL;
     gcdata = (Dataspace *) NULL;
     nctrl = ndata = 0;
+    swapstats = ALLOC(swapstat, nswapstats = nobjects);
+    memset(swapstats, '\0', nobjects * sizeof(swapstat));
+    epoch = 0;
+    budget = (size_t) mbytes << 20;
     conv_14 = FALSE;
     converted = FALSE;
 }
 
+/*
+ * NAME:	data->grow()
+ * DESCRIPTION:	the object table has grown to n objects
+ */
+void d_grow(uindex n)
+{
+    swapstat *s;
+
+    m_static();
+    s = ALLOC(swapstat, n);
+    m_dynamic();
+    memcpy(s, swapstats, nswapstats * sizeof(swapstat));
+    memset(s + nswapstats, '\0', (n - nswapstats) * sizeof(swapstat));
+    FREE(swapstats);
+    swapstats = s;
+    nswapstats = n;
+}
+
 /*
  * NAME:	data->init_conv()
  * DESCRIPTION:	prepare for conversions
@@ -177,6 +246,184 @@ void d_init_conv(bool c14)
     conv_14 = c14;
 }
 
+/*
+ * NAME:	data->stat()
+ * DESCRIPTION:	get the swap statistics for an object
+ */
+static swapstat *d_stat(Object *obj)
+{
+    swapstat *s;
+
+    s = &swapstats[obj->index];
+    if (s->count != obj->count) {
+	/* object table slot was reused */
+	s->count = obj->count;
+	s->swapins = s->swapouts = 0;
+	s->epoch = 0;
+	s->reuse = 0;
+	s->datamem = s->dataswap = 0;
+	s->ctrlmem = s->ctrlswap = 0;
+    }
+    return s;
+}
+
+/*
+ * NAME:	data->swapin()
+ * DESCRIPTION:	account for a block loaded from swap, and return the credit
+ *		it gets against being swapped out again
+ */
+static unsigned short d_swapin(Object *obj)
+{
+    swapstat *s;
+
+    s = d_stat(obj);
+    s->swapins++;
+    if (s->swapouts != 0 && epoch - s->epoch < SWAPREUSE) {
+	/* swapped out too soon */
+	if (s->reuse < SWAPCREDIT) {
+	    s->reuse++;
+	}
+    } else {
+	s->reuse >>= 1;
+    }
+    return s->reuse;
+}
+
+/*
+ * NAME:	data->swapped()
+ * DESCRIPTION:	account for a block swapped out
+ */
+static swapstat *d_swapped(Object *obj, bool partial)
+{
+    swapstat *s;
+
+    s = d_stat(obj);
+    s->swapouts++;
+    s->epoch = (partial) ? epoch : epoch - SWAPREUSE;
+    return s;
+}
+
+/*
+ * NAME:	data->swapstat()
+ * DESCRIPTION:	return the swap statistics for an object
+ */
+void d_swapstat(Object *obj, Uint *swapins, Uint *swapouts)
+{
+    swapstat *s;
+
+    s = d_stat(obj);
+    *swapins = s->swapins;
+    *swapouts = s->swapouts;
+}
+
+/*
+ * NAME:	data->valmem()
+ * DESCRIPTION:	return the memory size of a dataspace and its values, from
+ *		its counts of variables, arrays and strings
+ */
+static Uint d_valmem(Uint nvariables, Uint narrays, Uint eltsize,
+		     Uint nstrings, Uint strsize)
+{
+    return sizeof(Dataspace) + nvariables * (Uint) sizeof(Value) +
+	   narrays * (Uint) (sizeof(Array) + sizeof(arrref)) +
+	   eltsize * (Uint) sizeof(Value) +
+	   nstrings * (Uint) (sizeof(String) + sizeof(strref)) + strsize;
+}
+
+/*
+ * NAME:	data->datamem()
+ * DESCRIPTION:	recompute the memory size of the values in a dataspace
+ */
+static void d_datamem(Dataspace *data)
+{
+    data->memsize = d_valmem(data->nvariables, data->narrays, data->eltsize,
+			     data->nstrings, data->strsize);
+}
+
+/*
+ * NAME:	data->datasize()
+ * DESCRIPTION:	return the memory size of a dataspace, including callouts
+ */
+static Uint d_datasize(Dataspace *data)
+{
+    return data->memsize + data->ncallouts * (Uint) sizeof(dcallout);
+}
+
+/*
+ * NAME:	data->arrmem()
+ * DESCRIPTION:	return the memory size that an array in the array table of
+ *		a dataspace is counted for
+ */
+long d_arrmem(Array *arr)
+{
+    Dataspace *data;
+
+    data = arr->primary->data;
+    return sizeof(Array) + sizeof(arrref) +
+	   data->sarrays[arr->primary - data->arrays].size *
+							(long) sizeof(Value);
+}
+
+/*
+ * NAME:	data->ctrlmem()
+ * DESCRIPTION:	return the memory size of a control block
+ */
+static Uint d_ctrlmem(Control *ctrl)
+{
+    Uint size;
+
+    size = sizeof(Control) + ctrl->ninherits * sizeof(dinherit) +
+	   ctrl->imapsz + ctrl->progsize +
+	   ctrl->nfuncdefs * sizeof(dfuncdef) +
+	   ctrl->nvardefs * sizeof(dvardef) + ctrl->nclassvars * 3 +
+	   ctrl->nfuncalls * 2 + ctrl->nsymbols * sizeof(dsymbol) +
+	   ctrl->nvariables +
+	   ctrl->vmapsize * sizeof(unsigned short);
+    size += ctrl->nstrings * (Uint) (sizeof(String) + sizeof(String*)) +
+	    ctrl->strsize;
+    return size;
+}
+
+/*
+ * NAME:	data->ctrlswap()
+ * DESCRIPTION:	return the size of a control block in swap, not counting
+ *		its sector table
+ */
+static Uint d_ctrlswap(scontrol *header)
+{
+    if (header->vmapsize != 0) {
+	return sizeof(scontrol) +
+	       header->vmapsize * (Uint) sizeof(unsigned short);
+    }
+    return sizeof(scontrol) +
+	   header->ninherits * (Uint) sizeof(sinherit) +
+	   header->imapsz +
+	   header->progsize +
+	   header->nstrings * (Uint) sizeof(ssizet) +
+	   header->strsize +
+	   UCHAR(header->nfuncdefs) * (Uint) sizeof(dfuncdef) +
+	   UCHAR(header->nvardefs) * (Uint) sizeof(dvardef) +
+	   UCHAR(header->nclassvars) * (Uint) 3 +
+	   header->nfuncalls * (Uint) 2 +
+	   header->nsymbols * (Uint) sizeof(dsymbol) +
+	   header->nvariables - UCHAR(header->nvardefs);
+}
+
+/*
+ * NAME:	data->dataswap()
+ * DESCRIPTION:	return the size of a dataspace in swap, not counting its
+ *		sector table
+ */
+static Uint d_dataswap(sdataspace *header)
+{
+    return sizeof(sdataspace) +
+	   (header->nvariables + header->eltsize) * (Uint) sizeof(svalue) +
+	   header->narrays * (Uint) sizeof(sarray) +
+	   header->nstrings * (Uint) sizeof(sstring) +
+	   header->strsize +
+	   header->ncallouts * (Uint) sizeof(scallout);
+}
+
 /*
  * NAME:	data->new_control()
  * DESCRIPTION:	create a new control block
@@ -198,6 +445,7 @@ Control *d_new_control()
 	chead = ctail = ctrl;
     }
     ctrl->ndata = 0;
+    ctrl->credit = 0;
     nctrl++;
 
     ctrl->flags = 0;
@@ -267,6 +515,8 @@ static Dataspace *d_alloc_dataspace(Object *obj)
     data->iprev = (Dataspace *) NULL;
     data->inext = (Dataspace *) NULL;
     data->flags = 0;
+    data->credit = 0;
+    data->memsize = 0;
 
     data->oindex = obj->index;
     data->ctrl = (Control *) NULL;
@@ -282,6 +532,7 @@ static Dataspace *d_alloc_dataspace(Object *obj)
 
     /* arrays */
     data->narrays = 0;
+    data->arrays = (arrref *) NULL;
     data->eltsize = 0;
     data->sarrays = (sarray *) NULL;
     data->saindex = (Uint *) NULL;
@@ -290,6 +541,7 @@ static Dataspace *d_alloc_dataspace(Object *obj)
 
     /* strings */
     data->nstrings = 0;
+    data->strings = (strref *) NULL;
     data->strsize = 0;
     data->sstrings = (sstring *) NULL;
     data->ssindex = (Uint *) NULL;
@@ -311,8 +563,8 @@ static Dataspace *d_alloc_dataspace(Object *obj)
     data->base.alocal.plane = &data->base;
     data->base.alocal.data = data;
     data->base.alocal.state = AR_CHANGED;
-    data->base.arrays = (arrref *) NULL;
-    data->base.strings = (strref *) NULL;
+    data->base.achunk = (abchunk *) NULL;
+    data->base.rchunk = (class rbchunk *) NULL;
     data->base.coptab = (class coptable *) NULL;
     data->base.prev = (Dataplane *) NULL;
     data->base.plist = (Dataplane *) NULL;
@@ -337,6 +589,7 @@ Dataspace *d_new_dataspace(Object *obj)
     data->ctrl = o_control(obj);
     data->ctrl->ndata++;
     data->nvariables = data->ctrl->nvariables + 1;
+    d_datamem(data);
 
     return data;
 }
@@ -447,6 +700,9 @@ static Control *load_control(Object *obj, void (*readv) (char*, sector*, Uint, U
     /* # variables */
     ctrl->vtypeoffset = size;
     ctrl->nvariables = header.nvariables;
+    size += header.nvariables - UCHAR(header.nvardefs);
+
+    d_stat(obj)->ctrlswap = d_ctrlswap(&header);
 
     return ctrl;
 }
@@ -457,7 +713,11 @@ static Control *load_control(Object *obj, void (*readv) (char*, sector*, Uint, U
  */
 Control *d_load_control(Object *obj)
 {
-    return load_control(obj, sw_readv);
+    Control *ctrl;
+
+    ctrl = load_control(obj, sw_readv);
+    ctrl->credit = d_swapin(obj);
+    return ctrl;
 }
 
 /*
@@ -511,6 +771,10 @@ static Dataspace *load_dataspace(Object *obj, void (*readv) (char*, sector*, Uin
     data->cooffset = size;
     data->ncallouts = header.ncallouts;
     data->fcallouts = header.fcallouts;
+    size += header.ncallouts * (Uint) sizeof(scallout);
+
+    d_datamem(data);
+    d_stat(obj)->dataswap = d_dataswap(&header);
 
     return data;
 }
@@ -524,6 +788,7 @@ Dataspace *d_load_dataspace(Object *obj)
     Dataspace *data;
 
     data = load_dataspace(obj, sw_readv);
+    data->credit = d_swapin(obj);
 
     if (!(obj->flags & O_MASTER) && obj->update != OBJ(obj->u_master)->update &&
 	obj->count != 0) {
@@ -1018,10 +1283,12 @@ static void get_strings(Dataspace *data, void (*readv) (char*, sector*, Uint, Ui
 	if (data->strsize > 0) {
 	    /* load strings text */
 	    if (data->flags & DATA_STRCMP) {
+		data->memsize -= data->strsize;
 		data->stext = decompress(data->sectors, readv, data->strsize,
 					 data->stroffset +
 					       data->nstrings * sizeof(sstring),
 					 &data->strsize);
+		data->memsize += data->strsize;
 	    } else {
 		data->stext = ALLOC(char, data->strsize);
 		(*readv)(data->stext, data->sectors, data->strsize,
@@ -1037,11 +1304,10 @@ static void get_strings(Dataspace *data, void (*readv) (char*, sector*, Uint, Ui
  */
 static String *d_get_string(Dataspace *data, Uint idx)
 {
-    if (data->plane->strings == (strref *) NULL ||
-	data->plane->strings[idx].str == (String *) NULL) {
+    if (data->strings == (strref *) NULL ||
+	data->strings[idx].str == (String *) NULL) {
 	String *str;
 	strref *s;
-	Dataplane *p;
 	Uint i;
 
 	if (data->sstrings == (sstring *) NULL) {
@@ -1060,27 +1326,24 @@ static String *d_get_string(Dataspace *data, Uint idx)
 	str = str_alloc(data->stext + data->ssindex[idx],
 			(long) data->sstrings[idx].len);
 	str->ref = 0;
-	p = data->plane;
 
-	do {
-	    if (p->strings == (strref *) NULL) {
-		/* initialize string pointers */
-		s = p->strings = ALLOC(strref, data->nstrings);
-		for (i = data->nstrings; i > 0; --i) {
-		    (s++)->str = (String *) NULL;
-		}
+	if (data->strings == (strref *) NULL) {
+	    /* initialize string pointers */
+	    s = data->strings = ALLOC(strref, data->nstrings);
+	    for (i = data->nstrings; i > 0; --i) {
+		s->str = (String *) NULL;
+		(s++)->level = 0;
 	    }
-	    s = &p->strings[idx];
-	    str_ref(s->str = str);
-	    s->data = data;
-	    s->ref = data->sstrings[idx].ref;
-	    p = p->prev;
-	} while (p != (Dataplane *) NULL);
+	}
+	s = &data->strings[idx];
+	str_ref(s->str = str);
+	s->data = data;
+	s->ref = data->sstrings[idx].ref;
 
-	str->primary = &data->plane->strings[idx];
+	str->primary = s;
 	return str;
     }
-    return data->plane->strings[idx].str;
+    return data->strings[idx].str;
 }
 
 /*
@@ -1103,48 +1366,50 @@ static void get_arrays(Dataspace *data, void (*readv) (char*, sector*, Uint, Uin
  */
 static Array *d_get_array(Dataspace *data, Uint idx)
 {
-    if (data->plane->arrays == (arrref *) NULL ||
-	data->plane->arrays[idx].arr == (Array *) NULL) {
+    if (data->arrays == (arrref *) NULL ||
+	data->arrays[idx].arr == (Array *) NULL) {
 	Array *arr;
 	arrref *a;
-	Dataplane *p;
 	Uint i;
 
 	if (data->sarrays == (sarray *) NULL) {
 	    /* load arrays */
 	    get_arrays(data, sw_readv);
 	}
+	if (data->sarrays[idx].type & SA_FROZEN) {
+	    int type;
+
+	    /* shared with other objects */
+	    return arr_frozen(data->sarrays[idx].tag, &type);
+	}
 
 	arr = arr_alloc(data->sarrays[idx].size);
 	arr->ref = 0;
 	arr->tag = data->sarrays[idx].tag;
-	p = data->plane;
 
-	do {
-	    if (p->arrays == (arrref *) NULL) {
-		/* create array pointers */
-		a = p->arrays = ALLOC(arrref, data->narrays);
-		for (i = data->narrays; i > 0; --i) {
-		    (a++)->arr = (Array *) NULL;
-		}
+	if (data->arrays == (arrref *) NULL) {
+	    /* create array pointers */
+	    a = data->arrays = ALLOC(arrref, data->narrays);
+	    for (i = data->narrays; i > 0; --i) {
+		a->arr = (Array *) NULL;
+		(a++)->level = 0;
 	    }
-	    a = &p->arrays[idx];
-	    arr_ref(a->arr = arr);
-	    a->plane = &data->base;
-	    a->data = data;
-	    a->state = AR_UNCHANGED;
-	    a->ref = data->sarrays[idx].ref;
-	    p = p->prev;
-	} while (p != (Dataplane *) NULL);
+	}
+	a = &data->arrays[idx];
+	arr_ref(a->arr = arr);
+	a->plane = &data->base;
+	a->data = data;
+	a->state = AR_UNCHANGED;
+	a->ref = data->sarrays[idx].ref;
 
-	arr->primary = &data->plane->arrays[idx];
+	arr->primary = a;
 	arr->prev = &data->alist;
 	arr->next = data->alist.next;
 	arr->next->prev = arr;
 	data->alist.next = arr;
 	return arr;
     }
-    return data->plane->arrays[idx].arr;
+    return data->arrays[idx].arr;
 }
 
 /*
@@ -1295,7 +1560,7 @@ Value *d_get_elts(Array *arr)
 	}
 
 	v = arr->elts = ALLOC(Value, arr->size);
-	idx = data->saindex[arr->primary - data->plane->arrays];
+	idx = data->saindex[arr->primary - data->arrays];
 	d_get_values(data, &data->selts[idx], v, arr->size);
     }
 
@@ -1484,6 +1749,7 @@ static void d_save_control(Control *ctrl)
     ctrl->nsectors = header.nsectors = d_swapalloc(size, ctrl->nsectors,
 						   &ctrl->sectors);
     OBJ(ctrl->oindex)->cfirst = ctrl->sectors[0];
+    d_stat(OBJ(ctrl->oindex))->ctrlswap = size;
 
     /*
      * Copy everything to the swap device.
@@ -1734,6 +2000,47 @@ static void d_save(savedata *save, svalue *sv, Value *v, unsigned short n)
     }
 }
 
+/*
+ * NAME:	data->frozen_index()
+ * DESCRIPTION:	find the index of a frozen array in the saved arrays, through
+ *		a table of the frozen arrays in the image that is built on
+ *		first use
+ */
+static Uint d_frozen_index(Dataspace *data, Array *arr)
+{
+    Uint id, idx, n;
+
+    if (frzmap == (frzref *) NULL) {
+	for (n = 0, idx = 0; idx < data->narrays; idx++) {
+	    if (data->sarrays[idx].type & SA_FROZEN) {
+		n++;
+	    }
+	}
+	for (frzmapsz = 4; frzmapsz < 2 * n; frzmapsz <<= 1) ;
+	frzmap = ALLOC(frzref, frzmapsz);
+	memset(frzmap, '\0', frzmapsz * sizeof(frzref));
+	for (idx = 0; idx < data->narrays; idx++) {
+	    if (data->sarrays[idx].type & SA_FROZEN) {
+		id = data->sarrays[idx].tag;
+		for (n = id & (frzmapsz - 1); frzmap[n].idx != 0;
+		     n = (n + 1) & (frzmapsz - 1)) ;
+		frzmap[n].id = id;
+		frzmap[n].idx = idx + 1;
+	    }
+	}
+    }
+
+    id = arr_frozen_id(arr);
+    for (n = id & (frzmapsz - 1); frzmap[n].idx != 0;
+	 n = (n + 1) & (frzmapsz - 1)) {
+	if (frzmap[n].id == id) {
+	    return frzmap[n].idx - 1;
+	}
+    }
+    fatal("frozen array missing from saved dataspace");
+    return 0;
+}
+
 /*
  * NAME:	data->put_values()
  * DESCRIPTION:	save modified values as svalues
@@ -1756,7 +2063,7 @@ static void d_put_values(Dataspace *data, svalue *sv, Value *v, unsigned short n
 
 	    case T_STRING:
 		sv->oindex = 0;
-		sv->u.string = v->u.string->primary - data->base.strings;
+		sv->u.string = v->u.string->primary - data->strings;
 		break;
 
 	    case T_FLOAT:
@@ -1769,7 +2076,11 @@ static void d_put_values(Dataspace *data, svalue *sv, Value *v, unsigned short n
 	    case T_MAPPING:
 	    case T_LWOBJECT:
 		sv->oindex = 0;
-		sv->u.array = v->u.array->primary - data->base.arrays;
+		if (v->u.array->frozen) {
+		    sv->u.array = d_frozen_index(data, v->u.array);
+		} else {
+		    sv->u.array = v->u.array->primary - data->arrays;
+		}
 		break;
 	    }
 	    v->modified = FALSE;
@@ -1830,32 +2141,32 @@ static void d_free_values(Dataspace *data)
     }
 
     /* free arrays */
-    if (data->base.arrays != (arrref *) NULL) {
+    if (data->arrays != (arrref *) NULL) {
 	arrref *a;
 
-	for (i = data->narrays, a = data->base.arrays; i > 0; --i, a++) {
+	for (i = data->narrays, a = data->arrays; i > 0; --i, a++) {
 	    if (a->arr != (Array *) NULL) {
 		arr_del(a->arr);
 	    }
 	}
 
-	FREE(data->base.arrays);
-	data->base.arrays = (arrref *) NULL;
+	FREE(data->arrays);
+	data->arrays = (arrref *) NULL;
     }
 
     /* free strings */
-    if (data->base.strings != (strref *) NULL) {
+    if (data->strings != (strref *) NULL) {
 	strref *s;
 
-	for (i = data->nstrings, s = data->base.strings; i > 0; --i, s++) {
+	for (i = data->nstrings, s = data->strings; i > 0; --i, s++) {
 	    if (s->str != (String *) NULL) {
 		s->str->primary = (strref *) NULL;
 		str_del(s->str);
 	    }
 	}
 
-	FREE(data->base.strings);
-	data->base.strings = (strref *) NULL;
+	FREE(data->strings);
+	data->strings = (strref *) NULL;
     }
 
     /* free any left-over arrays */
@@ -1914,7 +2225,7 @@ static bool d_save_dataspace(Dataspace *data, bool swap)
 	     * references to arrays changed
 	     */
 	    sa = data->sarrays;
-	    a = data->base.arrays;
+	    a = data->arrays;
 	    mod = FALSE;
 	    for (n = data->narrays; n > 0; --n) {
 		if (a->arr != (Array *) NULL && sa->ref != (a->ref & ~ARR_MOD))
@@ -1937,7 +2248,7 @@ static bool d_save_dataspace(Dataspace *data, bool swap)
 	    /*
 	     * array elements changed
 	     */
-	    a = data->base.arrays;
+	    a = data->arrays;
 	    for (n = 0; n < data->narrays; n++) {
 		if (a->arr != (Array *) NULL && (a->ref & ARR_MOD)) {
 		    a->ref &= ~ARR_MOD;
@@ -1963,7 +2274,7 @@ static bool d_save_dataspace(Dataspace *data, bool swap)
 	     * string references changed
 	     */
 	    ss = data->sstrings;
-	    s = data->base.strings;
+	    s = data->strings;
 	    mod = FALSE;
 	    for (n = data->nstrings; n > 0; --n) {
 		if (s->str != (String *) NULL && ss->ref != s->ref) {
@@ -2016,6 +2327,10 @@ static bool d_save_dataspace(Dataspace *data, bool swap)
 			  data->cooffset);
 	    }
 	}
+	if (frzmap != (frzref *) NULL) {
+	    FREE(frzmap);
+	    frzmap = (frzref *) NULL;
+	}
     } else {
 	savedata save;
 	char *text;
@@ -2032,6 +2347,7 @@ static bool d_save_dataspace(Dataspace *data, bool swap)
 	save.nstr = 0;
 	save.arrsize = 0;
 	save.strsize = 0;
+	save.nfrozen = 0;
 	save.alist.prev = save.alist.next = &save.alist;
 
 	d_get_variable(data, 0);
@@ -2080,8 +2396,16 @@ static bool d_save_dataspace(Dataspace *data, bool swap)
 	}
 
 	for (arr = save.alist.prev; arr != &save.alist; arr = arr->prev) {
-	    save.arrsize += arr->size;
-	    d_count(&save, d_get_elts(arr), arr->size);
+	    if (arr->frozen) {
+		save.nfrozen++;
+	    } else {
+		save.arrsize += arr->size;
+		d_count(&save, d_get_elts(arr), arr->size);
+	    }
+	}
+	if (data->flags & DATA_FROZEN) {
+	    /* release frozen arrays referenced by the previous image */
+	    d_unref_frozen(data);
 	}
 
 	/* fill in header */
@@ -2138,10 +2462,33 @@ static bool d_save_dataspace(Dataspace *data, bool swap)
 	}
 	for (arr = save.alist.prev, sarr = save.sarrays; arr != &save.alist;
 	     arr = arr->prev, sarr++) {
-	    sarr->size = arr->size;
-	    sarr->tag = arr->tag;
-	    d_save(&save, save.selts + save.arrsize, arr->elts, arr->size);
-	    save.arrsize += arr->size;
+	    if (arr->frozen) {
+		/* save a reference to the shared array */
+		sarr->type |= SA_FROZEN;
+		sarr->tag = arr_frozen_id(arr);
+		arr_ref(arr);
+	    } else {
+		sarr->size = arr->size;
+		sarr->tag = arr->tag;
+		d_save(&save, save.selts + save.arrsize, arr->elts, arr->size);
+		save.arrsize += arr->size;
+	    }
+	}
+	if (save.nfrozen != 0) {
+	    Array *next;
+
+	    /*
+	     * frozen arrays do not belong to this dataspace
+	     */
+	    for (arr = save.alist.next; arr != &save.alist; arr = next) {
+		next = arr->next;
+		if (arr->frozen) {
+		    arr->prev->next = next;
+		    next->prev = arr->prev;
+		    arr->prev = arr->next = arr;
+		}
+	    }
+	    header.flags |= DATA_FROZEN;
 	}
 	if (arr->next != &save.alist) {
 	    data->alist.next->prev = arr->prev;
@@ -2178,6 +2525,7 @@ static bool d_save_dataspace(Dataspace *data, bool swap)
 	    header.nsectors = d_swapalloc(size, data->nsectors, &data->sectors);
 	    data->nsectors = header.nsectors;
 	    OBJ(data->oindex)->dfirst = data->sectors[0];
+	    d_stat(OBJ(data->oindex))->dataswap = size;
 
 	    /* save header */
 	    size = sizeof(sdataspace);
@@ -2243,6 +2591,7 @@ static bool d_save_dataspace(Dataspace *data, bool swap)
 	data->eltsize = header.eltsize;
 	data->nstrings = header.nstrings;
 	data->strsize = save.strsize;
+	d_datamem(data);
 
 	data->base.schange = 0;
 	data->base.achange = 0;
@@ -2257,47 +2606,98 @@ static bool d_save_dataspace(Dataspace *data, bool swap)
 }
 
 
+/*
+ * NAME:	data->overbudget()
+ * DESCRIPTION:	check whether memory in use exceeds the budget
+ */
+static bool d_overbudget()
+{
+    allocinfo *info;
+
+    if (budget == 0) {
+	return FALSE;
+    }
+    info = m_info();
+    return (info->smemused + info->dmemused > budget);
+}
+
 /*
  * NAME:	data->swapout()
  * DESCRIPTION:	Swap out a portion of the control and dataspace blocks in
  *		memory.  Return the number of dataspace blocks swapped out.
+ *		When swapping out partially, blocks that were reloaded soon
+ *		after their last swapout get skipped a few times, and more
+ *		blocks are swapped out while memory exceeds the budget.
  */
 sector d_swapout(unsigned int frag)
 {
-    sector n, count;
+    sector n, scan, count;
     Dataspace *data;
     Control *ctrl;
+    bool partial;
 
     count = 0;
 
     if (frag != 0) {
+	partial = (frag != 1);
+	if (partial) {
+	    epoch++;
+	}
+
 	/* swap out dataspace blocks */
 	data = dtail;
-	for (n = ndata / frag, n -= (n > 0 && frag != 1); n > 0; --n) {
+	n = ndata / frag;
+	n -= (n > 0 && partial);
+	for (scan = ndata; scan > 0 && (n > 0 || (partial && d_overbudget()));
+	     --scan) {
 	    Dataspace *prev;
 
 	    prev = data->prev;
-	    if (d_save_dataspace(data, TRUE)) {
-		count++;
+	    if (partial && data->credit != 0) {
+		/* give it another round */
+		--data->credit;
+		d_ref_dataspace(data);
+	    } else {
+		if (d_save_dataspace(data, TRUE)) {
+		    count++;
+		}
+		d_swapped(OBJ(data->oindex), partial)->datamem =
+							d_datasize(data);
+		OBJ(data->oindex)->data = (Dataspace *) NULL;
+		d_free_dataspace(data);
+		if (n > 0) {
+		    --n;
+		}
 	    }
-	    OBJ(data->oindex)->data = (Dataspace *) NULL;
-	    d_free_dataspace(data);
 	    data = prev;
 	}
 
 	/* swap out control blocks */
 	ctrl = ctail;
-	for (n = nctrl / frag; n > 0; --n) {
+	n = nctrl / frag;
+	for (scan = nctrl; scan > 0 && (n > 0 || (partial && d_overbudget()));
+	     --scan) {
 	    Control *prev;
 
 	    prev = ctrl->prev;
-	    if (ctrl->ndata == 0) {
-		if (ctrl->sectors == (sector *) NULL ||
-		    (ctrl->flags & CTRL_VARMAP)) {
-		    d_save_control(ctrl);
+	    if (ctrl->ndata == 0 && partial && ctrl->credit != 0) {
+		/* give it another round */
+		--ctrl->credit;
+		d_ref_control(ctrl);
+	    } else {
+		if (ctrl->ndata == 0) {
+		    if (ctrl->sectors == (sector *) NULL ||
+			(ctrl->flags & CTRL_VARMAP)) {
+			d_save_control(ctrl);
+		    }
+		    d_swapped(OBJ(ctrl->oindex), partial)->ctrlmem =
+							    d_ctrlmem(ctrl);
+		    OBJ(ctrl->oindex)->ctrl = (Control *) NULL;
+		    d_free_control(ctrl);
+		}
+		if (n > 0) {
+		    --n;
 		}
-		OBJ(ctrl->oindex)->ctrl = (Control *) NULL;
-		d_free_control(ctrl);
 	    }
 	    ctrl = prev;
 	}
@@ -2364,6 +2764,77 @@ static Uint d_conv(char *m, sector *vec, const char *layout, Uint n, Uint idx,
     return bufsize;
 }
 
+/*
+ * NAME:	data->hdrstat()
+ * DESCRIPTION:	compute the sizes of an object that has not been copied
+ *		from the snapshot yet, from its headers there
+ */
+static void d_hdrstat(Object *obj, swapstat *s)
+{
+    if (O_HASDATA(obj) && s->dataswap == 0) {
+	sdataspace header;
+
+	d_conv((char *) &header, &obj->dfirst, sd_layout, (Uint) 1, (Uint) 0,
+	       sw_peek);
+	s->dataswap = d_dataswap(&header);
+	s->datamem = d_valmem(header.nvariables, header.narrays,
+			      header.eltsize, header.nstrings,
+			      header.strsize) +
+		     header.ncallouts * (Uint) sizeof(dcallout);
+    }
+    if ((obj->flags & O_MASTER) && obj->cfirst != SW_UNUSED &&
+	s->ctrlswap == 0) {
+	scontrol header;
+
+	d_conv((char *) &header, &obj->cfirst, sc_layout, (Uint) 1, (Uint) 0,
+	       sw_peek);
+	s->ctrlswap = d_ctrlswap(&header);
+	s->ctrlmem = sizeof(Control) + header.ninherits * sizeof(dinherit) +
+		     header.imapsz + header.progsize +
+		     UCHAR(header.nfuncdefs) * sizeof(dfuncdef) +
+		     UCHAR(header.nvardefs) * sizeof(dvardef) +
+		     UCHAR(header.nclassvars) * 3 + header.nfuncalls * 2 +
+		     header.nsymbols * sizeof(dsymbol) + header.nvariables +
+		     header.vmapsize * sizeof(unsigned short) +
+		     header.nstrings * (Uint) (sizeof(String) +
+					       sizeof(String*)) +
+		     header.strsize;
+    }
+}
+
+/*
+ * NAME:	data->memstat()
+ * DESCRIPTION:	return the number of bytes an object takes up in memory and
+ *		in swap, for its dataspace and, if it is a master object, its
+ *		control block; blocks not in memory report the size they had
+ *		when last swapped out, or for objects not yet copied from the
+ *		snapshot, the size computed from their headers there
+ */
+void d_memstat(Object *obj, Uint *datamem, Uint *ctrlmem, Uint *swap)
+{
+    swapstat *s;
+
+    s = d_stat(obj);
+    if (o_uncopied(obj)) {
+	d_hdrstat(obj, s);
+    }
+    if (obj->data != (Dataspace *) NULL) {
+	*datamem = d_datasize(obj->data);
+    } else {
+	*datamem = (O_HASDATA(obj)) ? s->datamem : 0;
+    }
+    *swap = (O_HASDATA(obj)) ? s->dataswap : 0;
+    if (obj->flags & O_MASTER) {
+	*ctrlmem = (obj->ctrl != (Control *) NULL) ?
+		    d_ctrlmem(obj->ctrl) : s->ctrlmem;
+	if (obj->cfirst != SW_UNUSED) {
+	    *swap += s->ctrlswap;
+	}
+    } else {
+	*ctrlmem = 0;
+    }
+}
+
 /*
  * NAME:	data->conv_control()
  * DESCRIPTION:	convert control block
@@ -2638,6 +3109,7 @@ static Dataspace *d_conv_dataspace(Object *obj, Uint *counttab,
     data->strsize = header.strsize;
     data->ncallouts = header.ncallouts;
     data->fcallouts = header.fcallouts;
+    data->flags = header.flags & DATA_FROZEN;
 
     /* sectors */
     data->sectors = ALLOC(sector, data->nsectors = header.nsectors);
@@ -2760,6 +3232,7 @@ Dataspace *d_restore_data(Object *obj, Uint *counttab,
 	    get_strings(data, readv);
 	    get_callouts(data, readv);
 	}
+	d_datamem(data);
 	obj->data = data;
 	if (counttab != (Uint *) NULL) {
 	    d_fixdata(data, counttab);
@@ -2836,6 +3309,249 @@ void d_converted()
     converted = TRUE;
 }
 
+/*
+ * NAME:	data->unref_frozen()
+ * DESCRIPTION:	release the frozen arrays referenced by a saved dataspace
+ */
+void d_unref_frozen(Dataspace *data)
+{
+    sarray *sa;
+    Uint n;
+    int type;
+
+    if (data->sarrays == (sarray *) NULL) {
+	get_arrays(data, sw_readv);
+    }
+    for (n = data->narrays, sa = data->sarrays; n != 0; --n, sa++) {
+	if (sa->type & SA_FROZEN) {
+	    arr_del(arr_frozen(sa->tag, &type));
+	}
+    }
+    data->flags &= ~DATA_FROZEN;
+}
+
+/*
+ * NAME:	data->dump_frozen()
+ * DESCRIPTION:	dump the frozen arrays, each of them only once
+ */
+bool d_dump_frozen(int fd)
+{
+    sfrozenhdr dh;
+    sfrozen *sf, *f;
+    svalue *selts, *sv;
+    sstring *sstrings;
+    char *stext;
+    Array *arr;
+    Value *v;
+    Uint id, n, i;
+    int type;
+    bool flag;
+
+    /*
+     * count arrays, elements and strings
+     */
+    str_merge();
+    dh.narrays = 0;
+    dh.eltsize = 0;
+    dh.nstrings = 0;
+    dh.strsize = 0;
+    for (id = 0; id < arr_nfrozen(); id++) {
+	arr = arr_frozen(id, &type);
+	if (arr != (Array *) NULL) {
+	    dh.narrays++;
+	    dh.eltsize += arr->size;
+	    for (n = arr->size, v = arr->elts; n != 0; --n, v++) {
+		if (v->type == T_STRING &&
+		    str_put(v->u.string, dh.nstrings) == dh.nstrings) {
+		    dh.nstrings++;
+		    dh.strsize += v->u.string->len;
+		}
+	    }
+	}
+    }
+    if (dh.narrays == 0) {
+	str_clear();
+	return sw_write(fd, &dh, sizeof(sfrozenhdr));
+    }
+
+    /*
+     * put everything in a saveable form
+     */
+    f = sf = ALLOC(sfrozen, dh.narrays);
+    sv = selts = (dh.eltsize != 0) ?
+		  ALLOC(svalue, dh.eltsize) : (svalue *) NULL;
+    sstrings = (dh.nstrings != 0) ?
+		ALLOC(sstring, dh.nstrings) : (sstring *) NULL;
+    stext = (dh.strsize != 0) ? ALLOC(char, dh.strsize) : (char *) NULL;
+    n = 0;
+    for (id = 0; id < arr_nfrozen(); id++) {
+	arr = arr_frozen(id, &type);
+	if (arr != (Array *) NULL) {
+	    f->id = id;
+	    f->tag = arr->tag;
+	    f->ref = arr->ref;
+	    f->type = type;
+	    f->size = arr->size;
+	    f++;
+
+	    for (i = arr->size, v = arr->elts; i != 0; --i, v++, sv++) {
+		sv->pad = '\0';
+		sv->oindex = 0;
+		switch (sv->type = v->type) {
+		case T_NIL:
+		    sv->u.number = 0;
+		    break;
+
+		case T_INT:
+		    sv->u.number = v->u.number;
+		    break;
+
+		case T_STRING:
+		    /* strings are met in the same order as when counting */
+		    sv->u.string = str_put(v->u.string, dh.nstrings);
+		    if (sv->u.string == n) {
+			sstrings[n].ref = 0;
+			sstrings[n++].len = v->u.string->len;
+			memcpy(stext, v->u.string->text, v->u.string->len);
+			stext += v->u.string->len;
+		    }
+		    sstrings[sv->u.string].ref++;
+		    break;
+
+		case T_FLOAT:
+		    sv->oindex = v->oindex;
+		    sv->u.objcnt = v->u.objcnt;
+		    break;
+
+		case T_ARRAY:
+		case T_MAPPING:
+		    sv->u.array = arr_frozen_id(v->u.array);
+		    break;
+		}
+	    }
+	}
+    }
+    str_clear();
+    stext -= dh.strsize;
+
+    flag = (sw_write(fd, &dh, sizeof(sfrozenhdr)) &&
+	    sw_write(fd, sf, dh.narrays * sizeof(sfrozen)) &&
+	    (dh.eltsize == 0 ||
+	     sw_write(fd, selts, dh.eltsize * sizeof(svalue))) &&
+	    (dh.nstrings == 0 ||
+	     sw_write(fd, sstrings, dh.nstrings * sizeof(sstring))) &&
+	    (dh.strsize == 0 || sw_write(fd, stext, dh.strsize)));
+
+    FREE(sf);
+    if (selts != (svalue *) NULL) {
+	FREE(selts);
+    }
+    if (sstrings != (sstring *) NULL) {
+	FREE(sstrings);
+    }
+    if (stext != (char *) NULL) {
+	FREE(stext);
+    }
+    return flag;
+}
+
+/*
+ * NAME:	data->restore_frozen()
+ * DESCRIPTION:	restore the frozen arrays from a snapshot
+ */
+void d_restore_frozen(int fd)
+{
+    sfrozenhdr dh;
+    sfrozen *sf, *f;
+    svalue *selts, *sv;
+    sstring *sstrings;
+    char *stext, *text;
+    String **strs;
+    Array *arr;
+    Value *v;
+    Uint n, i;
+    int type;
+
+    conf_dread(fd, (char *) &dh, sfh_layout, (Uint) 1);
+    if (dh.narrays == 0) {
+	return;
+    }
+    sf = ALLOC(sfrozen, dh.narrays);
+    conf_dread(fd, (char *) sf, sf_layout, dh.narrays);
+    selts = (svalue *) NULL;
+    if (dh.eltsize != 0) {
+	selts = ALLOC(svalue, dh.eltsize);
+	conf_dread(fd, (char *) selts, sv_layout, dh.eltsize);
+    }
+    strs = (String **) NULL;
+    if (dh.nstrings != 0) {
+	sstrings = ALLOC(sstring, dh.nstrings);
+	conf_dread(fd, (char *) sstrings, ss_layout, dh.nstrings);
+	stext = (char *) NULL;
+	if (dh.strsize != 0) {
+	    stext = ALLOC(char, dh.strsize);
+	    conf_dread(fd, stext, "c", dh.strsize);
+	}
+	strs = ALLOC(String*, dh.nstrings);
+	m_static();
+	for (n = 0, text = stext; n < dh.nstrings; n++) {
+	    str_ref(strs[n] = str_new(text, sstrings[n].len));
+	    text += sstrings[n].len;
+	}
+	m_dynamic();
+	if (stext != (char *) NULL) {
+	    FREE(stext);
+	}
+	FREE(sstrings);
+    }
+
+    /* create arrays, in increasing id order */
+    for (n = dh.narrays, f = sf; n != 0; --n, f++) {
+	arr = arr_frozen_restore(f->id, f->type, f->size);
+	arr->tag = f->tag;
+	arr->ref = f->ref;
+    }
+
+    /* fill in elements; references between arrays are already counted */
+    for (n = dh.narrays, f = sf, sv = selts; n != 0; --n, f++) {
+	arr = arr_frozen(f->id, &type);
+	for (i = arr->size, v = arr->elts; i != 0; --i, v++, sv++) {
+	    v->modified = FALSE;
+	    v->oindex = sv->oindex;
+	    switch (v->type = sv->type) {
+	    case T_NIL:
+	    case T_INT:
+		v->u.number = sv->u.number;
+		break;
+
+	    case T_STRING:
+		str_ref(v->u.string = strs[sv->u.string]);
+		break;
+
+	    case T_FLOAT:
+		v->u.objcnt = sv->u.objcnt;
+		break;
+
+	    case T_ARRAY:
+	    case T_MAPPING:
+		v->u.array = arr_frozen(sv->u.array, &type);
+		break;
+	    }
+	}
+    }
+
+    if (strs != (String **) NULL) {
+	for (n = dh.nstrings; n != 0; ) {
+	    str_del(strs[--n]);
+	}
+	FREE(strs);
+    }
+    if (selts != (svalue *) NULL) {
+	FREE(selts);
+    }
+    FREE(sf);
+}
+
 /*
  * NAME:	data->free_control()
  * DESCRIPTION:	remove the control block from memory
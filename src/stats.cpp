@@ -0,0 +1,331 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010-2017 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# define INCLUDE_FILE_IO
+# include "dgd.h"
+# include "str.h"
+# include "array.h"
+# include "object.h"
+# include "xfloat.h"
+# include "interpret.h"
+# include "data.h"
+# include "call_out.h"
+# include "comm.h"
+# include "swap.h"
+# include "stats.h"
+# include <stdarg.h>
+
+# define NBOUNDS	10		/* max # bucket bounds in a histogram */
+
+struct histogram {
+    const char *name;		/* metric name */
+    const char *help;		/* metric description */
+    double scale;		/* conversion to the unit of the metric */
+    int nbounds;		/* # bucket bounds */
+    Uuint bounds[NBOUNDS];	/* bucket upper bounds */
+    Uuint count[NBOUNDS + 1];	/* # observations per bucket */
+    Uuint sum;			/* sum of observations */
+};
+
+static histogram tasktime = {
+    "dgd_task_duration_seconds", "Time taken by tasks.", 1e-6,
+    10, { 100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000,
+	  5000000 },
+    { 0 }, 0
+};
+static histogram taskticks = {
+    "dgd_task_ticks", "Ticks used by tasks.", 1.0,
+    7, { 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 },
+    { 0 }, 0
+};
+static histogram taskdepth = {
+    "dgd_task_call_depth", "Maximum function call depth reached by tasks.",
+    1.0, 8, { 5, 10, 20, 50, 100, 200, 500, 1000 },
+    { 0 }, 0
+};
+static histogram taskstack = {
+    "dgd_task_stack_values",
+    "Maximum value stack size reached by tasks, in values.", 1.0,
+    6, { 100, 1000, 4096, 10000, 100000, 1000000 },
+    { 0 }, 0
+};
+static histogram colag = {
+    "dgd_callout_lag_seconds",
+    "Delay between the scheduled and the actual expiry of callouts.", 1e-3,
+    8, { 1, 10, 50, 100, 500, 1000, 5000, 10000 },
+    { 0 }, 0
+};
+
+static char *statfile;			/* statistics file, or NULL */
+static Uuint interval;			/* interval between writes */
+static Uuint next;			/* time of next write */
+static Uuint start;			/* start time of current task */
+static int outfd;			/* output file descriptor */
+static int outsize;			/* size of output buffer contents */
+static bool outerr;			/* write error */
+static char outbuf[4096];		/* output buffer */
+
+/*
+ * NAME:	stats->init()
+ * DESCRIPTION:	initialize statistics, written to file every interval
+ *		seconds
+ */
+void st_init(char *file, unsigned int secs)
+{
+    statfile = file;
+    interval = (Uuint) secs * 1000000;
+    next = start = P_utime();
+}
+
+/*
+ * NAME:	stats->start()
+ * DESCRIPTION:	a new task may start
+ */
+void st_start()
+{
+    if (statfile != (char *) NULL) {
+	start = P_utime();
+    }
+}
+
+/*
+ * NAME:	stats->observe()
+ * DESCRIPTION:	add observations to a histogram
+ */
+static void st_observe(histogram *h, Uuint value, unsigned int n)
+{
+    int i;
+
+    for (i = 0; i < h->nbounds && value > h->bounds[i]; i++) ;
+    h->count[i] += n;
+    h->sum += value * n;
+}
+
+/*
+ * NAME:	stats->task()
+ * DESCRIPTION:	a task has finished, having reached the given call depth and
+ *		value stack size
+ */
+void st_task(Uint ticks, Uint depth, Uint size)
+{
+    Uuint t;
+
+    if (statfile != (char *) NULL) {
+	t = P_utime();
+	st_observe(&tasktime, t - start, 1);
+	st_observe(&taskticks, ticks, 1);
+	st_observe(&taskdepth, depth, 1);
+	st_observe(&taskstack, size, 1);
+	start = t;
+    }
+}
+
+/*
+ * NAME:	stats->colag()
+ * DESCRIPTION:	n callouts expired, lag milliseconds late
+ */
+void st_colag(Uint lag, unsigned int n)
+{
+    if (statfile != (char *) NULL) {
+	st_observe(&colag, lag, n);
+    }
+}
+
+/*
+ * NAME:	stats->delay()
+ * DESCRIPTION:	limit the time to wait for input by the time of the next
+ *		statistics write
+ */
+Uint st_delay(Uint timeout, unsigned short *mtime)
+{
+    Uuint t;
+    Uint sec;
+    unsigned short msec;
+
+    if (statfile == (char *) NULL) {
+	return timeout;
+    }
+
+    t = P_utime();
+    if (t >= next) {
+	*mtime = 0;
+	return 0;
+    }
+    t = next - t + 999;
+    sec = (Uint) (t / 1000000);
+    msec = (unsigned short) (t % 1000000 / 1000);
+    if (*mtime == 0xffff || sec < timeout ||
+	(sec == timeout && msec < *mtime)) {
+	/* infinite or later */
+	*mtime = msec;
+	return sec;
+    }
+    return timeout;
+}
+
+/*
+ * NAME:	stats->flush()
+ * DESCRIPTION:	flush the output buffer
+ */
+static void st_flush()
+{
+    if (outsize != 0) {
+	if (P_write(outfd, outbuf, outsize) != outsize) {
+	    outerr = TRUE;
+	}
+	outsize = 0;
+    }
+}
+
+/*
+ * NAME:	stats->print()
+ * DESCRIPTION:	add a line to the output
+ */
+static void st_print(const char *format, ...)
+{
+    va_list args;
+
+    if (outsize > (int) sizeof(outbuf) - 256) {
+	st_flush();
+    }
+    va_start(args, format);
+    outsize += vsprintf(outbuf + outsize, format, args);
+    va_end(args);
+}
+
+/*
+ * NAME:	stats->metric()
+ * DESCRIPTION:	output a metric without labels
+ */
+static void st_metric(const char *name, const char *type, const char *help,
+		      double value)
+{
+    st_print("# HELP %s %s\012# TYPE %s %s\012%s %.15g\012", name, help,
+	     name, type, name, value);
+}
+
+/*
+ * NAME:	stats->histogram()
+ * DESCRIPTION:	output a histogram
+ */
+static void st_histogram(histogram *h)
+{
+    int i;
+    Uuint n;
+
+    st_print("# HELP %s %s\012# TYPE %s histogram\012", h->name, h->help,
+	     h->name);
+    for (i = 0, n = 0; i < h->nbounds; i++) {
+	n += h->count[i];
+	st_print("%s_bucket{le=\"%g\"} %.15g\012", h->name,
+		 h->bounds[i] * h->scale, (double) n);
+    }
+    n += h->count[i];
+    st_print("%s_bucket{le=\"+Inf\"} %.15g\012", h->name, (double) n);
+    st_print("%s_sum %.15g\012%s_count %.15g\012", h->name,
+	     h->sum * h->scale, h->name, (double) n);
+}
+
+/*
+ * NAME:	stats->write()
+ * DESCRIPTION:	write statistics to file, if it is time to do so
+ */
+void st_write()
+{
+    char buf1[STRINGSZ], buf2[STRINGSZ], tmp[STRINGSZ + 4], *p, *q;
+    Uuint t, reads, writes;
+    unsigned int secsize;
+    uindex ncoshort, ncolong;
+    int nconn, ndgram;
+    allocinfo *mstat;
+
+    if (statfile == (char *) NULL || (t=P_utime()) < next) {
+	return;
+    }
+    next = t + interval;
+
+    sprintf(tmp, "%s.tmp", statfile);
+    q = path_native(buf2, tmp);
+    outfd = P_open(q, O_CREAT | O_TRUNC | O_WRONLY | O_BINARY, 0644);
+    if (outfd < 0) {
+	return;
+    }
+    outerr = FALSE;
+
+    st_histogram(&tasktime);
+    st_histogram(&taskticks);
+    st_histogram(&taskdepth);
+    st_histogram(&taskstack);
+    st_histogram(&colag);
+
+    co_info(&ncoshort, &ncolong);
+    st_print("# HELP dgd_callouts Pending callouts.\012");
+    st_print("# TYPE dgd_callouts gauge\012");
+    st_print("dgd_callouts{term=\"short\"} %u\012", (unsigned int) ncoshort);
+    st_print("dgd_callouts{term=\"long\"} %u\012", (unsigned int) ncolong);
+
+    secsize = sw_iocount(&reads, &writes);
+    st_metric("dgd_swap_sectors", "gauge", "Swap sectors in use.",
+	      (double) sw_count());
+    st_metric("dgd_swap_reads_total", "counter",
+	      "Sectors read from the swap file or snapshot.", (double) reads);
+    st_metric("dgd_swap_read_bytes_total", "counter",
+	      "Bytes read from the swap file or snapshot.",
+	      (double) reads * secsize);
+    st_metric("dgd_swap_writes_total", "counter",
+	      "Sectors written to the swap file.", (double) writes);
+    st_metric("dgd_swap_written_bytes_total", "counter",
+	      "Bytes written to the swap file.", (double) writes * secsize);
+
+    mstat = m_info();
+    st_metric("dgd_memory_static_bytes", "gauge", "Static memory allocated.",
+	      (double) mstat->smemsize);
+    st_metric("dgd_memory_static_used_bytes", "gauge",
+	      "Static memory in use.", (double) mstat->smemused);
+    st_metric("dgd_memory_dynamic_bytes", "gauge",
+	      "Dynamic memory allocated.", (double) mstat->dmemsize);
+    st_metric("dgd_memory_dynamic_used_bytes", "gauge",
+	      "Dynamic memory in use.", (double) mstat->dmemused);
+
+    st_metric("dgd_objects", "gauge", "Objects in the object table.",
+	      (double) o_count());
+
+    comm_info(&nconn, &ndgram);
+    st_print("# HELP dgd_connections Open connections.\012");
+    st_print("# TYPE dgd_connections gauge\012");
+    st_print("dgd_connections{type=\"stream\"} %d\012", nconn - ndgram);
+    st_print("dgd_connections{type=\"datagram\"} %d\012", ndgram);
+
+    st_flush();
+    if (P_close(outfd) < 0) {
+	outerr = TRUE;
+    }
+    if (outerr) {
+	/* keep the previous statistics file rather than a truncated one */
+	P_unlink(q);
+	return;
+    }
+
+    /* replace the old statistics file */
+    p = path_native(buf1, statfile);
+    if (P_rename(q, p) < 0) {
+	P_unlink(p);
+	P_rename(q, p);
+    }
+}
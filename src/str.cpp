@@ -24,15 +24,20 @@
 # include "data.h"
 
 # define STR_CHUNK	128
+# define POOL_MAXLEN	32	/* longest string kept in the pool */
 
-struct strh : public Hashtab::Entry {
+struct strh {
+    strh *next;			/* next in hash table chain */
     String *str;		/* string entry */
+    Uint hash;			/* hash value of string */
     Uint index;			/* building index */
 };
 
 static Chunk<strh, STR_CHUNK> hchunk;
 
-static Hashtab *sht;		/* string merge table */
+static strh *sht[STRMERGETABSZ];/* string merge table */
+static String **pool;		/* pool of short strings */
+static unsigned int poolsz;	/* size of string pool (power of two) */
 
 
 /*
@@ -52,6 +57,9 @@ String *str_alloc(const char *text, long len)
     }
     s->text[s->len = len] = '\0';
     s->ref = 0;
+# ifndef NOSTRHASH
+    s->hash = 0;
+# endif
     s->primary = (strref *) NULL;
 
     return s;
@@ -81,13 +89,123 @@ void str_del(String *s)
     }
 }
 
+/*
+ * NAME:	String->hash()
+ * DESCRIPTION:	return the hash value of a string over the full text,
+ *		computing it only the first time unless NOSTRHASH is defined
+ */
+Uint str_hash(String *s)
+{
+# ifdef NOSTRHASH
+    return Hashtab::hashfull(s->text, s->len);
+# else
+    if (s->hash == 0) {
+	s->hash = Hashtab::hashfull(s->text, s->len);
+    }
+    return s->hash;
+# endif
+}
+
+/*
+ * NAME:	String->pool_init()
+ * DESCRIPTION:	initialize the pool of short strings
+ */
+void str_pool_init(unsigned int n)
+{
+    if (n != 0) {
+	for (poolsz = 1; poolsz < n; poolsz <<= 1) ;
+	m_static();
+	pool = ALLOC(String*, poolsz);
+	m_dynamic();
+	memset(pool, '\0', poolsz * sizeof(String*));
+    }
+}
+
+/*
+ * NAME:	String->pool()
+ * DESCRIPTION:	create a new string, sharing an identical short string from
+ *		the pool if there is one
+ */
+String *str_pool(const char *text, long len)
+{
+    String **slot, *str;
+    Uint hash;
+
+    if (poolsz == 0 || len > POOL_MAXLEN) {
+	return str_new(text, len);
+    }
+    hash = Hashtab::hashfull(text, len);
+    slot = &pool[hash & (poolsz - 1)];
+    str = *slot;
+    if (str != (String *) NULL && str->len == len &&
+	memcmp(str->text, text, len) == 0) {
+	return str;
+    }
+
+    /* replace the previous occupant of the slot */
+    if (str != (String *) NULL) {
+	str_del(str);
+    }
+    str_ref(*slot = str = str_alloc(text, len));
+# ifndef NOSTRHASH
+    str->hash = hash;
+# endif
+    return str;
+}
+
+/*
+ * NAME:	String->pooled()
+ * DESCRIPTION:	return the pooled string identical to the given one, adding
+ *		the given string to the pool if it is not owned by a dataspace
+ */
+String *str_pooled(String *str)
+{
+    String **slot;
+
+    if (poolsz == 0 || str->len > POOL_MAXLEN) {
+	return str;
+    }
+    slot = &pool[str_hash(str) & (poolsz - 1)];
+    if (*slot == str) {
+	return str;
+    }
+    if (*slot != (String *) NULL && (*slot)->len == str->len &&
+	memcmp((*slot)->text, str->text, str->len) == 0) {
+	return *slot;
+    }
+
+    if (str->primary == (strref *) NULL) {
+	if (*slot != (String *) NULL) {
+	    str_del(*slot);
+	}
+	str_ref(*slot = str);
+    }
+    return str;
+}
+
+/*
+ * NAME:	String->pool_clear()
+ * DESCRIPTION:	empty the pool of short strings
+ */
+void str_pool_clear()
+{
+    unsigned int i;
+
+    for (i = 0; i < poolsz; i++) {
+	if (pool[i] != (String *) NULL) {
+	    str_del(pool[i]);
+	    pool[i] = (String *) NULL;
+	}
+    }
+}
+
 /*
  * NAME:	String->merge()
  * DESCRIPTION:	prepare string merge
  */
 void str_merge()
 {
-    sht = Hashtab::create(STRMERGETABSZ, STRMERGEHASHSZ, FALSE);
+    memset(&sht, '\0', STRMERGETABSZ * sizeof(strh *));
 }
 
 /*
@@ -97,33 +215,26 @@ void str_merge()
 Uint str_put(String *str, Uint n)
 {
     strh **h;
+    Uint hash;
 
-    h = (strh **) sht->lookup(str->text, FALSE);
-    for (;;) {
-	/*
-	 * The hasher doesn't handle \0 in strings, and so may not have
-	 * found the proper string. Follow the hash table chain until
-	 * the end is reached, or until a match is found using str_cmp().
-	 */
-	if (*h == (strh *) NULL) {
-	    strh *s;
-
-	    /*
-	     * Not in the hash table. Make a new entry.
-	     */
-	    s = *h = hchunk.alloc();
-	    s->next = (Hashtab::Entry *) NULL;
-	    s->name = str->text;
-	    s->str = str;
-	    s->index = n;
-
-	    return n;
-	} else if (str_cmp(str, (*h)->str) == 0) {
+    hash = str_hash(str);
+    for (h = &sht[hash % STRMERGETABSZ]; *h != (strh *) NULL;
+	 h = &(*h)->next) {
+	if ((*h)->hash == hash && str_cmp(str, (*h)->str) == 0) {
 	    /* already in the hash table */
 	    return (*h)->index;
 	}
-	h = (strh **) &(*h)->next;
     }
+    /*
+     * Not in the hash table. Make a new entry.
+     */
+    *h = hchunk.alloc();
+    (*h)->next = (strh *) NULL;
+    (*h)->str = str;
+    (*h)->hash = hash;
+    (*h)->index = n;
+
+    return n;
 }
 
 /*
@@ -132,12 +243,7 @@ Uint str_put(String *str, Uint n)
  */
 void str_clear()
 {
-    if (sht != (Hashtab *) NULL) {
-	delete sht;
-
-	hchunk.clean();
-	sht = (Hashtab *) NULL;
-    }
+    hchunk.clean();
 }
 
 
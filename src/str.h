@@ -20,6 +20,9 @@
 struct String {
     struct strref *primary;	/* primary reference */
     Uint ref;			/* number of references + const bit */
+# ifndef NOSTRHASH
+    Uint hash;			/* cached hash value, 0 if not yet computed */
+# endif
     ssizet len;			/* string length */
     char text[1];		/* actual characters following this struct */
 };
@@ -28,6 +31,12 @@ extern String	       *str_alloc	(const char*, long);
 extern String	       *str_new		(const char*, long);
 # define str_ref(s)	((s)->ref++)
 extern void		str_del		(String*);
+extern Uint		str_hash	(String*);
+
+extern void		str_pool_init	(unsigned int);
+extern String	       *str_pool	(const char*, long);
+extern String	       *str_pooled	(String*);
+extern void		str_pool_clear	();
 
 extern void		str_merge	();
 extern Uint		str_put		(String*, Uint);
@@ -32,6 +32,8 @@ struct header {			/* swap slot header */
 static char *swapfile;			/* swap file name */
 static int swap;			/* swap file descriptor */
 static int dump, dump2;			/* snapshot descriptors */
+static char *dmap, *dmap2;		/* mapped snapshots */
+static size_t dmapsize, dmapsize2;	/* sizes of mapped snapshots */
 static char *mem;			/* swap slots in memory */
 static sector *map, *smap;		/* sector map, swap free map */
 static sector mfree, sfree;		/* free sector lists */
@@ -48,6 +50,7 @@ static sector nfree;			/* # free sectors */
 static sector ssectors;			/* sectors actually in swap file */
 static sector sbarrier;			/* swap sector barrier */
 static bool swapping;			/* currently using a swapfile? */
+static Uuint nreads, nwrites;		/* # sectors read and written */
 
 /*
  * NAME:	swap->init()
@@ -92,10 +95,67 @@ void sw_init(char *file, unsigned int total, unsigned int cache, unsigned int se
     first = (header *) NULL;
     last = (header *) NULL;
 
-    swap = dump = -1;
+    swap = dump = dump2 = -1;
+    dmap = dmap2 = (char *) NULL;
     swapping = TRUE;
 }
 
+/*
+ * NAME:	swap->map()
+ * DESCRIPTION:	map a snapshot into memory, if possible
+ */
+static char *sw_map(int fd, size_t *size, bool sequential)
+{
+    struct stat sbuf;
+    char *m;
+
+    *size = 0;
+    if (P_fstat(fd, &sbuf) < 0 || sbuf.st_size <= 0 ||
+	(off_t) (size_t) sbuf.st_size != sbuf.st_size) {
+	return (char *) NULL;
+    }
+    *size = (size_t) sbuf.st_size;
+    m = P_mmap(fd, *size);
+    if (m != (char *) NULL) {
+	P_madvise(m, *size, sequential);
+    }
+    return m;
+}
+
+/*
+ * NAME:	swap->unmap()
+ * DESCRIPTION:	remove a snapshot mapping
+ */
+static void sw_unmap(char **m, size_t size)
+{
+    if (*m != (char *) NULL) {
+	P_munmap(*m, size);
+	*m = (char *) NULL;
+    }
+}
+
+/*
+ * NAME:	swap->dread()
+ * DESCRIPTION:	read a sector from a snapshot, from the mapping if there is one
+ */
+static bool sw_dread(int fd, char *m, size_t msize, char *buf, sector sec,
+		     unsigned int secsize)
+{
+    off_t offset;
+
+    offset = (off_t) (sec + 1L) * secsize;
+    if (m != (char *) NULL) {
+	if ((size_t) offset >= msize) {
+	    return FALSE;
+	}
+	memcpy(buf, m + offset,
+	       (msize - offset < secsize) ? msize - offset : secsize);
+	return TRUE;
+    }
+    P_lseek(fd, offset, SEEK_SET);
+    return (P_read(fd, buf, secsize) > 0);
+}
+
 /*
  * NAME:	swap->finish()
  * DESCRIPTION:	clean up swapfile
@@ -109,6 +169,7 @@ void sw_finish()
 	P_unlink(path_native(buf, swapfile));
     }
     if (dump >= 0) {
+	sw_unmap(&dmap, dmapsize);
 	P_close(dump);
     }
 }
@@ -322,6 +383,7 @@ static header *sw_load(sector sec, bool restore, bool fill)
 		if (!sw_write(swap, h + 1, sectorsize)) {
 		    fatal("cannot write swap file");
 		}
+		nwrites++;
 	    }
 	    map[h->sec] = save;
 	}
@@ -338,10 +400,11 @@ static header *sw_load(sector sec, bool restore, bool fill)
 		/*
 		 * load the sector from the snapshot
 		 */
-		P_lseek(dump, (off_t) (load + 1L) * sectorsize, SEEK_SET);
-		if (P_read(dump, (char *) (h + 1), sectorsize) <= 0) {
+		if (!sw_dread(dump, dmap, dmapsize, (char *) (h + 1), load,
+			      sectorsize)) {
 		    fatal("cannot read snapshot");
 		}
+		nreads++;
 	    } else if (fill) {
 		/*
 		 * load the sector from the swap file
@@ -350,6 +413,7 @@ static header *sw_load(sector sec, bool restore, bool fill)
 		if (P_read(swap, (char *) (h + 1), sectorsize) <= 0) {
 		    fatal("cannot read swap file");
 		}
+		nreads++;
 	    }
 	} else if (fill) {
 	    /* zero-fill new sector */
@@ -461,8 +525,8 @@ void sw_conv(char *m, sector *vec, Uint size, Uint idx)
     do {
 	len = (size > restoresecsize - idx) ? restoresecsize - idx : size;
 	if (*vec != cached) {
-	    P_lseek(dump, (off_t) (map[*vec] + 1L) * restoresecsize, SEEK_SET);
-	    if (P_read(dump, cbuf, restoresecsize) <= 0) {
+	    if (!sw_dread(dump, dmap, dmapsize, cbuf, map[*vec],
+			  restoresecsize)) {
 		fatal("cannot read snapshot");
 	    }
 	    map[cached = *vec] = SW_UNUSED;
@@ -474,6 +538,37 @@ void sw_conv(char *m, sector *vec, Uint size, Uint idx)
     } while ((size -= len) > 0);
 }
 
+/*
+ * NAME:	swap->peek()
+ * DESCRIPTION:	read converted bytes from a vector of sectors in snapshot,
+ *		leaving them to be restored later
+ */
+void sw_peek(char *m, sector *vec, Uint size, Uint idx)
+{
+    char *buf;
+    unsigned int len;
+
+    buf = ALLOCA(char, restoresecsize);
+    vec += idx / restoresecsize;
+    idx %= restoresecsize;
+    do {
+	len = (size > restoresecsize - idx) ? restoresecsize - idx : size;
+	if (*vec == cached) {
+	    memcpy(m, cbuf + idx, len);
+	} else {
+	    if (!sw_dread(dump, dmap, dmapsize, buf, map[*vec],
+			  restoresecsize)) {
+		fatal("cannot read snapshot");
+	    }
+	    memcpy(m, buf + idx, len);
+	}
+	vec++;
+	idx = 0;
+	m += len;
+    } while ((size -= len) > 0);
+    AFREE(buf);
+}
+
 /*
  * NAME:	swap->conv2()
  * DESCRIPTION:	restore bytes from a vector of sectors in secondary snapshot
@@ -487,9 +582,8 @@ void sw_conv2(char *m, sector *vec, Uint size, Uint idx)
     do {
 	len = (size > restoresecsize - idx) ? restoresecsize - idx : size;
 	if (*vec != cached) {
-	    P_lseek(dump2, (off_t) (map[*vec] + 1L) * restoresecsize,
-		    SEEK_SET);
-	    if (P_read(dump2, cbuf, restoresecsize) <= 0) {
+	    if (!sw_dread(dump2, dmap2, dmapsize2, cbuf, map[*vec],
+			  restoresecsize)) {
 		fatal("cannot read secondary snapshot");
 	    }
 	    map[cached = *vec] = SW_UNUSED;
@@ -529,6 +623,18 @@ sector sw_count()
     return nsectors - nfree;
 }
 
+/*
+ * NAME:	swap->iocount()
+ * DESCRIPTION:	return the number of sectors read and written, and the
+ *		sector size
+ */
+unsigned int sw_iocount(Uuint *reads, Uuint *writes)
+{
+    *reads = nreads;
+    *writes = nwrites;
+    return sectorsize;
+}
+
 
 struct dump_header {
     Uint secsize;		/* size of swap sector */
@@ -587,6 +693,7 @@ int sw_dump(char *snapshot, bool keep)
     }
 
     if (dump >= 0 && !keep) {
+	sw_unmap(&dmap, dmapsize);
 	P_close(dump);
 	dump = -1;
     }
@@ -602,6 +709,8 @@ int sw_dump(char *snapshot, bool keep)
 	q = path_native(buf2, swapfile);
 	if (P_rename(q, p) < 0) {
 	    int old;
+	    char *m;
+	    size_t size;
 
 	    /*
 	     * The rename failed.  Attempt to copy the snapshot instead.
@@ -613,22 +722,32 @@ int sw_dump(char *snapshot, bool keep)
 	    if (old < 0 || swap < 0) {
 		fatal("cannot move swap file");
 	    }
-	    /* copy initial sector */
-	    if (P_read(old, cbuf, sectorsize) <= 0) {
-		fatal("cannot read swap file");
-	    }
-	    if (!sw_write(swap, cbuf, sectorsize)) {
-		fatal("cannot write snapshot");
-	    }
-	    /* copy swap sectors */
-	    for (n = ssectors; n > 0; --n) {
+	    m = sw_map(old, &size, TRUE);
+	    if (m != (char *) NULL &&
+		size >= (size_t) (ssectors + 1L) * sectorsize) {
+		/* copy initial sector and swap sectors from the mapping */
+		if (!sw_write(swap, m, (size_t) (ssectors + 1L) * sectorsize)) {
+		    fatal("cannot write snapshot");
+		}
+	    } else {
+		/* copy initial sector */
 		if (P_read(old, cbuf, sectorsize) <= 0) {
 		    fatal("cannot read swap file");
 		}
 		if (!sw_write(swap, cbuf, sectorsize)) {
 		    fatal("cannot write snapshot");
 		}
+		/* copy swap sectors */
+		for (n = ssectors; n > 0; --n) {
+		    if (P_read(old, cbuf, sectorsize) <= 0) {
+			fatal("cannot read swap file");
+		    }
+		    if (!sw_write(swap, cbuf, sectorsize)) {
+			fatal("cannot write snapshot");
+		    }
+		}
 	    }
+	    sw_unmap(&m, size);
 	    P_close(old);
 	} else {
 	    /*
@@ -712,6 +831,9 @@ void sw_dump2(char *header, int size, bool incr)
 	}
 	prev = sectors;
     }
+    if (P_fsync(swap) < 0) {
+	fatal("cannot sync snapshot");
+    }
 
     if (incr) {
 	/* incremental snapshot */
@@ -725,7 +847,9 @@ void sw_dump2(char *header, int size, bool incr)
 	swapping = FALSE;
     } else {
 	/* full snapshot */
+	sw_unmap(&dmap, dmapsize);
 	dump = swap;
+	dmap = sw_map(dump, &dmapsize, FALSE);
 	swap = -1;
 	sbarrier = ssectors = 0;
 	swapping = TRUE;
@@ -767,13 +891,25 @@ void sw_restore(int fd, unsigned int secsize)
     nfree = dh.nfree;
 
     dump = fd;
+    dmap = sw_map(dump, &dmapsize, TRUE);
+    if (dmap != (char *) NULL) {
+	/* read ahead of object reconstruction */
+	P_prefetch(dmap, dmapsize);
+    }
 }
 
 /*
  * NAME:	swap->restore2()
- * DESCRIPTION:	restore secondary snapshot
+ * DESCRIPTION:	restore secondary snapshot, or release it if fd is -1
  */
 void sw_restore2(int fd)
 {
+    sw_unmap(&dmap2, dmapsize2);
     dump2 = fd;
+    if (fd >= 0) {
+	dmap2 = sw_map(fd, &dmapsize2, TRUE);
+	if (dmap2 != (char *) NULL) {
+	    P_prefetch(dmap2, dmapsize2);
+	}
+    }
 }
@@ -28,9 +28,11 @@ extern void	sw_readv	(char*, sector*, Uint, Uint);
 extern void	sw_writev	(char*, sector*, Uint, Uint);
 extern void	sw_dreadv	(char*, sector*, Uint, Uint);
 extern void	sw_conv		(char*, sector*, Uint, Uint);
+extern void	sw_peek		(char*, sector*, Uint, Uint);
 extern void	sw_conv2	(char*, sector*, Uint, Uint);
 extern sector	sw_mapsize	(unsigned int);
 extern sector	sw_count	();
+extern unsigned int sw_iocount	(Uuint*, Uuint*);
 extern bool	sw_copy		(Uint);
 extern int	sw_dump		(char*, bool);
 extern void	sw_dump2	(char*, int, bool);
@@ -0,0 +1,158 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010-2017 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark for the arbitrary precision kernels in asn.cpp: the time per
+ * multiplication, squaring and modular exponentiation with an odd modulus,
+ * for operands of several sizes.  Built with -DKARATSUBA=2 -DNOUUUINT, it
+ * times the former kernels, which split down to single words and did the
+ * Montgomery products in 32 bit words.
+ */
+# include "asn.cpp"
+# include <time.h>
+
+# ifdef Uuuint
+# define MONTBITS	64
+# else
+# define MONTBITS	32
+# endif
+
+static Uuint seed;
+
+/*
+ * NAME:	error()
+ * DESCRIPTION:	stand-in for the driver's error(); the kernels do not fail
+ */
+void error(const char *format, ...)
+{
+    fprintf(stderr, "%s\n", format);
+    exit(1);
+}
+
+/*
+ * NAME:	str_new()
+ * DESCRIPTION:	stand-in for the driver's str_new(); not used by the kernels
+ */
+String *str_new(const char *text, long len)
+{
+    String *str;
+
+    str = (String *) malloc(sizeof(String) + len);
+    str->len = len;
+    if (text != (char *) NULL) {
+	memcpy(str->text, text, len);
+    }
+    str->text[len] = '\0';
+    return str;
+}
+
+/*
+ * NAME:	rnd()
+ * DESCRIPTION:	64 bit xorshift random number
+ */
+static Uint rnd()
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return (Uint) seed;
+}
+
+/*
+ * NAME:	now()
+ * DESCRIPTION:	current time in seconds
+ */
+static double now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * NAME:	main()
+ * DESCRIPTION:	asnbench
+ */
+int main()
+{
+    static Uint sizes[] = { 16, 32, 64, 128 };
+    Uint *a, *b, *c, *t, *mod, size, i;
+    unsigned int s;
+    long n;
+    double start, tmult, tsqr, tpow;
+
+    printf("Karatsuba from %d words, %d bit Montgomery words\n", KARATSUBA,
+	   MONTBITS);
+    seed = 12345;
+    for (s = 0; s < sizeof(sizes) / sizeof(Uint); s++) {
+	size = sizes[s];
+	a = ALLOCA(Uint, size);
+	b = ALLOCA(Uint, size);
+	mod = ALLOCA(Uint, size);
+	c = ALLOCA(Uint, size << 1);
+	t = ALLOCA(Uint, size << 2);
+	for (i = 0; i < size; i++) {
+	    a[i] = rnd();
+	    b[i] = rnd();
+	    mod[i] = rnd();
+	}
+	mod[0] |= 1;
+	mod[size - 1] |= 0x80000000L;
+	a[size - 1] &= 0x7fffffffL;
+
+	n = 0;
+	start = now();
+	do {
+	    for (i = 0; i < 100; i++) {
+		asi_mult(c, t, a, b, size, size);
+	    }
+	    n += i;
+	} while (now() - start < 0.5);
+	tmult = (now() - start) / n;
+
+	n = 0;
+	start = now();
+	do {
+	    for (i = 0; i < 100; i++) {
+		asi_sqr(c, t, a, size);
+	    }
+	    n += i;
+	} while (now() - start < 0.5);
+	tsqr = (now() - start) / n;
+
+	n = 0;
+	start = now();
+	do {
+	    asn_power(c, t, a, b, mod, size, size, size);
+	    n++;
+	} while (now() - start < 1.0);
+	tpow = (now() - start) / n;
+
+	printf("%5lu bits: mult %8.2f us  sqr %8.2f us  modexp %9.3f ms\n",
+	       (unsigned long) size << 5, tmult * 1e6, tsqr * 1e6, tpow * 1e3);
+
+	AFREE(t);
+	AFREE(c);
+	AFREE(mod);
+	AFREE(b);
+	AFREE(a);
+    }
+    return 0;
+}
@@ -0,0 +1,340 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010-2017 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Test for the arbitrary precision kernels in asn.cpp: products, squares
+ * and modular powers are compared with a plain schoolbook reference, for
+ * every operand size up to a limit, so that each even and uneven Karatsuba
+ * split is covered.  Usage: asntest [maxsize [seed]]
+ */
+# include "asn.cpp"
+# include <setjmp.h>
+
+# define GUARD		0x5a5a5a5aL
+
+static jmp_buf env;
+static Uuint seed;
+static unsigned long total;
+
+/*
+ * NAME:	error()
+ * DESCRIPTION:	stand-in for the driver's error(); unwind to the test
+ */
+void error(const char *format, ...)
+{
+    UNREFERENCED_PARAMETER(format);
+    longjmp(env, 1);
+}
+
+/*
+ * NAME:	str_new()
+ * DESCRIPTION:	stand-in for the driver's str_new(); not used by the kernels
+ */
+String *str_new(const char *text, long len)
+{
+    String *str;
+
+    str = (String *) malloc(sizeof(String) + len);
+    str->len = len;
+    if (text != (char *) NULL) {
+	memcpy(str->text, text, len);
+    }
+    str->text[len] = '\0';
+    return str;
+}
+
+/*
+ * NAME:	rnd()
+ * DESCRIPTION:	64 bit xorshift random number
+ */
+static Uuint rnd()
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+/*
+ * NAME:	fill()
+ * DESCRIPTION:	fill a number with random words, all ones, or random words
+ *		with long runs of zeros and ones; the top word is never zero
+ */
+static void fill(Uint *a, Uint size, int kind)
+{
+    Uint i;
+
+    for (i = 0; i < size; i++) {
+	switch (kind) {
+	case 0:
+	    a[i] = (Uint) rnd();
+	    break;
+
+	case 1:
+	    a[i] = 0xffffffffL;
+	    break;
+
+	default:
+	    a[i] = (rnd() & 1) ? (Uint) rnd() : (rnd() & 1) ? 0 : 0xffffffffL;
+	    break;
+	}
+    }
+    if (a[size - 1] == 0) {
+	a[size - 1] = 1;
+    }
+}
+
+/*
+ * NAME:	refmult()
+ * DESCRIPTION:	c = a * b, schoolbook
+ */
+static void refmult(Uint *c, Uint *a, Uint *b, Uint sizea, Uint sizeb)
+{
+    Uuint t;
+    Uint i, j, carry;
+
+    memset(c, '\0', (sizea + sizeb) * sizeof(Uint));
+    for (i = 0; i < sizeb; i++) {
+	carry = 0;
+	for (j = 0; j < sizea; j++) {
+	    t = (Uuint) a[j] * b[i] + c[i + j] + carry;
+	    c[i + j] = (Uint) t;
+	    carry = (Uint) (t >> 32);
+	}
+	c[i + sizea] = carry;
+    }
+}
+
+/*
+ * NAME:	refpower()
+ * DESCRIPTION:	c = a ** b % mod, square and multiply
+ */
+static void refpower(Uint *c, Uint *a, Uint *b, Uint *mod, Uint sizea, Uint sizeb, Uint sizemod)
+{
+    Uint *x, *y, *t;
+    Uint i;
+
+    x = ALLOCA(Uint, (sizemod << 1) + 1);
+    y = ALLOCA(Uint, sizemod);
+    t = ALLOCA(Uint, (sizemod << 1) + 1);
+
+    /* y = a % mod */
+    memset(x, '\0', (sizemod << 1) * sizeof(Uint));
+    memcpy(x, a, sizea * sizeof(Uint));
+    asi_div(x, t, x, mod, sizemod << 1, sizemod);
+    memcpy(y, x, sizemod * sizeof(Uint));
+
+    memset(c, '\0', sizemod * sizeof(Uint));
+    c[0] = 1;
+    for (i = sizeb << 5; i > 0; ) {
+	--i;
+	refmult(x, c, c, sizemod, sizemod);
+	asi_div(x, t, x, mod, sizemod << 1, sizemod);
+	memcpy(c, x, sizemod * sizeof(Uint));
+	if ((b[i >> 5] >> (i & 0x1f)) & 1) {
+	    refmult(x, c, y, sizemod, sizemod);
+	    asi_div(x, t, x, mod, sizemod << 1, sizemod);
+	    memcpy(c, x, sizemod * sizeof(Uint));
+	}
+    }
+    if (sizemod == 1 && mod[0] == 1) {
+	c[0] = 0;
+    }
+
+    AFREE(t);
+    AFREE(y);
+    AFREE(x);
+}
+
+/*
+ * NAME:	report()
+ * DESCRIPTION:	compare a result with the reference
+ */
+static bool report(const char *op, Uint *c, Uint *r, Uint size, Uint sizea, Uint sizeb, int kind)
+{
+    total++;
+    if (memcmp(c, r, size * sizeof(Uint)) != 0 || c[size] != GUARD) {
+	printf("%s %lu x %lu (kind %d): wrong result\n", op,
+	       (unsigned long) sizea, (unsigned long) sizeb, kind);
+	return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * NAME:	mult()
+ * DESCRIPTION:	check the product of sizea and sizeb words, sizea - sizeb <= 1
+ */
+static bool mult(Uint sizea, Uint sizeb, int kind)
+{
+    Uint *a, *b, *c, *r, *t;
+    bool ok;
+
+    a = ALLOCA(Uint, sizea);
+    b = ALLOCA(Uint, sizeb);
+    c = ALLOCA(Uint, sizea + sizeb + 1);
+    r = ALLOCA(Uint, sizea + sizeb);
+    t = ALLOCA(Uint, (sizea + sizeb) << 1);
+    fill(a, sizea, kind);
+    fill(b, sizeb, kind);
+    c[sizea + sizeb] = GUARD;
+
+    asi_mult(c, t, a, b, sizea, sizeb);
+    refmult(r, a, b, sizea, sizeb);
+    ok = report("mult", c, r, sizea + sizeb, sizea, sizeb, kind);
+
+    AFREE(t);
+    AFREE(r);
+    AFREE(c);
+    AFREE(b);
+    AFREE(a);
+    return ok;
+}
+
+/*
+ * NAME:	sqr()
+ * DESCRIPTION:	check the square of size words
+ */
+static bool sqr(Uint size, int kind)
+{
+    Uint *a, *c, *r, *t;
+    bool ok;
+
+    a = ALLOCA(Uint, size);
+    c = ALLOCA(Uint, (size << 1) + 1);
+    r = ALLOCA(Uint, size << 1);
+    t = ALLOCA(Uint, size << 2);
+    fill(a, size, kind);
+    c[size << 1] = GUARD;
+
+    asi_sqr(c, t, a, size);
+    refmult(r, a, a, size, size);
+    ok = report("sqr", c, r, size << 1, size, size, kind);
+
+    AFREE(t);
+    AFREE(r);
+    AFREE(c);
+    AFREE(a);
+    return ok;
+}
+
+/*
+ * NAME:	power()
+ * DESCRIPTION:	check a ** b % mod for an odd modulus, an even one, one with
+ *		a zero low word, and a power of two; a small exponent e
+ *		replaces b if not zero
+ */
+static bool power(Uint sizea, Uint sizeb, Uint sizemod, int kind, Uint e)
+{
+    Uint *a, *b, *c, *r, *t, *mod;
+    bool ok;
+
+    a = ALLOCA(Uint, sizea);
+    b = ALLOCA(Uint, sizeb);
+    mod = ALLOCA(Uint, sizemod);
+    c = ALLOCA(Uint, sizemod + 1);
+    r = ALLOCA(Uint, sizemod);
+    t = ALLOCA(Uint, sizemod << 2);
+    fill(a, sizea, 0);
+    fill(b, sizeb, 0);
+    if (e != 0) {
+	b[0] = e;
+	sizeb = 1;
+    }
+    fill(mod, sizemod, 0);
+    switch (kind) {
+    case 0:
+	mod[0] |= 1;
+	break;
+
+    case 1:
+	mod[0] &= ~1;
+	break;
+
+    case 2:
+	mod[0] = 0;
+	break;
+
+    default:
+	memset(mod, '\0', sizemod * sizeof(Uint));
+	mod[sizemod - 1] = 0x100;
+	break;
+    }
+    if (sizemod == 1 && mod[0] < 3) {
+	mod[0] = 3;
+    }
+    if (sizea == 1 && a[0] < 2) {
+	a[0] = 2;
+    }
+    c[sizemod] = GUARD;
+
+    asn_power(c, t, a, b, mod, sizea, sizeb, sizemod);
+    refpower(r, a, b, mod, sizea, sizeb, sizemod);
+    ok = report("power", c, r, sizemod, sizemod, sizeb, kind);
+
+    AFREE(t);
+    AFREE(r);
+    AFREE(c);
+    AFREE(mod);
+    AFREE(b);
+    AFREE(a);
+    return ok;
+}
+
+/*
+ * NAME:	main()
+ * DESCRIPTION:	asntest [maxsize [seed]]
+ */
+int main(int argc, char *argv[])
+{
+    Uint n, size, sizeb;
+    int kind, bad;
+
+    n = (argc > 1) ? atol(argv[1]) : 200;
+    seed = (argc > 2) ? strtoull(argv[2], (char **) NULL, 10) : 12345;
+    if (seed == 0) {
+	seed = 1;
+    }
+
+    bad = 0;
+    if (setjmp(env) != 0) {
+	printf("error in kernel\n");
+	return 1;
+    }
+    for (size = 1; size <= n && bad < 20; size++) {
+	for (kind = 0; kind < 3; kind++) {
+	    bad += !mult(size, size, kind);
+	    if (size > 1) {
+		bad += !mult(size, size - 1, kind);
+	    }
+	    bad += !sqr(size, kind);
+	}
+    }
+    for (size = 1; size <= n / 4 && bad < 20; size++) {
+	for (kind = 0; kind < 4; kind++) {
+	    sizeb = 1 + rnd() % size;
+	    bad += !power(1 + rnd() % size, sizeb, size, kind, 0);
+	    bad += !power(1 + rnd() % size, 1, size, kind, 1 + size % 3);
+	}
+    }
+
+    printf("%lu checks up to %lu words, %d mismatches\n", total,
+	   (unsigned long) n, bad);
+    return (bad != 0);
+}
@@ -0,0 +1,234 @@
+/*
+ * Object state for the atomic function stress test: arrays and strings
+ * that are shared within the object and with another object, a mapping,
+ * and callouts.
+ */
+
+# include <status.h>
+# include <type.h>
+
+# define SIZE	200
+
+mixed *arrs;
+string *strs;
+mapping map;
+mixed other;
+int seed;
+
+void init(int s)
+{
+    int i;
+
+    seed = s;
+    arrs = allocate(SIZE);
+    strs = allocate(SIZE);
+    map = ([ ]);
+    for (i = 0; i < SIZE; i++) {
+	arrs[i] = ({ i, "s" + i, ({ i * 2 }) });
+	strs[i] = "str" + i;
+	map["k" + i] = arrs[i];
+    }
+    for (i = 0; i < SIZE; i += 7) {
+	arrs[i] = arrs[(i * 13) % SIZE];
+    }
+}
+
+static int rnd(int n)
+{
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+    return (seed >> 8) % n;
+}
+
+mixed *get_arr(int i)
+{
+    return arrs[i];
+}
+
+void set_other(mixed value)
+{
+    other = value;
+}
+
+static void op(object peer)
+{
+    int i, j;
+    mixed *a;
+
+    i = rnd(SIZE);
+    j = rnd(SIZE);
+    switch (rnd(12)) {
+    case 0:
+	arrs[i] = arrs[j];
+	break;
+
+    case 1:
+	arrs[i] = ({ rnd(1000), strs[j], arrs[j] });
+	break;
+
+    case 2:
+	a = arrs[i];
+	if (sizeof(a) > 0) {
+	    a[0] = rnd(1000);
+	}
+	break;
+
+    case 3:
+	a = arrs[i];
+	if (sizeof(a) > 1) {
+	    a[1] = strs[j];
+	}
+	break;
+
+    case 4:
+	a = arrs[i];
+	if (sizeof(a) > 2) {
+	    a[2] = arrs[j];
+	}
+	break;
+
+    case 5:
+	map["k" + i] = arrs[j];
+	break;
+
+    case 6:
+	map["k" + i] = nil;
+	break;
+
+    case 7:
+	strs[i] = strs[j];
+	break;
+
+    case 8:
+	strs[i] = "n" + rnd(100000);
+	break;
+
+    case 9:
+	arrs[i] = nil;
+	break;
+
+    case 10:
+	other = peer->get_arr(j);
+	break;
+
+    case 11:
+	peer->set_other(arrs[j]);
+	break;
+    }
+}
+
+atomic void batch(object peer, int n, int fail)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+	op(peer);
+    }
+    if (fail) {
+	error("rollback");
+    }
+}
+
+atomic void nested(object peer, int depth)
+{
+    int i;
+
+    for (i = 0; i < 5; i++) {
+	op(peer);
+	switch (rnd(3)) {
+	case 0:
+	    catch(batch(peer, 10, 1));
+	    break;
+
+	case 1:
+	    catch(batch(peer, 10, 0));
+	    break;
+
+	case 2:
+	    if (depth > 0) {
+		catch(nested(peer, depth - 1));
+	    }
+	    break;
+	}
+    }
+    if (rnd(4) == 0) {
+	error("nested rollback");
+    }
+}
+
+static void fire(int x)
+{
+}
+
+atomic void callouts(int fail)
+{
+    int handle;
+
+    handle = call_out("fire", 100 + rnd(100), rnd(10));
+    if (rnd(2) && handle != 0) {
+	remove_call_out(handle - rnd(3));
+    }
+    if (fail) {
+	error("callout rollback");
+    }
+}
+
+static string serialize(mixed value, mapping seen)
+{
+    int i;
+    string str;
+    mixed *indices;
+
+    switch (typeof(value)) {
+    case T_ARRAY:
+	if (seen[value]) {
+	    return "@" + seen[value];
+	}
+	seen[value] = map_sizeof(seen) + 1;
+	str = "(";
+	for (i = 0; i < sizeof(value); i++) {
+	    str += serialize(value[i], seen) + ",";
+	}
+	return str + ")";
+
+    case T_MAPPING:
+	indices = map_indices(value);
+	str = "[";
+	for (i = 0; i < sizeof(indices); i++) {
+	    str += serialize(indices[i], seen) + ":" +
+		   serialize(value[indices[i]], seen) + ",";
+	}
+	return str + "]";
+
+    case T_STRING:
+	return "\"" + value + "\"";
+
+    case T_NIL:
+	return "nil";
+
+    default:
+	return "" + value;
+    }
+}
+
+static mixed *callout_state()
+{
+    mixed **callouts;
+    int i;
+
+    /* the delay depends on the time of day */
+    callouts = status(this_object())[O_CALLOUTS];
+    for (i = 0; i < sizeof(callouts); i++) {
+	callouts[i][2] = 0;
+    }
+    return callouts;
+}
+
+string state()
+{
+    mapping seen;
+
+    seen = ([ ]);
+    return serialize(arrs, seen) + serialize(strs, seen) +
+	   serialize(map, seen) + serialize(other, seen) +
+	   serialize(callout_state(), ([ ]));
+}
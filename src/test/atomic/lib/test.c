@@ -0,0 +1,66 @@
+/*
+ * Run random operations in nested atomic functions on two objects which
+ * share arrays and strings, and report a digest of their state after every
+ * phase.  An object is swapped out between phases.
+ */
+
+# define PHASES		8
+# define ROUNDS		40
+
+object a, b;
+int phase;
+
+static string hex(string str)
+{
+    int i;
+    string result;
+
+    result = "";
+    for (i = 0; i < strlen(str); i++) {
+	result += "0123456789abcdef"[str[i] >> 4 .. str[i] >> 4] +
+		  "0123456789abcdef"[str[i] & 15 .. str[i] & 15];
+    }
+    return result;
+}
+
+static void step()
+{
+    int i;
+    string sa, sb;
+
+    for (i = 0; i < ROUNDS; i++) {
+	catch(a->nested(b, 4));
+	catch(b->nested(a, 3));
+	catch(a->batch(b, 20, i & 1));
+	catch(b->batch(a, 20, (i >> 1) & 1));
+	catch(a->callouts(i % 3 == 0));
+	catch(b->callouts(i % 4 == 0));
+    }
+
+    sa = a->state();
+    sb = b->state();
+    find_object("/driver")->out("phase " + phase + " " +
+				hex(hash_string("MD5", sa)) + " " +
+				hex(hash_string("MD5", sb)) + " " +
+				strlen(sa) + " " + strlen(sb) + "\n");
+    if (++phase < PHASES) {
+	swapout();
+	call_out("step", 0);
+    } else {
+	shutdown();
+    }
+}
+
+string run()
+{
+    object obj;
+
+    obj = compile_object("/atm");
+    a = clone_object(obj);
+    b = clone_object(obj);
+    a->init(17);
+    b->init(4711);
+    swapout();
+    call_out("step", 0);
+    return "start";
+}
@@ -0,0 +1,239 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010-2017 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Differential test for the FPU path in simfloat.cpp: every operation is
+ * done both by the software emulation and by Float::add() and friends, and
+ * the results, including range errors, must be bit-for-bit identical.
+ */
+# include "simfloat.cpp"
+# include <setjmp.h>
+
+static jmp_buf env;
+static Uuint seed;
+static unsigned long total, native;
+
+/*
+ * NAME:	error()
+ * DESCRIPTION:	stand-in for the driver's error(); unwind to the test
+ */
+void error(const char *format, ...)
+{
+    UNREFERENCED_PARAMETER(format);
+    longjmp(env, 1);
+}
+
+/*
+ * NAME:	rnd()
+ * DESCRIPTION:	64 bit xorshift random number
+ */
+static Uuint rnd()
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+/*
+ * NAME:	mkfloat()
+ * DESCRIPTION:	construct a Float from sign, exponent and mantissa
+ */
+static Float mkfloat(bool neg, int exp, Uuint mant)
+{
+    Float f;
+
+    f.high = ((neg) ? 0x8000 : 0) | (exp << 4) | ((mant >> 32) & 0xf);
+    f.low = (Uint) mant;
+    return f;
+}
+
+/*
+ * NAME:	randfloat()
+ * DESCRIPTION:	random Float, biased towards edge cases: zero, all-ones and
+ *		sparse mantissas, and exponents close to the limits
+ */
+static Float randfloat()
+{
+    Uuint r, mant;
+    int exp;
+
+    r = rnd();
+    if (((r >> 24) & 63) == 0) {
+	return mkfloat(FALSE, 0, 0);
+    }
+    switch (r & 15) {
+    case 0:
+	mant = 0;
+	break;
+
+    case 1:
+	mant = ~(Uuint) 0;
+	break;
+
+    case 2:
+	mant = rnd() | 0xfffffff000LL;
+	break;
+
+    case 3:
+	mant = rnd() & 0xff0000000fLL;
+	break;
+
+    default:
+	mant = rnd();
+	break;
+    }
+    switch ((r >> 8) & 7) {
+    case 0:
+	exp = 1 + rnd() % 2046;
+	break;
+
+    case 1:
+	exp = (rnd() & 1) ? 1 + rnd() % 70 : 2046 - rnd() % 70;
+	break;
+
+    default:
+	exp = 1023 + (int) (rnd() % 60) - 30;
+	break;
+    }
+    return mkfloat((r >> 20) & 1, exp, mant);
+}
+
+/*
+ * NAME:	nearfloat()
+ * DESCRIPTION:	random Float close to the given one in magnitude, to
+ *		exercise cancellation and rounding in addition
+ */
+static Float nearfloat(Float *f)
+{
+    Uuint mant;
+    int exp, d;
+
+    exp = (f->high >> 4) & 0x7ff;
+    if (exp == 0) {
+	return randfloat();
+    }
+    d = (int) (rnd() % 64) - 8;
+    if (d > 0 && (exp -= d) < 1) {
+	exp = 1;
+    }
+    mant = ((Uuint) (f->high & 0xf) << 32) | f->low;
+    mant += (Int) (rnd() % 7) - 3;
+    if (rnd() & 1) {
+	mant = rnd();
+    }
+    return mkfloat(rnd() & 1, exp, mant);
+}
+
+/*
+ * NAME:	check()
+ * DESCRIPTION:	compare emulated and FPU results for one operation
+ */
+static bool check(Float *f1, Float *f2, int op)
+{
+    static void (*emu[])(flt*, flt*) = { f_add, f_sub, f_mult, f_div };
+    Float r1, r2, t;
+    flt a, b;
+    bool e1, e2, fpu;
+
+    r1 = *f1;
+    if (setjmp(env) == 0) {
+	f_xftof(&r1, &a);
+	f_xftof(f2, &b);
+	(*emu[op])(&a, &b);
+	f_ftoxf(&a, &r1);
+	e1 = FALSE;
+    } else {
+	e1 = TRUE;
+    }
+
+    r2 = *f1;
+    t = *f1;
+    fpu = FALSE;
+    if (setjmp(env) == 0) {
+	switch (op) {
+	case 0:
+	    fpu = d_add(&t, f2, FALSE);
+	    r2.add(*f2);
+	    break;
+
+	case 1:
+	    fpu = d_add(&t, f2, TRUE);
+	    r2.sub(*f2);
+	    break;
+
+	case 2:
+	    fpu = d_mult(&t, f2);
+	    r2.mult(*f2);
+	    break;
+
+	case 3:
+	    fpu = d_div(&t, f2);
+	    r2.div(*f2);
+	    break;
+	}
+	e2 = FALSE;
+    } else {
+	e2 = TRUE;
+    }
+
+    total++;
+    if (fpu) {
+	native++;
+    }
+    if (e1 != e2 || (!e1 && (r1.high != r2.high || r1.low != r2.low))) {
+	printf("mismatch op %d: %04x %08lx, %04x %08lx -> emu %d %04x %08lx, fpu %d %04x %08lx\n",
+	       op, f1->high, (unsigned long) f1->low, f2->high,
+	       (unsigned long) f2->low, e1, r1.high, (unsigned long) r1.low,
+	       e2, r2.high, (unsigned long) r2.low);
+	return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * NAME:	main()
+ * DESCRIPTION:	flttest [iterations [seed]]
+ */
+int main(int argc, char *argv[])
+{
+    Float f1, f2;
+    long i, n;
+    int op, bad;
+
+    n = (argc > 1) ? atol(argv[1]) : 1000000;
+    seed = (argc > 2) ? strtoull(argv[2], (char **) NULL, 10) : 12345;
+    if (seed == 0) {
+	seed = 1;
+    }
+
+    bad = 0;
+    for (i = 0; i < n && bad < 20; i++) {
+	f1 = randfloat();
+	f2 = (i & 1) ? nearfloat(&f1) : randfloat();
+	for (op = 0; op < 4; op++) {
+	    if (!check(&f1, &f2, op)) {
+		bad++;
+	    }
+	}
+    }
+
+    printf("%lu checks, %lu on the FPU, %d mismatches\n", total, native, bad);
+    return (bad != 0);
+}
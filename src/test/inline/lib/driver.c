@@ -0,0 +1,36 @@
+/*
+ * driver object for the inlining regression test
+ */
+
+static void initialize()
+{
+    send_message(compile_object("/test")->run() + "\n");
+}
+
+void out(string str)
+{
+    send_message(str);
+}
+
+string include_file(string from, string path)
+{
+    return (path[0] == '/') ? path : "/include/" + path;
+}
+
+static void compile_error(string file, int line, string err)
+{
+    send_message(file + ", " + line + ": " + err + "\n");
+}
+
+static void runtime_error(string err, int caught, int ticks)
+{
+    if (!caught) {
+	send_message("error: " + err + "\n");
+	shutdown();
+    }
+}
+
+static string atomic_error(string err, int atom, int ticks)
+{
+    return err;
+}
@@ -0,0 +1,37 @@
+/*
+ * Constant string arguments substituted into inlined functions: indexing
+ * them must fold to the character, not to the offset.
+ */
+
+private int first(string str)
+{
+    return str[0];
+}
+
+private int second(string str)
+{
+    return str[1];
+}
+
+private int last(string str)
+{
+    return str[strlen(str) - 1];
+}
+
+private int nth(string str, int i)
+{
+    return str[i];
+}
+
+string run()
+{
+    string result;
+
+    result = first("A") + " " + second("AB") + " " + last("xyz") + " " +
+	     nth("abc", 2) + " " + first("\377") + " " + second("a\200");
+    if (catch(nth("abc", 3)) == nil) {
+	result += " no error";
+    }
+    shutdown();
+    return result;
+}
@@ -0,0 +1,72 @@
+#!/bin/sh
+#
+# This file is part of DGD, https://github.com/dworkin/dgd
+# Copyright (C) 1993-2010 Dworkin B.V.
+# Copyright (C) 2010-2017 DGD Authors (see the commit log for details)
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as
+# published by the Free Software Foundation, either version 3 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Regression test for inlined functions.  Usage: run.sh driver
+#
+# The results are compared with those in inline.out.
+#
+DIR=`cd \`dirname $0\` && pwd`
+STATE=`mktemp -d`
+trap 'rm -rf $STATE' 0
+
+run()
+{
+    rm -rf $STATE/lib $STATE/swap $STATE/snapshot*
+    cp -r $DIR/lib $STATE/lib
+    mkdir $STATE/lib/include
+    touch $STATE/lib/include/std.h $STATE/lib/auto.c
+    cat > $STATE/inline.dgd <<EOC
+telnet_port	= ${PORT:-16092};
+binary_port	= `expr ${PORT:-16092} + 1`;
+directory	= "$STATE/lib";
+users		= 10;
+editors		= 0;
+ed_tmpfile	= "$STATE/ed";
+swap_file	= "$STATE/swap";
+swap_size	= 16384;
+sector_size	= 512;
+swap_fragment	= 32;
+static_chunk	= 64512;
+dynamic_chunk	= 261120;
+dump_file	= "$STATE/snapshot";
+dump_interval	= 3600;
+typechecking	= 2;
+include_file	= "/include/std.h";
+include_dirs	= ({ "/include" });
+auto_object	= "/auto";
+driver_object	= "/driver";
+create		= "create";
+array_size	= 10000;
+objects		= 100;
+call_outs	= 1000;
+EOC
+    $1 $STATE/inline.dgd 2>&1 | grep -v "^\[.*\] "
+}
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 driver" >&2
+    exit 2
+fi
+run $1 > $STATE/out
+if diff $DIR/inline.out $STATE/out; then
+    echo "inline: ok"
+else
+    echo "inline: results differ"
+    exit 1
+fi
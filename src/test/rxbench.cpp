@@ -0,0 +1,166 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010-2017 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark for the editor's regular expression matcher: the time per line
+ * for a set of typical patterns on generated text, and the time per try for
+ * patterns that take exponential time when matched by backtracking.
+ */
+# include "../ed/regexp.cpp"
+# include <time.h>
+
+# define NLINES		20000
+# define LINESZ		81
+# define ROUNDS		20
+
+/*
+ * NAME:	m_alloc()
+ * DESCRIPTION:	stand-in for the driver's memory manager
+ */
+# ifdef DEBUG
+char *m_alloc(size_t size, const char *file, int line)
+{
+    UNREFERENCED_PARAMETER(file);
+    UNREFERENCED_PARAMETER(line);
+    return (char *) malloc(size);
+}
+# else
+char *m_alloc(size_t size)
+{
+    return (char *) malloc(size);
+}
+# endif
+
+/*
+ * NAME:	m_free()
+ * DESCRIPTION:	stand-in for the driver's memory manager
+ */
+void m_free(char *mem)
+{
+    free(mem);
+}
+
+void m_static()		{ }
+void m_dynamic()	{ }
+
+static const char *words[] = {
+    "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog",
+    "running", "string", "object", "return", "int", "void"
+};
+
+static struct {
+    const char *pattern;	/* regular expression */
+    bool ic;			/* ignore case */
+    bool backtrack;		/* pathological for backtracking */
+} tests[] = {
+    { "the",				FALSE,	FALSE },
+    { "[a-z]*ing",			FALSE,	FALSE },
+    { "zebra",				FALSE,	FALSE },
+    { "Zebra",				TRUE,	FALSE },
+    { "\\<[a-z]*ing\\>",		FALSE,	FALSE },
+    { "o.*x.*z",			FALSE,	FALSE },
+    { "\\(q[a-z]*\\) \\(b[a-z]*\\)",	FALSE,	FALSE },
+    { "a*a*a*a*a*a*b",			FALSE,	TRUE },
+    { "^\\(a*\\)a*a*a*a*c",		FALSE,	TRUE },
+};
+
+static char lines[NLINES][LINESZ];
+static Uint seed;
+
+/*
+ * NAME:	rnd()
+ * DESCRIPTION:	deterministic random number
+ */
+static Uint rnd()
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+/*
+ * NAME:	now()
+ * DESCRIPTION:	current time in seconds
+ */
+static double now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * NAME:	main()
+ * DESCRIPTION:	rxbench [pattern]
+ */
+int main(int argc, char *argv[])
+{
+    rxbuf *rx;
+    char aline[LINESZ];
+    const char *err;
+    double start, time;
+    long n, matches;
+    unsigned int i, j, r;
+
+    seed = 3;
+    for (i = 0; i < NLINES; i++) {
+	while (strlen(lines[i]) < LINESZ - 11) {
+	    strcat(lines[i], words[rnd() % (sizeof(words) / sizeof(char *))]);
+	    strcat(lines[i], " ");
+	}
+    }
+    memset(aline, 'a', 60);
+    aline[60] = '\0';
+
+    rx = rx_new();
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+	if (argc > 1 && strcmp(argv[1], tests[i].pattern) != 0) {
+	    continue;
+	}
+	err = rx_comp(rx, tests[i].pattern);
+	if (err != (char *) NULL) {
+	    printf("%-28s %s\n", tests[i].pattern, err);
+	    return 1;
+	}
+
+	n = matches = 0;
+	start = now();
+	if (tests[i].backtrack) {
+	    do {
+		for (r = 0; r < 1000; r++) {
+		    matches += (rx_exec(rx, aline, 0, tests[i].ic) > 0);
+		}
+		n += r;
+	    } while (now() - start < 1.0);
+	} else {
+	    for (r = 0; r < ROUNDS; r++) {
+		for (j = 0; j < NLINES; j++) {
+		    matches += (rx_exec(rx, lines[j], 0, tests[i].ic) > 0);
+		}
+	    }
+	    n = ROUNDS * NLINES;
+	}
+	time = now() - start;
+	printf("%-28s %8.1f ns/line  (%ld lines, %ld matches)\n",
+	       tests[i].pattern, time * 1e9 / n, n, matches);
+    }
+    rx_del(rx);
+
+    return 0;
+}
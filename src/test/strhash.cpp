@@ -0,0 +1,167 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010-2017 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark for string hashing: the average number of probes for a
+ * successful lookup of path-like keys in chained tables of several sizes,
+ * with the old hash of the first 20 characters xor'ed with the length and
+ * with the full-width hash of the whole string, and the time per hash.
+ */
+# include "../hash.cpp"
+# include <time.h>
+
+# define NDIRS		3
+# define NFILES		20000
+# define NKEYS		(NDIRS * NFILES)
+# define KEYSZ		48
+# define ROUNDS		50
+
+/*
+ * NAME:	m_alloc()
+ * DESCRIPTION:	stand-in for the driver's memory manager
+ */
+# ifdef DEBUG
+char *m_alloc(size_t size, const char *file, int line)
+{
+    UNREFERENCED_PARAMETER(file);
+    UNREFERENCED_PARAMETER(line);
+    return (char *) malloc(size);
+}
+# else
+char *m_alloc(size_t size)
+{
+    return (char *) malloc(size);
+}
+# endif
+
+/*
+ * NAME:	m_free()
+ * DESCRIPTION:	stand-in for the driver's memory manager
+ */
+void m_free(char *mem)
+{
+    free(mem);
+}
+
+static const char *dirs[NDIRS] = {
+    "/usr/System/obj/", "/d/Domains/Forest/rooms/", "/players/wizards/home/"
+};
+
+static char keys[NKEYS][KEYSZ];
+static unsigned int lens[NKEYS];
+static Uint counts[65536];
+
+/*
+ * NAME:	prefixhash()
+ * DESCRIPTION:	the string hash formerly used for mapping indices
+ */
+static Uint prefixhash(unsigned int i)
+{
+    return Hashtab::hashstr(keys[i], 20) ^ lens[i];
+}
+
+/*
+ * NAME:	fullhash()
+ * DESCRIPTION:	the full-width hash of the whole string
+ */
+static Uint fullhash(unsigned int i)
+{
+    return Hashtab::hashfull(keys[i], lens[i]);
+}
+
+/*
+ * NAME:	probes()
+ * DESCRIPTION:	average number of probes for a successful lookup in a chained
+ *		table of the given size
+ */
+static double probes(Uint (*hash) (unsigned int), Uint size)
+{
+    unsigned int i;
+    double total;
+
+    memset(counts, '\0', size * sizeof(Uint));
+    for (i = 0; i < NKEYS; i++) {
+	counts[(*hash)(i) % size]++;
+    }
+    for (total = 0, i = 0; i < size; i++) {
+	total += (double) counts[i] * (counts[i] + 1) / 2;
+    }
+    return total / NKEYS;
+}
+
+/*
+ * NAME:	now()
+ * DESCRIPTION:	current time in seconds
+ */
+static double now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * NAME:	timehash()
+ * DESCRIPTION:	time per hash in nanoseconds
+ */
+static double timehash(Uint (*hash) (unsigned int))
+{
+    double start;
+    unsigned int i, n;
+    Uint sum;
+
+    sum = 0;
+    start = now();
+    for (n = 0; n < ROUNDS; n++) {
+	for (i = 0; i < NKEYS; i++) {
+	    sum += (*hash)(i);
+	}
+    }
+    if (sum == 1) {
+	printf(" ");	/* keep the loop */
+    }
+    return (now() - start) * 1e9 / ((double) ROUNDS * NKEYS);
+}
+
+/*
+ * NAME:	main()
+ * DESCRIPTION:	strhash
+ */
+int main()
+{
+    static Uint sizes[] = { 1024, 16384, 65536 };
+    unsigned int d, i, n;
+
+    for (n = 0, d = 0; d < NDIRS; d++) {
+	for (i = 0; i < NFILES; i++, n++) {
+	    lens[n] = snprintf(keys[n], KEYSZ, "%sroom%u", dirs[d], i);
+	}
+    }
+
+    printf("%u keys\n", NKEYS);
+    for (i = 0; i < sizeof(sizes) / sizeof(Uint); i++) {
+	printf("table %5lu: prefix20 %8.2f  full %5.2f probes/lookup\n",
+	       (unsigned long) sizes[i], probes(prefixhash, sizes[i]),
+	       probes(fullhash, sizes[i]));
+    }
+    printf("time: prefix20 %.1f  full %.1f ns/hash\n", timehash(prefixhash),
+	   timehash(fullhash));
+    return 0;
+}
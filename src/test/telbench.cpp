@@ -0,0 +1,211 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010-2017 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark for telnet input: feed large pastes, bot traffic and lines
+ * with telnet escapes to a running driver whose user object counts the
+ * lines and bytes it receives, and report the throughput.  Usage:
+ * telbench port
+ */
+# include <sys/types.h>
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <unistd.h>
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <time.h>
+
+# define IAC	"\377"
+# define NOP	"\361"
+
+struct workload {
+    const char *name;		/* name of the workload */
+    long lines;			/* number of lines */
+    int width;			/* line width */
+    bool telnet;		/* with telnet escapes */
+};
+
+static workload tests[] = {
+    { "paste", 20000, 1500, false },
+    { "bot", 200000, 20, false },
+    { "telnet", 100000, 40, true }
+};
+
+/*
+ * NAME:	now()
+ * DESCRIPTION:	current time in seconds
+ */
+static double now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * NAME:	fill()
+ * DESCRIPTION:	build the input for a workload, and compute the number of
+ *		bytes the driver should deliver for it
+ */
+static char *fill(workload *w, size_t *size, long *bytes)
+{
+    char *buf, *p;
+    long i;
+    int j;
+
+    buf = p = (char *) malloc(w->lines * (w->width + 16) + 8);
+    *bytes = 0;
+    for (i = 0; i < w->lines; i++) {
+	for (j = 0; j < w->width; j++) {
+	    *p++ = 'a' + (i + j) % 26;
+	}
+	*bytes += w->width;
+	if (w->telnet) {
+	    /* escaped IAC, a NOP, and a character erased with backspace */
+	    memcpy(p, IAC IAC IAC NOP "x\b", 6);
+	    p += 6;
+	    *bytes += 1;
+	    if (i & 1) {
+		*p++ = '\r';
+		*p++ = '\0';
+	    } else {
+		*p++ = '\r';
+		*p++ = '\n';
+	    }
+	} else {
+	    *p++ = '\r';
+	    *p++ = '\n';
+	}
+    }
+    memcpy(p, "END\r\n", 5);
+    *size = p + 5 - buf;
+    return buf;
+}
+
+/*
+ * NAME:	conn()
+ * DESCRIPTION:	connect to the driver, retrying while it starts up
+ */
+static int conn(int port)
+{
+    struct sockaddr_in sin;
+    int fd, i;
+
+    memset(&sin, '\0', sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (i = 0; i < 100; i++) {
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+	    break;
+	}
+	if (connect(fd, (struct sockaddr *) &sin, sizeof(sin)) == 0) {
+	    return fd;
+	}
+	close(fd);
+	usleep(100000);
+    }
+    perror("telbench");
+    exit(2);
+}
+
+/*
+ * NAME:	done()
+ * DESCRIPTION:	wait for the driver to report the lines and bytes received
+ */
+static bool done(int fd, long *lines, long *bytes)
+{
+    static char buf[4096];
+    static int len;
+    char *p, *q;
+    int n;
+
+    for (;;) {
+	buf[len] = '\0';
+	p = strstr(buf, "done ");
+	if (p != (char *) NULL && (q=strchr(p, '\n')) != (char *) NULL) {
+	    n = sscanf(p, "done %ld %ld", lines, bytes);
+	    len -= q + 1 - buf;
+	    memmove(buf, q + 1, len);
+	    return (n == 2);
+	}
+	if (len == sizeof(buf) - 1) {
+	    len = 0;
+	}
+	n = read(fd, buf + len, sizeof(buf) - 1 - len);
+	if (n <= 0) {
+	    return false;
+	}
+	len += n;
+    }
+}
+
+/*
+ * NAME:	main()
+ * DESCRIPTION:	telbench
+ */
+int main(int argc, char *argv[])
+{
+    workload *w;
+    char *buf;
+    size_t size, i;
+    long bytes, rlines, rbytes;
+    double start, t;
+    int fd, status;
+    ssize_t n;
+
+    if (argc != 2) {
+	fprintf(stderr, "usage: %s port\n", argv[0]);
+	return 2;
+    }
+    fd = conn(atoi(argv[1]));
+
+    status = 0;
+    for (w = tests; w < tests + sizeof(tests) / sizeof(workload); w++) {
+	buf = fill(w, &size, &bytes);
+	start = now();
+	for (i = 0; i < size; i += n) {
+	    n = write(fd, buf + i, size - i);
+	    if (n <= 0) {
+		perror("telbench");
+		return 2;
+	    }
+	}
+	if (!done(fd, &rlines, &rbytes)) {
+	    fprintf(stderr, "telbench: no reply\n");
+	    return 2;
+	}
+	t = now() - start;
+	free(buf);
+
+	printf("%-6s %7ld lines %10ld bytes %8.1f ms %8.1f MB/s\n", w->name,
+	       rlines, rbytes, t * 1e3, size / t / 1e6);
+	if (rlines != w->lines || rbytes != bytes) {
+	    printf("%-6s expected %ld lines %ld bytes\n", w->name, w->lines,
+		   bytes);
+	    status = 1;
+	}
+    }
+    close(fd);
+    return status;
+}
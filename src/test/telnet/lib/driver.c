@@ -0,0 +1,30 @@
+/*
+ * driver object for the telnet input benchmark
+ */
+
+static void initialize()
+{
+    compile_object("/user");
+}
+
+static object telnet_connect(int port)
+{
+    return clone_object(find_object("/user"));
+}
+
+string include_file(string from, string path)
+{
+    return (path[0] == '/') ? path : "/include/" + path;
+}
+
+static void compile_error(string file, int line, string err)
+{
+    send_message(file + ", " + line + ": " + err + "\n");
+}
+
+static void runtime_error(string err, int caught, int ticks)
+{
+    if (!caught) {
+	send_message("error: " + err + "\n");
+    }
+}
@@ -0,0 +1,27 @@
+/*
+ * Count the lines and bytes received, and report them when the client
+ * sends END.
+ */
+
+int lines, bytes;
+
+static int open()
+{
+    return 0;
+}
+
+static void close(int dest)
+{
+}
+
+static int receive_message(string str)
+{
+    if (str == "END") {
+	send_message("done " + lines + " " + bytes + "\n");
+	lines = bytes = 0;
+    } else {
+	lines++;
+	bytes += strlen(str);
+    }
+    return 0;
+}